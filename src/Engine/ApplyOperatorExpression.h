@@ -395,12 +395,24 @@ public:
 
 	void wftAll(SizeType site)
 	{
-		for (SizeType index = 0; index < targetVectors_.size(); ++index) {
+		SizeType n = targetVectors_.size();
+		VectorVectorWithOffsetType phiNew(n);
+		for (SizeType index = 0; index < n; ++index) {
 			const VectorWithOffsetType& src = targetVectors_[index];
 			if (src.size() == 0) continue;
-			VectorWithOffsetType phiNew;
-			wftOneVector(phiNew,src,site);
-			targetVectors_[index] = phiNew;
+			phiNew[index].populateFromQns(src, targetHelper_.lrs().super());
+		}
+
+		// all vectors in one pass, so that the WFT can share work among them
+		VectorSizeType nk(1,targetHelper_.model().hilbertSize(site));
+		targetHelper_.wft().setInitialVectors(phiNew,
+		                                      targetVectors_,
+		                                      targetHelper_.lrs(),
+		                                      nk);
+
+		for (SizeType index = 0; index < n; ++index) {
+			if (targetVectors_[index].size() == 0) continue;
+			targetVectors_[index] = phiNew[index];
 		}
 	}
 
@@ -158,7 +158,7 @@ public:
 		SizeType final = offset + src.effectiveSize(i0);
 		SizeType ns = lrs_.left().permutationVector().size();
 		SizeType nx = ns/A.data.rows();
-		if (src.size()!=lrs_.super().permutationVector().size())
+		if (src.size()!=lrs_.super().size())
 			throw PsimagLite::RuntimeError("applyLocalOpSystem SE\n");
 
 		PackIndicesType pack1(ns);
@@ -219,7 +219,7 @@ private:
 		//SizeType counter=0;
 		SizeType ns = lrs_.left().permutationVector().size();
 		SizeType nx = ns/A.data.rows();
-		if (src.size()!=lrs_.super().permutationVector().size())
+		if (src.size()!=lrs_.super().size())
 			throw PsimagLite::RuntimeError("applyLocalOpSystem SE\n");
 
 		PackIndicesType pack1(ns);
@@ -327,7 +327,7 @@ private:
 		SizeType offset = src.offset(i0);
 		SizeType final = offset + src.effectiveSize(i0);
 		SizeType ns = lrs_.left().permutationVector().size();
-		if (src.size()!=lrs_.super().permutationVector().size())
+		if (src.size()!=lrs_.super().size())
 			throw PsimagLite::RuntimeError("applyLocalOpSystem SE\n");
 
 		PackIndicesType pack(ns);
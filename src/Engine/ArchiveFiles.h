@@ -228,6 +228,7 @@ private:
 		files.push_back(utils::pathPrepend(ProgramGlobals::SYSTEM_STACK_STRING,rootname));
 		files.push_back(utils::pathPrepend(ProgramGlobals::ENVIRON_STACK_STRING,rootname));
 		files.push_back(utils::pathPrepend(ProgramGlobals::WFT_STRING,rootname));
+		files.push_back(utils::pathPrepend(ProgramGlobals::OBSERVE_DATA_STRING,rootname));
 	}
 
 	static VectorStringType filesToDelete_;
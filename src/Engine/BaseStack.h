@@ -13,13 +13,13 @@ class BaseStack {
 
 public:
 
-	BaseStack(bool disk)
+	BaseStack(bool disk, bool binary = false, bool compressed = false)
 	    : m_(!disk), diskStack_(0)
 	{
 		if (m_) return;
 		PsimagLite::String tmpfname = tmpFname();
 		files_.push_back(tmpfname);
-		diskStack_ = new DiskStackType(tmpfname, tmpfname, false, false);
+		diskStack_ = new DiskStackType(tmpfname, tmpfname, false, false, binary, compressed);
 	}
 
 	BaseStack(const BaseStack& other)
@@ -73,6 +73,20 @@ public:
 
 	bool inDisk() const { return !m_; }
 
+	void setAsync(SizeType depth, SizeType budget)
+	{
+		if (m_) return;
+		check();
+		diskStack_->setAsync(depth, budget);
+	}
+
+	void takeStats(DiskStackCompression::Stats& stats) const
+	{
+		if (m_) return;
+		check();
+		diskStack_->takeStats(stats);
+	}
+
 	void save(PsimagLite::IoSimple::Out& io, PsimagLite::String label) const
 	{
 		if (m_) {
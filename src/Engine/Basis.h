@@ -80,11 +80,18 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
  */
 #ifndef BASIS_HEADER_H
 #define BASIS_HEADER_H
+#include <algorithm>
 #include "Utils.h"
 #include "Sort.h" // in PsimagLite
 #include "HamiltonianSymmetryLocal.h"
 #include "HamiltonianSymmetrySu2.h"
 #include "ProgressIndicator.h"
+#include "Concurrency.h"
+#ifdef USE_PTHREADS
+#include "PthreadsNg.h"
+#else
+#include "NoPthreadsNg.h"
+#endif
 
 namespace Dmrg {
 // A class to represent in a light way a Dmrg basis (used only to implement symmetries).
@@ -112,9 +119,11 @@ public:
 
 	enum {SAVE_ALL, SAVE_PARTIAL};
 
+	enum {LAZY_MIN_STATES = 1 << 18};
+
 	//! Constructor, s=name of this basis
 	Basis(const PsimagLite::String& s)
-	    : dmrgTransformed_(false), name_(s), progress_(s)
+	    : dmrgTransformed_(false), lazy_(false), lazyBucketShift_(0), name_(s), progress_(s)
 	{
 		symmLocal_.createDummyFactors(1,1);
 	}
@@ -126,7 +135,7 @@ public:
 	      SizeType counter=0,
 	      bool = false,
 	      bool minimizeRead = false)
-	    : dmrgTransformed_(false), name_(ss), progress_(ss)
+	    : dmrgTransformed_(false), lazy_(false), lazyBucketShift_(0), name_(ss), progress_(ss)
 	{
 		io.advance("#NAME="+ss,counter);
 		loadInternal(io, minimizeRead);
@@ -181,6 +190,7 @@ public:
 	{
 		block_.clear();
 		utils::blockUnion(block_,su2Symmetry2.block_,su2Symmetry3.block_);
+		clearLazy();
 
 		if (useSu2Symmetry_) {
 			std::cout<<"Basis: SU(2) Symmetry is in use\n";
@@ -199,15 +209,12 @@ public:
 			quantumNumbers_.clear();
 			electrons_.clear();
 
-			unsigned long int check = ns*ne;
-			unsigned int shift = 8*sizeof(SizeType)-1;
-			unsigned long int max = 1;
-			max <<= shift;
-			if (check >= max) {
-				PsimagLite::String msg("Basis::setToProduct: Basis too large. ");
-				msg += "Current= "+ ttos(check) + " max " + ttos(max) + " ";
-				msg += "Please recompile with -DUSE_LONG\n";
-				throw PsimagLite::RuntimeError(msg);
+			checkProductSize(ns, ne);
+			symmLocal_.createDummyFactors(ns,ne);
+
+			if (setToProductBySectors(su2Symmetry2, su2Symmetry3)) {
+				materialize();
+				return;
 			}
 
 			for (SizeType j=0;j<ne;j++) for (SizeType i=0;i<ns;i++) {
@@ -216,8 +223,6 @@ public:
 				electrons_.push_back(su2Symmetry2.electrons(i)+
 				                     su2Symmetry3.electrons(j));
 			}
-
-			symmLocal_.createDummyFactors(ns,ne);
 		}
 		// order quantum numbers of combined basis:
 		findPermutationAndPartition();
@@ -226,9 +231,48 @@ public:
 		electronsOld_ = electrons_;
 	}
 
+	//! Sets this basis to the outer product of su2Symmetry2 and su2Symmetry3
+	//! keeping only the sector tables (see PSIDOC BasisLazyProduct):
+	//! permutations, quantum numbers and electrons are computed on demand,
+	//! and permutationVector(), permutationInverse() and electronsVector()
+	//! cannot be used. Falls back to setToProduct if this is not possible,
+	//! and materializes the product if it has fewer than LAZY_MIN_STATES states
+	void setToProductLazy(const ThisType& su2Symmetry2,
+	                      const ThisType& su2Symmetry3,
+	                      int pseudoQn = -1)
+	{
+		if (useSu2Symmetry_)
+			return setToProduct(su2Symmetry2, su2Symmetry3, pseudoQn);
+
+		SizeType ns = su2Symmetry2.size();
+		SizeType ne = su2Symmetry3.size();
+		checkProductSize(ns, ne);
+
+		clearLazy();
+		if (!setToProductBySectors(su2Symmetry2, su2Symmetry3))
+			return setToProduct(su2Symmetry2, su2Symmetry3, pseudoQn);
+
+		block_.clear();
+		utils::blockUnion(block_,su2Symmetry2.block_,su2Symmetry3.block_);
+		symmLocal_.createDummyFactors(ns,ne);
+		if (ns*ne < LAZY_MIN_STATES) {
+			materialize();
+			return;
+		}
+
+		buildLazyIndex();
+		quantumNumbers_.clear();
+		electrons_.clear();
+		electronsOld_.clear();
+		permutationVector_.clear();
+		permInverse_.clear();
+		lazy_ = true;
+	}
+
 	//! returns the effective quantum number of basis state i
 	int qn(SizeType i) const
 	{
+		if (lazy_) return lazyQns_[lazySector(i)];
 		assert(i < quantumNumbers_.size());
 		return quantumNumbers_[i];
 	}
@@ -239,6 +283,12 @@ public:
 		const VectorSizeType* quantumNumbers = &quantumNumbers_;
 		const VectorSizeType* partition = &partition_;
 
+		if (lazy_) {
+			for (SizeType i=0;i<lazyQns_.size();i++)
+				if (lazyQns_[i]==qn) return i;
+			return -1;
+		}
+
 		for (SizeType i=0;i<partition->size();i++) {
 			SizeType state = (*partition)[i];
 			assert(state < quantumNumbers->size());
@@ -260,6 +310,7 @@ public:
 	//! returns the permutation of i
 	SizeType permutation(SizeType i) const
 	{
+		if (lazy_) return lazyPermutation(i);
 		assert(i<permutationVector_.size());
 		return  permutationVector_[i];
 	}
@@ -267,12 +318,14 @@ public:
 	//! Return the permutation vector
 	const VectorSizeType& permutationVector() const
 	{
+		if (lazy_) throwIfLazy("permutationVector()");
 		return  permutationVector_;
 	}
 
 	//! returns the inverse permutation of i
 	int permutationInverse(SizeType i) const
 	{
+		if (lazy_) return lazyPermutationInverse(i);
 		assert(i<permInverse_.size());
 		return permInverse_[i];
 	}
@@ -280,6 +333,7 @@ public:
 	//! returns the inverse permutation vector
 	const VectorSizeType& permutationInverse() const
 	{
+		if (lazy_) throwIfLazy("permutationInverse()");
 		return permInverse_;
 	}
 
@@ -320,8 +374,7 @@ public:
 			return SymmetryElectronsSzType::pseudoEffectiveNumber(electrons_[i],
 			                                                      symmSu2_.jmValue(i).first);
 		} else {
-			assert(i < quantumNumbers_.size());
-			return quantumNumbers_[i];
+			return qn(i);
 		}
 	}
 
@@ -334,6 +387,7 @@ public:
 	                 SizeType kept,
 	                 const SolverParametersType& solverParams)
 	{
+		assert(!lazy_);
 		removedIndices.clear();
 		if (useSu2Symmetry_)
 			symmSu2_.calcRemovedIndices(removedIndices,eigs,kept,solverParams);
@@ -400,6 +454,12 @@ public:
 	//! returns the number of electrons for state i of this basis
 	SizeType electrons(SizeType i) const
 	{
+		if (lazy_) {
+			SizeType k = lazyPermutation(i);
+			SizeType ns = lazyPartition2_[lazyPartition2_.size() - 1];
+			return lazyElectrons(k % ns, true) + lazyElectrons(k/ns, false);
+		}
+
 		assert(i < electrons_.size() || electrons_.size() == 0);
 		return (i < electrons_.size()) ? electrons_[i] : 0;
 	}
@@ -438,6 +498,7 @@ public:
 	//! Returns the vector of electrons for this basis
 	const VectorSizeType& electronsVector(WhenTransformEnum beforeOrAfterTransform) const
 	{
+		if (lazy_) throwIfLazy("electronsVector()");
 		return (beforeOrAfterTransform == AFTER_TRANSFORM) ? electrons_ :
 		                                                     electronsOld_;
 	}
@@ -445,6 +506,7 @@ public:
 	//! Returns the fermionic sign for state i
 	int fermionicSign(SizeType i,int f) const
 	{
+		if (lazy_) return (electrons(i) & 1) ? f : 1;
 		assert(i < electrons_.size());
 		return (electrons_[i] & 1) ? f : 1;
 	}
@@ -462,6 +524,9 @@ public:
 	//! Tells this basis to use SU(2) symmetry or not
 	static void useSu2Symmetry(bool flag)  { useSu2Symmetry_=flag; }
 
+	//! Returns true if this basis only stores its sector tables
+	bool isLazy() const { return lazy_; }
+
 	//! Returns true if this basis has been DMRG transformed, or false if it hasn't
 	bool dmrgTransformed() const { return dmrgTransformed_; }
 
@@ -509,7 +574,11 @@ public:
 	          PsimagLite::IsOutputLike<IoOutputter>::True, int>::Type = 0) const
 	{
 		io.printline("#NAME="+ss);
-		saveInternal(io, minimizeWrite);
+		if (!lazy_) return saveInternal(io, minimizeWrite);
+
+		ThisType full(*this);
+		full.materialize();
+		full.saveInternal(io, minimizeWrite);
 	}
 
 	//! saves this basis to disk
@@ -519,8 +588,11 @@ public:
 	          PsimagLite::IsOutputLike<IoOutputter>::True, int>::Type = 0) const
 	{
 		io.printline("#NAME="+name_);
-		saveInternal(io, minimizeWrite);
+		if (!lazy_) return saveInternal(io, minimizeWrite);
 
+		ThisType full(*this);
+		full.materialize();
+		full.saveInternal(io, minimizeWrite);
 	}
 
 	//! The operator<< is a friend
@@ -557,6 +629,7 @@ private:
 	                  PsimagLite::IsInputLike<IoInputter>::True, int>::Type = 0)
 	{
 		int x=0;
+		clearLazy();
 		useSu2Symmetry_=false;
 		io.readline(x,"#useSu2Symmetry=");
 		if (x>0) useSu2Symmetry_=true;
@@ -658,6 +731,313 @@ private:
 		if (useSu2Symmetry_) symmSu2_.truncate(removedIndices,electrons_);
 	}
 
+	// Places the states of one product sector: for each sector of the
+	// right factor, in order, the only sector of the left factor that
+	// completes the quantum number is copied in, so within the product
+	// sector states follow i + j*ns
+	class ParallelProductFill {
+
+	public:
+
+		ParallelProductFill(ThisType& product)
+		    : product_(product)
+		{}
+
+		SizeType tasks() const { return product_.lazyQns_.size(); }
+
+		void doTask(SizeType r, SizeType)
+		{
+			const VectorSizeType& p2 = product_.lazyPartition2_;
+			const VectorSizeType& p3 = product_.lazyPartition3_;
+			SizeType ns = p2[p2.size() - 1];
+			SizeType n3 = p3.size() - 1;
+			SizeType pos = product_.partition_[r];
+			for (SizeType b = 0; b < n3; ++b) {
+				int a = product_.lazySector2_[b + r*n3];
+				if (a < 0) continue;
+				assert(pos == product_.lazyPairOffset_[b + r*n3]);
+				for (SizeType j = p3[b]; j < p3[b + 1]; ++j) {
+					SizeType e3 = product_.lazyElectrons(j, false);
+					for (SizeType i = p2[a]; i < p2[a + 1]; ++i) {
+						SizeType k = i + j*ns;
+						product_.permutationVector_[pos] = k;
+						product_.permInverse_[k] = pos;
+						product_.quantumNumbers_[pos] = product_.lazyQns_[r];
+						product_.electrons_[pos] =
+						        product_.lazyElectrons(i, true) + e3;
+						++pos;
+					}
+				}
+			}
+
+			assert(pos == product_.partition_[r + 1]);
+		}
+
+	private:
+
+		ThisType& product_;
+	}; // class ParallelProductFill
+
+	void throwIfLazy(PsimagLite::String what) const
+	{
+		throw PsimagLite::RuntimeError("Basis::" + what + " not available for " +
+		                               name_ + ", which is lazy; use the per-state "
+		                               "functions instead\n");
+	}
+
+	void checkProductSize(SizeType ns, SizeType ne) const
+	{
+		unsigned long int check = ns*ne;
+		unsigned int shift = 8*sizeof(SizeType)-1;
+		unsigned long int max = 1;
+		max <<= shift;
+		if (check < max) return;
+
+		PsimagLite::String msg("Basis::setToProduct: Basis too large. ");
+		msg += "Current= "+ ttos(check) + " max " + ttos(max) + " ";
+		msg += "Please recompile with -DUSE_LONG\n";
+		throw PsimagLite::RuntimeError(msg);
+	}
+
+	// True if each partition of this basis has its own quantum number
+	// and partitions come in increasing quantum number
+	bool sectorsAreSorted() const
+	{
+		SizeType n = partition_.size();
+		if (lazy_ || n < 2 || quantumNumbers_.size() != partition_[n - 1])
+			return false;
+		for (SizeType a = 0; a + 1 < n; ++a) {
+			if (partition_[a] >= partition_[a + 1]) return false;
+			if (a > 0 && quantumNumbers_[partition_[a]] <=
+			        quantumNumbers_[partition_[a - 1]]) return false;
+		}
+
+		return true;
+	}
+
+	/* PSIDOC BasisLazyProduct
+		The product basis is sorted by a counting sort over its quantum numbers.
+		If the left basis has sectors $a$ and the right basis sectors $b$, all
+		states $i+j n_s$ with $i\in a$ and $j\in b$ share one quantum number,
+		and land in one contiguous run of the product basis.
+		The run of each pair $(a, b)$ starts at
+		\verb!lazyPairOffset[b + r*nb]!, where $r$ is the product sector,
+		and inside the run states keep the order $i+j n_s$, so the permutation
+		is the stable one. These tables, the partitions of both factors and their
+		electrons are all that \cppFunction{setToProductLazy} stores;
+		\cppFunction{permutation}, \cppFunction{permutationInverse},
+		\cppFunction{qn} and \cppFunction{electrons} are then computed on demand.
+		*/
+	// Returns false, leaving this basis untouched, if basis2 or basis3
+	// are not partitioned by increasing quantum number
+	bool setToProductBySectors(const ThisType& basis2, const ThisType& basis3)
+	{
+		if (!basis2.sectorsAreSorted() || !basis3.sectorsAreSorted())
+			return false;
+
+		lazyPartition2_ = basis2.partition_;
+		lazyPartition3_ = basis3.partition_;
+		lazyElectrons2_ = basis2.electrons_;
+		lazyElectrons3_ = basis3.electrons_;
+
+		SizeType n2 = basis2.partition_.size() - 1;
+		SizeType n3 = basis3.partition_.size() - 1;
+
+		VectorSizeType pairQns(n2*n3);
+		for (SizeType b = 0; b < n3; ++b) {
+			SizeType q3 = basis3.quantumNumbers_[basis3.partition_[b]];
+			for (SizeType a = 0; a < n2; ++a)
+				pairQns[a + b*n2] = basis2.quantumNumbers_[basis2.partition_[a]] + q3;
+		}
+
+		lazyQns_ = pairQns;
+		std::sort(lazyQns_.begin(), lazyQns_.end());
+		lazyQns_.erase(std::unique(lazyQns_.begin(), lazyQns_.end()), lazyQns_.end());
+
+		SizeType nq = lazyQns_.size();
+		lazySector2_.resize(n3*nq);
+		std::fill(lazySector2_.begin(), lazySector2_.end(), -1);
+		lazySectorOfPair_.resize(n2*n3);
+		for (SizeType b = 0; b < n3; ++b) {
+			for (SizeType a = 0; a < n2; ++a) {
+				SizeType r = std::lower_bound(lazyQns_.begin(),
+				                              lazyQns_.end(),
+				                              pairQns[a + b*n2]) - lazyQns_.begin();
+				assert(r < nq && lazySector2_[b + r*n3] < 0);
+				lazySector2_[b + r*n3] = a;
+				lazySectorOfPair_[a + b*n2] = r;
+			}
+		}
+
+		partition_.resize(nq + 1);
+		lazyPairOffset_.resize(n3*nq);
+		SizeType offset = 0;
+		for (SizeType r = 0; r < nq; ++r) {
+			partition_[r] = offset;
+			for (SizeType b = 0; b < n3; ++b) {
+				lazyPairOffset_[b + r*n3] = offset;
+				int a = lazySector2_[b + r*n3];
+				if (a < 0) continue;
+				offset += (lazyPartition2_[a + 1] - lazyPartition2_[a])*
+				        (lazyPartition3_[b + 1] - lazyPartition3_[b]);
+			}
+		}
+
+		partition_[nq] = offset;
+		assert(offset == basis2.size()*basis3.size());
+		return true;
+	}
+
+	// Tables for the per-state queries of a lazy product: the sector of each
+	// state of both factors, and the runs of (a, b) pairs in product order,
+	// indexed by buckets of 2^lazyBucketShift_ states, each pointing to the
+	// run holding its first state, so that a lookup scans O(1) runs on average
+	void buildLazyIndex()
+	{
+		fillSectorOfState(lazySectorOf2_, lazyPartition2_);
+		fillSectorOfState(lazySectorOf3_, lazyPartition3_);
+
+		SizeType n3 = lazyPartition3_.size() - 1;
+		SizeType nq = lazyQns_.size();
+		lazyRunStart_.clear();
+		lazyRunSector_.clear();
+		lazyRunB_.clear();
+		for (SizeType r = 0; r < nq; ++r) {
+			for (SizeType b = 0; b < n3; ++b) {
+				int a = lazySector2_[b + r*n3];
+				if (a < 0) continue;
+				SizeType size = (lazyPartition2_[a + 1] - lazyPartition2_[a])*
+				        (lazyPartition3_[b + 1] - lazyPartition3_[b]);
+				if (size == 0) continue;
+				lazyRunStart_.push_back(lazyPairOffset_[b + r*n3]);
+				lazyRunSector_.push_back(r);
+				lazyRunB_.push_back(b);
+			}
+		}
+
+		SizeType total = partition_[partition_.size() - 1];
+		SizeType runs = lazyRunSector_.size();
+		lazyRunStart_.push_back(total);
+
+		lazyBucketShift_ = 0;
+		while ((total >> (lazyBucketShift_ + 1)) >= runs) ++lazyBucketShift_;
+
+		SizeType buckets = (total >> lazyBucketShift_) + 1;
+		lazyRunOfBucket_.resize(buckets);
+		SizeType x = 0;
+		for (SizeType k = 0; k < buckets; ++k) {
+			SizeType pos = (k << lazyBucketShift_);
+			while (x + 1 < runs && lazyRunStart_[x + 1] <= pos) ++x;
+			lazyRunOfBucket_[k] = x;
+		}
+	}
+
+	static void fillSectorOfState(VectorSizeType& sectorOf,
+	                              const VectorSizeType& partition)
+	{
+		SizeType n = partition.size() - 1;
+		sectorOf.resize(partition[n]);
+		for (SizeType a = 0; a < n; ++a)
+			for (SizeType i = partition[a]; i < partition[a + 1]; ++i)
+				sectorOf[i] = a;
+	}
+
+	// run of state pos of a lazy product basis
+	SizeType lazyRun(SizeType pos) const
+	{
+		assert(pos < lazyRunStart_[lazyRunStart_.size() - 1]);
+		SizeType x = lazyRunOfBucket_[pos >> lazyBucketShift_];
+		while (lazyRunStart_[x + 1] <= pos) ++x;
+		return x;
+	}
+
+	// Fills permutation vectors, quantum numbers and electrons from the
+	// sector tables of setToProductBySectors, and drops the tables
+	void materialize()
+	{
+		SizeType total = partition_[partition_.size() - 1];
+		quantumNumbers_.resize(total);
+		electrons_.resize(total);
+		permutationVector_.resize(total);
+		permInverse_.resize(total);
+
+		SizeType threads = std::min(lazyQns_.size(), PsimagLite::Concurrency::npthreads);
+		// every rank needs the whole basis, so only threads share the fill
+#ifdef USE_PTHREADS
+		typedef PsimagLite::PthreadsNg<ParallelProductFill> ThreadsOnlyType;
+#else
+		typedef PsimagLite::NoPthreadsNg<ParallelProductFill> ThreadsOnlyType;
+#endif
+		ThreadsOnlyType threadedFill(threads,0,false);
+
+		ParallelProductFill helperFill(*this);
+
+		threadedFill.loopCreate(helperFill);
+
+		electronsOld_ = electrons_;
+		clearLazy();
+	}
+
+	void clearLazy()
+	{
+		lazy_ = false;
+		lazyPartition2_.clear();
+		lazyPartition3_.clear();
+		lazyElectrons2_.clear();
+		lazyElectrons3_.clear();
+		lazyQns_.clear();
+		lazyPairOffset_.clear();
+		lazySector2_.clear();
+		lazySectorOfPair_.clear();
+		lazySectorOf2_.clear();
+		lazySectorOf3_.clear();
+		lazyRunStart_.clear();
+		lazyRunSector_.clear();
+		lazyRunB_.clear();
+		lazyRunOfBucket_.clear();
+		lazyBucketShift_ = 0;
+	}
+
+	// sector of state i of a lazy product basis
+	SizeType lazySector(SizeType i) const
+	{
+		return lazyRunSector_[lazyRun(i)];
+	}
+
+	SizeType lazyPermutation(SizeType pos) const
+	{
+		SizeType x = lazyRun(pos);
+		SizeType r = lazyRunSector_[x];
+		SizeType b = lazyRunB_[x];
+		int a = lazySector2_[b + r*(lazyPartition3_.size() - 1)];
+		assert(a >= 0);
+		SizeType t = pos - lazyRunStart_[x];
+		SizeType size2 = lazyPartition2_[a + 1] - lazyPartition2_[a];
+		SizeType i = lazyPartition2_[a] + (t % size2);
+		SizeType j = lazyPartition3_[b] + t/size2;
+		return i + j*lazyPartition2_[lazyPartition2_.size() - 1];
+	}
+
+	SizeType lazyPermutationInverse(SizeType k) const
+	{
+		SizeType ns = lazyPartition2_[lazyPartition2_.size() - 1];
+		SizeType i = k % ns;
+		SizeType j = k/ns;
+		SizeType a = lazySectorOf2_[i];
+		SizeType b = lazySectorOf3_[j];
+		SizeType r = lazySectorOfPair_[a + b*(lazyPartition2_.size() - 1)];
+		SizeType size2 = lazyPartition2_[a + 1] - lazyPartition2_[a];
+		return lazyPairOffset_[b + r*(lazyPartition3_.size() - 1)] +
+		        (i - lazyPartition2_[a]) + (j - lazyPartition3_[b])*size2;
+	}
+
+	// electrons of state i of the left (or right) factor of a lazy product
+	SizeType lazyElectrons(SizeType i, bool leftFactor) const
+	{
+		const CvectorSizeType& e = (leftFactor) ? lazyElectrons2_ : lazyElectrons3_;
+		return (i < e.size()) ? e[i] : 0;
+	}
+
 	void reorder()
 	{
 		utils::reorder(electrons_,permutationVector_);
@@ -753,6 +1133,22 @@ these numbers are
 		*/
 	BlockType block_;
 	bool dmrgTransformed_;
+	bool lazy_;
+	VectorSizeType lazyPartition2_;
+	VectorSizeType lazyPartition3_;
+	CvectorSizeType lazyElectrons2_;
+	CvectorSizeType lazyElectrons3_;
+	VectorSizeType lazyQns_;
+	VectorSizeType lazyPairOffset_;
+	typename PsimagLite::Vector<int>::Type lazySector2_;
+	VectorSizeType lazySectorOfPair_;
+	VectorSizeType lazySectorOf2_;
+	VectorSizeType lazySectorOf3_;
+	VectorSizeType lazyRunStart_;
+	VectorSizeType lazyRunSector_;
+	VectorSizeType lazyRunB_;
+	VectorSizeType lazyRunOfBucket_;
+	SizeType lazyBucketShift_;
 	PsimagLite::String name_;
 	PsimagLite::ProgressIndicator progress_;
 	static bool useSu2Symmetry_;
@@ -124,6 +124,7 @@ public:
 	typedef typename BaseType::RealType RealType;
 	typedef OperatorsType_ OperatorsType;
 	typedef typename OperatorsType::PairSizeSizeType PairSizeSizeType;
+	typedef typename OperatorsType::VectorBoolType VectorBoolType;
 	typedef typename OperatorsType::OperatorType OperatorType;
 	typedef typename OperatorsType::BasisType BasisType;
 	typedef typename BasisType::BlockType BlockType;
@@ -161,93 +162,42 @@ public:
 
 	// set this basis to the outer product of
 	// basis2 and basis3 or basis3 and basis2  depending on dir
+	template<typename SomeParametersType>
 	void setToProduct(const ThisType& basis2,
 	                  const ThisType& basis3,
-	                  ProgramGlobals::DirectionEnum dir)
+	                  ProgramGlobals::DirectionEnum dir,
+	                  const SomeParametersType& params)
 	{
 		if (dir == ProgramGlobals::EXPAND_SYSTEM)
-			setToProduct(basis2,basis3);
+			setToProduct(basis2,basis3,params);
 		else
-			setToProduct(basis3,basis2);
+			setToProduct(basis3,basis2,params);
 	}
 
 	//! set this basis to the outer product of   basis2 and basis3
 	//!PTEX_LABEL{setToProductOps}
-	void setToProduct(const ThisType& basis2,const ThisType& basis3)
+	template<typename SomeParametersType>
+	void setToProduct(const ThisType& basis2,
+	                  const ThisType& basis3,
+	                  const SomeParametersType& params)
 	{
 		BasisType &parent = *this;
 		// reorder the basis
 		parent.setToProduct(basis2,basis3);
 
-		typename PsimagLite::Vector<RealType>::Type fermionicSigns;
 		SizeType x = basis2.numberOfOperators()+basis3.numberOfOperators();
 
 		if (this->useSu2Symmetry()) setMomentumOfOperators(basis2);
 		operators_.setToProduct(basis2,basis3,x,this);
-		ApplyFactors<FactorsType> apply(this->getFactors(),this->useSu2Symmetry());
-		int savedSign = 0;
-
-		for (SizeType i=0;i<this->numberOfOperators();i++) {
-			if (i<basis2.numberOfOperators()) {
-				if (!this->useSu2Symmetry()) {
-					const OperatorType& myOp =  basis2.getOperatorByIndex(i);
-					if (savedSign != myOp.fermionSign) {
-						utils::fillFermionicSigns(fermionicSigns,
-						                          basis2.electronsVector(BaseType::AFTER_TRANSFORM),
-						                          myOp.fermionSign);
-						savedSign = myOp.fermionSign;
-					}
-					operators_.externalProduct(i,
-					                           myOp,
-					                           basis3.size(),
-					                           fermionicSigns,
-					                           true,
-					                           apply);
-				} else {
-					operators_.externalProductReduced(i,
-					                                  basis2,
-					                                  basis3,
-					                                  true,
-					                                  basis2.getReducedOperatorByIndex(i));
-				}
-			} else {
-				if (!this->useSu2Symmetry()) {
-					const OperatorType& myOp = basis3.
-					        getOperatorByIndex(i - basis2.numberOfOperators());
-
-					if (savedSign != myOp.fermionSign) {
-						utils::fillFermionicSigns(fermionicSigns,
-						                          basis2.electronsVector(BaseType::AFTER_TRANSFORM),
-						                          myOp.fermionSign);
-						savedSign = myOp.fermionSign;
-					}
-					operators_.externalProduct(i,
-					                           myOp,
-					                           basis2.size(),
-					                           fermionicSigns,
-					                           false,
-					                           apply);
-				} else {
-					operators_.externalProductReduced(i,
-					                                  basis2,
-					                                  basis3,
-					                                  false,
-					                                  basis3.getReducedOperatorByIndex(
-					                                      i-basis2.numberOfOperators()));
-				}
-			}
-		}
-
-		//! Calc. hamiltonian
-		operators_.outerProductHamiltonian(basis2.hamiltonian(),
-		                                   basis3.hamiltonian(),
-		                                   apply);
-		operators_.outerProductHamiltonianReduced(basis2,
-		                                          basis3,
-		                                          basis2.reducedHamiltonian(),
-		                                          basis3.reducedHamiltonian());
-		//! re-order operators and hamiltonian
-		operators_.reorder(this->permutationVector());
+		if (!this->useSu2Symmetry())
+			operators_.externalProductPermuted(basis2.operators_,
+			                                   basis3.operators_,
+			                                   basis2,
+			                                   basis3,
+			                                   *this,
+			                                   params);
+		else
+			externalProductOneByOne(basis2, basis3);
 
 		SizeType offset1 = basis2.operatorsPerSite_.size();
 		operatorsPerSite_.resize(offset1+basis3.operatorsPerSite_.size());
@@ -260,15 +210,18 @@ public:
 
 	//! transform this basis by transform
 	//! note: basis change must conserve total number of electrons and all quantum numbers
+	template<typename SomeParametersType>
 	RealType truncateBasis(const BlockDiagonalMatrixType& ftransform,
 	                       const typename PsimagLite::Vector<RealType>::Type& eigs,
 	                       const typename PsimagLite::Vector<SizeType>::Type& removedIndices,
-	                       const PairSizeSizeType& startEnd)
+	                       const VectorBoolType& keep,
+	                       const SomeParametersType& params)
 	{
 		BasisType &parent = *this;
 		RealType error = parent.truncateBasis(eigs,removedIndices);
 
-		operators_.changeBasis(ftransform,this,startEnd);
+		// operators not kept are removed, see Operators::isRemoved
+		operators_.changeBasis(ftransform,this,keep,params);
 
 		return error;
 	}
@@ -333,6 +286,8 @@ public:
 
 	SizeType numberOfOperators() const { return operators_.numberOfOperators(); }
 
+	bool isOperatorRemoved(SizeType i) const { return operators_.isRemoved(i); }
+
 	SizeType operatorsPerSite(SizeType i) const
 	{
 		assert(i < operatorsPerSite_.size());
@@ -390,6 +345,44 @@ private:
 		}
 		operators_.setMomentumOfOperators(momentum);
 	}
+
+	// Expands operators one at a time, then reorders them and the
+	// Hamiltonian to the order of this basis. Used only for SU(2); without
+	// it Operators::externalProductPermuted is used
+	void externalProductOneByOne(const ThisType& basis2,const ThisType& basis3)
+	{
+		assert(this->useSu2Symmetry());
+		ApplyFactors<FactorsType> apply(this->getFactors(),this->useSu2Symmetry());
+
+		for (SizeType i=0;i<this->numberOfOperators();i++) {
+			bool isLeft = (i<basis2.numberOfOperators());
+			if (isLeft) {
+				operators_.externalProductReduced(i,
+				                                  basis2,
+				                                  basis3,
+				                                  true,
+				                                  basis2.getReducedOperatorByIndex(i));
+			} else {
+				operators_.externalProductReduced(i,
+				                                  basis2,
+				                                  basis3,
+				                                  false,
+				                                  basis3.getReducedOperatorByIndex(
+				                                      i-basis2.numberOfOperators()));
+			}
+		}
+
+		//! Calc. hamiltonian
+		operators_.outerProductHamiltonian(basis2.hamiltonian(),
+		                                   basis3.hamiltonian(),
+		                                   apply);
+		operators_.outerProductHamiltonianReduced(basis2,
+		                                          basis3,
+		                                          basis2.reducedHamiltonian(),
+		                                          basis3.reducedHamiltonian());
+		//! re-order operators and hamiltonian
+		operators_.reorder(this->permutationVector());
+	}
 }; // class BasisWithOperators
 
 template<typename OperatorsType>
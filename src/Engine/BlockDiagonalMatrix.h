@@ -131,10 +131,13 @@ public:
 			offsetsRows_[i] = offsetsCols_[i] = basis.partition(i);
 	}
 
-	BlockDiagonalMatrix(PsimagLite::IoSimple::In& io,
+	template<typename IoInputType>
+	BlockDiagonalMatrix(IoInputType& io,
 	                    PsimagLite::String label,
 	                    SizeType counter,
-	                    bool)
+	                    bool,
+	                    typename PsimagLite::EnableIf<
+	                    PsimagLite::IsInputLike<IoInputType>::True, int>::Type = 0)
 	{
 		io.advance("#NAME="+label,counter);
 		io>>(*this);
@@ -150,6 +153,24 @@ public:
 		io<<(*this);
 	}
 
+	template<typename BinaryOutputType>
+	void writeBinary(BinaryOutputType& io) const
+	{
+		io.write(isSquare_);
+		io.write(offsetsRows_);
+		io.write(offsetsCols_);
+		io.write(data_);
+	}
+
+	template<typename BinaryInputType>
+	void readBinary(BinaryInputType& io)
+	{
+		io.read(isSquare_);
+		io.read(offsetsRows_);
+		io.read(offsetsCols_);
+		io.read(data_);
+	}
+
 	void setTo(ComplexOrRealType value)
 	{
 		SizeType n = data_.size();
@@ -280,6 +301,56 @@ public:
 		}
 	}
 
+	// From a sparse matrix, split into the most blocks along the diagonal
+	// that hold its nonzeros; a new block starts at row i if all columns of
+	// the rows above i are before those of the rows from i on. The blocks
+	// of toSparse are found, or split further, the rows and columns with no
+	// nonzeros making blocks with no columns or rows
+	void fromSparse(const PsimagLite::CrsMatrix<ComplexOrRealType>& fm)
+	{
+		SizeType r = fm.rows();
+		VectorSizeType colMinFrom(r + 1, fm.cols());
+		for (SizeType i = r; i > 0; --i) {
+			colMinFrom[i - 1] = colMinFrom[i];
+			for (int k = fm.getRowPtr(i - 1); k < fm.getRowPtr(i); ++k)
+				if (fm.getCol(k) < colMinFrom[i - 1]) colMinFrom[i - 1] = fm.getCol(k);
+		}
+
+		VectorSizeType offsetsRows(1, 0);
+		VectorSizeType offsetsCols(1, 0);
+		SizeType colEnd = 0;
+		for (SizeType i = 0; i < r; ++i) {
+			if (i > 0 && colEnd <= colMinFrom[i]) {
+				offsetsRows.push_back(i);
+				offsetsCols.push_back(colEnd);
+			}
+
+			for (int k = fm.getRowPtr(i); k < fm.getRowPtr(i + 1); ++k)
+				if (fm.getCol(k) + 1 > colEnd) colEnd = fm.getCol(k) + 1;
+		}
+
+		offsetsRows.push_back(r);
+		offsetsCols.push_back(fm.cols());
+
+		SizeType n = offsetsRows.size() - 1;
+		typename PsimagLite::Vector<MatrixInBlockTemplate>::Type data(n);
+		SizeType k = 0;
+		for (SizeType i = 0; i < r; ++i) {
+			if (offsetsRows[k + 1] <= i) ++k;
+			MatrixInBlockTemplate& m = data[k];
+			if (i == offsetsRows[k])
+				m.resize(offsetsRows[k + 1] - i, offsetsCols[k + 1] - offsetsCols[k]);
+
+			for (int kk = fm.getRowPtr(i); kk < fm.getRowPtr(i + 1); ++kk)
+				m(i - offsetsRows[k], fm.getCol(kk) - offsetsCols[k]) = fm.getValue(kk);
+		}
+
+		offsetsRows_.swap(offsetsRows);
+		offsetsCols_.swap(offsetsCols);
+		data_.swap(data);
+		isSquare_ = (rows() == cols());
+	}
+
 	void diagAndEnforcePhase(SizeType m, VectorRealType& eigsTmp, char option)
 	{
 		assert(m < data_.size());
@@ -0,0 +1,633 @@
+#ifndef BLOCKSPARSEOPERATOR_H
+#define BLOCKSPARSEOPERATOR_H
+#include "Matrix.h"
+#include "BLAS.h"
+#include "CrsMatrix.h"
+#include "BlockDiagonalMatrix.h"
+#include <algorithm>
+
+namespace Dmrg {
+
+/* PSIDOC BlockSparseOperator
+ A local operator stored by blocks of symmetry sectors. Row sector $I$ and
+ column sector $J$ are the partitions of the bases on which the operator acts;
+ only the blocks $(I, J)$ that have non-zero elements are stored, each one
+ either as a dense matrix or as a CRS matrix, depending on its fill.
+ This is used for the local (non-SU(2)) symmetry only, and
+ selected with \verb!blockSparseOperators! in \verb!SolverOptions=!.
+ Operators are still stored as CRS matrices; one of these is built from
+ them for each change of basis or expansion, and written back as CRS,
+ at a cost linear in their number of non-zeros. The patches of the
+ Kronecker product (see ArrayOfMatStruct) are always extracted from one of
+ these, for both symmetries, because the blocks are found in a single pass.
+ */
+template<typename ComplexOrRealType>
+class BlockSparseOperator {
+
+public:
+
+	typedef PsimagLite::CrsMatrix<ComplexOrRealType> SparseMatrixType;
+	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
+	typedef BlockDiagonalMatrix<MatrixType> BlockDiagonalMatrixType;
+	typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
+	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef PsimagLite::Vector<int>::Type VectorIntType;
+
+	class Block {
+
+	public:
+
+		Block(SizeType rowSector, SizeType colSector, SizeType rows, SizeType cols)
+		    : rowSector_(rowSector),
+		      colSector_(colSector),
+		      rows_(rows),
+		      cols_(cols),
+		      isDense_(true)
+		{}
+
+		SizeType rowSector() const { return rowSector_; }
+
+		SizeType colSector() const { return colSector_; }
+
+		SizeType rows() const { return rows_; }
+
+		SizeType cols() const { return cols_; }
+
+		bool isDense() const { return isDense_; }
+
+		const MatrixType& dense() const
+		{
+			if (!isDense_)
+				err("BlockSparseOperator::Block::dense() cannot be called when sparse\n");
+			return dense_;
+		}
+
+		const SparseMatrixType& sparse() const
+		{
+			if (isDense_)
+				err("BlockSparseOperator::Block::sparse() cannot be called when dense\n");
+			return sparse_;
+		}
+
+		void toDense(MatrixType& m) const
+		{
+			if (isDense_) {
+				m = dense_;
+				return;
+			}
+
+			crsMatrixToFullMatrix(m, sparse_);
+		}
+
+		friend class BlockSparseOperator;
+
+	private:
+
+		void setDense(const MatrixType& m, RealType threshold)
+		{
+			SizeType elements = rows_*cols_;
+			isDense_ = (m.nonZeros() > threshold*elements);
+			if (isDense_) {
+				dense_ = m;
+				return;
+			}
+
+			fullMatrixToCrsMatrix(sparse_, m);
+		}
+
+		SizeType rowSector_;
+		SizeType colSector_;
+		SizeType rows_;
+		SizeType cols_;
+		bool isDense_;
+		MatrixType dense_;
+		SparseMatrixType sparse_;
+	}; // class Block
+
+	typedef typename PsimagLite::Vector<Block>::Type VectorBlockType;
+
+	BlockSparseOperator(RealType threshold = 0.1)
+	    : threshold_(threshold)
+	{}
+
+	// rowPartition and colPartition are the partitions of the bases,
+	// that is, they include the last element (the size of the basis)
+	BlockSparseOperator(const SparseMatrixType& m,
+	                    const VectorSizeType& rowPartition,
+	                    const VectorSizeType& colPartition,
+	                    RealType threshold = 0.1)
+	    : threshold_(threshold)
+	{
+		fromSparse(m, rowPartition, colPartition);
+	}
+
+	void fromSparse(const SparseMatrixType& m,
+	                const VectorSizeType& rowPartition,
+	                const VectorSizeType& colPartition)
+	{
+		rowPartition_ = rowPartition;
+		colPartition_ = colPartition;
+		blocks_.clear();
+		index_.clear();
+		assert(rowPartition_.size() > 0 && colPartition_.size() > 0);
+		SizeType rowSectors = rowPartition_.size() - 1;
+		SizeType colSectors = colPartition_.size() - 1;
+		index_.resize(rowSectors*colSectors, -1);
+		if (m.rows() == 0 || m.cols() == 0) return;
+
+		assert(rows() == m.rows());
+		assert(cols() == m.cols());
+
+		VectorSizeType colSector;
+		sectorOfEachState(colSector, colPartition_);
+
+		for (SizeType bigI = 0; bigI < rowSectors; ++bigI) {
+			SizeType start = rowPartition_[bigI];
+			SizeType end = rowPartition_[bigI + 1];
+			VectorSizeType nonzeros(colSectors, 0);
+			for (SizeType i = start; i < end; ++i)
+				for (int k = m.getRowPtr(i); k < m.getRowPtr(i + 1); ++k)
+					++nonzeros[colSector[m.getCol(k)]];
+
+			for (SizeType bigJ = 0; bigJ < colSectors; ++bigJ) {
+				if (nonzeros[bigJ] == 0) continue;
+				SizeType c = colPartition_[bigJ + 1] - colPartition_[bigJ];
+				Block b(bigI, bigJ, end - start, c);
+				b.isDense_ = (nonzeros[bigJ] > threshold_*(end - start)*c);
+				if (b.isDense_) {
+					b.dense_.resize(end - start, c);
+					b.dense_.setTo(0.0);
+				} else {
+					b.sparse_.resize(end - start, c);
+				}
+
+				index_[bigI + bigJ*rowSectors] = blocks_.size();
+				blocks_.push_back(b);
+			}
+
+			VectorSizeType counter(colSectors, 0);
+			for (SizeType i = start; i < end; ++i) {
+				for (SizeType bigJ = 0; bigJ < colSectors; ++bigJ) {
+					int ind = index_[bigI + bigJ*rowSectors];
+					if (ind < 0 || blocks_[ind].isDense_) continue;
+					blocks_[ind].sparse_.setRow(i - start, counter[bigJ]);
+				}
+
+				for (int k = m.getRowPtr(i); k < m.getRowPtr(i + 1); ++k) {
+					SizeType col = m.getCol(k);
+					SizeType bigJ = colSector[col];
+					Block& b = blocks_[index_[bigI + bigJ*rowSectors]];
+					SizeType j = col - colPartition_[bigJ];
+					if (b.isDense_) {
+						b.dense_(i - start, j) += m.getValue(k);
+						continue;
+					}
+
+					b.sparse_.pushCol(j);
+					b.sparse_.pushValue(m.getValue(k));
+					++counter[bigJ];
+				}
+			}
+
+			for (SizeType bigJ = 0; bigJ < colSectors; ++bigJ) {
+				int ind = index_[bigI + bigJ*rowSectors];
+				if (ind < 0 || blocks_[ind].isDense_) continue;
+				blocks_[ind].sparse_.setRow(end - start, counter[bigJ]);
+				blocks_[ind].sparse_.checkValidity();
+			}
+		}
+	}
+
+	void toSparse(SparseMatrixType& m) const
+	{
+		SizeType r = rows();
+		SizeType c = cols();
+		m.resize(r, c);
+		SizeType counter = 0;
+		SizeType rowSectors = (rowPartition_.size() == 0) ? 0 : rowPartition_.size() - 1;
+		SizeType colSectors = (colPartition_.size() == 0) ? 0 : colPartition_.size() - 1;
+		for (SizeType bigI = 0; bigI < rowSectors; ++bigI) {
+			SizeType start = rowPartition_[bigI];
+			SizeType end = rowPartition_[bigI + 1];
+			for (SizeType i = start; i < end; ++i) {
+				m.setRow(i, counter);
+				for (SizeType bigJ = 0; bigJ < colSectors; ++bigJ) {
+					int ind = index_[bigI + bigJ*rowSectors];
+					if (ind < 0) continue;
+					counter += appendRow(m, blocks_[ind], i - start, colPartition_[bigJ]);
+				}
+			}
+		}
+
+		m.setRow(r, counter);
+		m.checkValidity();
+	}
+
+	// this <-- T^\dagger this T, where T is block diagonal in the row
+	// sectors of this operator. T can have truncated columns (and even empty blocks)
+	void changeBasis(const BlockDiagonalMatrixType& t)
+	{
+		if (rowPartition_ != colPartition_)
+			err("BlockSparseOperator::changeBasis: operator must be square by sectors\n");
+
+		SizeType sectors = t.blocks();
+		if (rowPartition_.size() != sectors + 1)
+			err("BlockSparseOperator::changeBasis: transform has wrong number of blocks\n");
+
+		VectorSizeType partitionNew(sectors + 1, 0);
+		for (SizeType i = 0; i < sectors; ++i) {
+			assert(t.offsetsRows(i) == rowPartition_[i]);
+			partitionNew[i] = t.offsetsCols(i);
+		}
+
+		partitionNew[sectors] = t.cols();
+
+		VectorBlockType blocksNew;
+		VectorIntType indexNew(sectors*sectors, -1);
+		MatrixType tmp;
+		MatrixType result;
+		for (SizeType x = 0; x < blocks_.size(); ++x) {
+			const Block& b = blocks_[x];
+			const MatrixType& tI = t(b.rowSector_);
+			const MatrixType& tJ = t(b.colSector_);
+			if (tI.cols() == 0 || tJ.cols() == 0) continue;
+
+			rotate(result, tmp, b, tI, tJ);
+			Block bnew(b.rowSector_, b.colSector_, tI.cols(), tJ.cols());
+			bnew.setDense(result, threshold_);
+			indexNew[b.rowSector_ + b.colSector_*sectors] = blocksNew.size();
+			blocksNew.push_back(bnew);
+		}
+
+		blocks_.swap(blocksNew);
+		index_.swap(indexNew);
+		rowPartition_ = colPartition_ = partitionNew;
+	}
+
+	// Convenience function:
+	// v <-- T^\dagger v T, done by symmetry blocks
+	static void changeBasis(SparseMatrixType& v,
+	                        const BlockDiagonalMatrixType& t,
+	                        RealType threshold)
+	{
+		if (v.rows() == 0 || v.cols() == 0) return;
+		VectorSizeType partition;
+		partitionFromTransform(partition, t);
+		BlockSparseOperator op(v, partition, partition, threshold);
+		op.changeBasis(t);
+		op.toSparse(v);
+	}
+
+	/* PSIDOC BlockSparseOperatorExternalProduct
+	 Kronecker expansion of an operator into the product basis
+	 basis2 $\otimes$ basis3, with index $i + j n_2$ for $i$ in basis2 and $j$ in
+	 basis3, and with the product basis
+	 reordered by its permutation. If \verb!option! is true the operator
+	 acts on basis2 (as $A\otimes 1$), otherwise it acts on basis3 (as $1\otimes A$)
+	 and picks up the fermionic signs of basis2.
+	 Because all the states of block $(I,J)$ of $A$ times a fixed state
+	 of the other basis land in a single sector pair of the product,
+	 the sectors, and the permuted rows and columns of the block, are
+	 found once per block and state of the other basis; then only the
+	 stored elements of the block are visited.
+	 */
+	template<typename BasisType>
+	void externalProduct(const BlockSparseOperator& a,
+	                     const BasisType& basis2,
+	                     const BasisType& basis3,
+	                     const BasisType& product,
+	                     const VectorRealType& signs,
+	                     bool option)
+	{
+		SizeType ns = basis2.size();
+		SizeType ne = basis3.size();
+		SizeType nother = (option) ? ne : ns;
+		partitionFromBasis(rowPartition_, product);
+		colPartition_ = rowPartition_;
+		VectorSizeType sectorOf;
+		sectorOfEachState(sectorOf, rowPartition_);
+
+		SizeType sectors = rowPartition_.size() - 1;
+		blocks_.clear();
+		index_.clear();
+		index_.resize(sectors*sectors, -1);
+
+		typedef typename PsimagLite::Vector<ComplexOrRealType>::Type VectorType;
+		typename PsimagLite::Vector<VectorSizeType>::Type rowsOf;
+		typename PsimagLite::Vector<VectorSizeType>::Type colsOf;
+		typename PsimagLite::Vector<VectorType>::Type valuesOf;
+
+		VectorSizeType rowsP;
+		VectorSizeType colsP;
+		for (SizeType x = 0; x < a.blocks_.size(); ++x) {
+			const Block& b = a.blocks_[x];
+			SizeType rowOffset = a.rowPartition_[b.rowSector_];
+			SizeType colOffset = a.colPartition_[b.colSector_];
+			rowsP.resize(b.rows_);
+			colsP.resize(b.cols_);
+			for (SizeType other = 0; other < nother; ++other) {
+				for (SizeType i = 0; i < b.rows_; ++i)
+					rowsP[i] = product.permutationInverse(productIndex(i + rowOffset,
+					                                                   other,
+					                                                   ns,
+					                                                   option));
+				for (SizeType j = 0; j < b.cols_; ++j)
+					colsP[j] = product.permutationInverse(productIndex(j + colOffset,
+					                                                   other,
+					                                                   ns,
+					                                                   option));
+
+				SizeType bigP = sectorOf[rowsP[0]];
+				SizeType bigQ = sectorOf[colsP[0]];
+				SizeType pOffset = rowPartition_[bigP];
+				SizeType qOffset = colPartition_[bigQ];
+				int ind = index_[bigP + bigQ*sectors];
+				if (ind < 0) {
+					ind = index_[bigP + bigQ*sectors] = blocks_.size();
+					blocks_.push_back(Block(bigP,
+					                        bigQ,
+					                        rowPartition_[bigP + 1] - pOffset,
+					                        colPartition_[bigQ + 1] - qOffset));
+					rowsOf.push_back(VectorSizeType());
+					colsOf.push_back(VectorSizeType());
+					valuesOf.push_back(VectorType());
+				}
+
+				ComplexOrRealType sign = (option) ? 1.0 : signs[other];
+				VectorSizeType& rows = rowsOf[ind];
+				VectorSizeType& cols = colsOf[ind];
+				VectorType& values = valuesOf[ind];
+				for (SizeType i = 0; i < b.rows_; ++i) {
+					assert(sectorOf[rowsP[i]] == bigP);
+					SizeType p = rowsP[i] - pOffset;
+					if (b.isDense_) {
+						for (SizeType j = 0; j < b.cols_; ++j) {
+							const ComplexOrRealType& val = b.dense_(i, j);
+							if (val == static_cast<ComplexOrRealType>(0.0)) continue;
+							assert(sectorOf[colsP[j]] == bigQ);
+							rows.push_back(p);
+							cols.push_back(colsP[j] - qOffset);
+							values.push_back(val*sign);
+						}
+
+						continue;
+					}
+
+					for (int k = b.sparse_.getRowPtr(i); k < b.sparse_.getRowPtr(i + 1); ++k) {
+						SizeType j = b.sparse_.getCol(k);
+						assert(sectorOf[colsP[j]] == bigQ);
+						rows.push_back(p);
+						cols.push_back(colsP[j] - qOffset);
+						values.push_back(b.sparse_.getValue(k)*sign);
+					}
+				}
+			}
+		}
+
+		for (SizeType x = 0; x < blocks_.size(); ++x) {
+			blocks_[x].isDense_ = false;
+			fromTriplets(blocks_[x].sparse_,
+			             blocks_[x].rows_,
+			             blocks_[x].cols_,
+			             rowsOf[x],
+			             colsOf[x],
+			             valuesOf[x]);
+		}
+	}
+
+	// Patch extraction for Kronecker: adds block (I, J), if stored, to the
+	// top left corner of m, which can be larger than the block (padding);
+	// elements of the block beyond m are dropped
+	void fillPatch(MatrixType& m, SizeType bigI, SizeType bigJ) const
+	{
+		const Block* b = block(bigI, bigJ);
+		if (!b) return;
+
+		SizeType r = std::min(b->rows_, m.rows());
+		SizeType c = std::min(b->cols_, m.cols());
+		if (b->isDense_) {
+			for (SizeType j = 0; j < c; ++j)
+				for (SizeType i = 0; i < r; ++i)
+					m(i, j) += b->dense_(i, j);
+			return;
+		}
+
+		for (SizeType i = 0; i < r; ++i) {
+			for (int k = b->sparse_.getRowPtr(i); k < b->sparse_.getRowPtr(i + 1); ++k) {
+				SizeType j = b->sparse_.getCol(k);
+				if (j < c) m(i, j) += b->sparse_.getValue(k);
+			}
+		}
+	}
+
+	// returns 0 if block (I, J) is not stored
+	const Block* block(SizeType bigI, SizeType bigJ) const
+	{
+		SizeType rowSectors = rowPartition_.size() - 1;
+		assert(bigI + bigJ*rowSectors < index_.size());
+		int ind = index_[bigI + bigJ*rowSectors];
+		return (ind < 0) ? 0 : &(blocks_[ind]);
+	}
+
+	const VectorBlockType& blocks() const { return blocks_; }
+
+	SizeType rows() const
+	{
+		SizeType n = rowPartition_.size();
+		return (n == 0) ? 0 : rowPartition_[n - 1];
+	}
+
+	SizeType cols() const
+	{
+		SizeType n = colPartition_.size();
+		return (n == 0) ? 0 : colPartition_[n - 1];
+	}
+
+	const VectorSizeType& rowPartition() const { return rowPartition_; }
+
+	const VectorSizeType& colPartition() const { return colPartition_; }
+
+	static void partitionFromTransform(VectorSizeType& partition,
+	                                   const BlockDiagonalMatrixType& t)
+	{
+		SizeType n = t.blocks();
+		partition.resize(n + 1);
+		for (SizeType i = 0; i < n; ++i)
+			partition[i] = t.offsetsRows(i);
+		partition[n] = t.rows();
+	}
+
+	template<typename BasisType>
+	static void partitionFromBasis(VectorSizeType& partition,
+	                               const BasisType& basis)
+	{
+		SizeType n = basis.partition();
+		partition.resize(n);
+		for (SizeType i = 0; i < n; ++i)
+			partition[i] = basis.partition(i);
+	}
+
+	// Same as partitionFromBasis, but for a matrix with total rows or
+	// columns, which can be fewer than, or more than, the basis states:
+	// sectors are cut at total, and any states past the basis are in the
+	// last sector
+	template<typename BasisType>
+	static void partitionFromBasis(VectorSizeType& partition,
+	                               const BasisType& basis,
+	                               SizeType total)
+	{
+		partitionFromBasis(partition, basis);
+		SizeType n = partition.size();
+		for (SizeType i = 0; i < n; ++i)
+			partition[i] = std::min(partition[i], total);
+		partition[n - 1] = total;
+	}
+
+private:
+
+	static SizeType productIndex(SizeType ind,
+	                             SizeType other,
+	                             SizeType ns,
+	                             bool option)
+	{
+		return (option) ? ind + other*ns : other + ind*ns;
+	}
+
+	static void sectorOfEachState(VectorSizeType& sectorOf,
+	                              const VectorSizeType& partition)
+	{
+		SizeType n = partition.size();
+		assert(n > 0);
+		sectorOf.resize(partition[n - 1]);
+		for (SizeType i = 0; i + 1 < n; ++i)
+			for (SizeType j = partition[i]; j < partition[i + 1]; ++j)
+				sectorOf[j] = i;
+	}
+
+	static SizeType appendRow(SparseMatrixType& m,
+	                          const Block& b,
+	                          SizeType i,
+	                          SizeType colOffset)
+	{
+		SizeType counter = 0;
+		if (b.isDense_) {
+			for (SizeType j = 0; j < b.cols_; ++j) {
+				const ComplexOrRealType& val = b.dense_(i, j);
+				if (val == static_cast<ComplexOrRealType>(0.0)) continue;
+				m.pushCol(j + colOffset);
+				m.pushValue(val);
+				++counter;
+			}
+
+			return counter;
+		}
+
+		for (int k = b.sparse_.getRowPtr(i); k < b.sparse_.getRowPtr(i + 1); ++k) {
+			m.pushCol(b.sparse_.getCol(k) + colOffset);
+			m.pushValue(b.sparse_.getValue(k));
+			++counter;
+		}
+
+		return counter;
+	}
+
+	// result = tI^\dagger b tJ
+	static void rotate(MatrixType& result,
+	                   MatrixType& tmp,
+	                   const Block& b,
+	                   const MatrixType& tI,
+	                   const MatrixType& tJ)
+	{
+		SizeType r = b.rows_;
+		SizeType c = b.cols_;
+		SizeType cJ = tJ.cols();
+		SizeType rI = tI.cols();
+		assert(tI.rows() == r);
+		assert(tJ.rows() == c);
+
+		tmp.resize(r, cJ);
+		tmp.setTo(0.0);
+		if (b.isDense_) {
+			psimag::BLAS::GEMM('N',
+			                   'N',
+			                   r,
+			                   cJ,
+			                   c,
+			                   1.0,
+			                   &(b.dense_(0,0)),
+			                   r,
+			                   &(tJ(0,0)),
+			                   c,
+			                   0.0,
+			                   &(tmp(0,0)),
+			                   r);
+		} else {
+			for (SizeType i = 0; i < r; ++i) {
+				for (int k = b.sparse_.getRowPtr(i); k < b.sparse_.getRowPtr(i + 1); ++k) {
+					SizeType col = b.sparse_.getCol(k);
+					const ComplexOrRealType& val = b.sparse_.getValue(k);
+					for (SizeType j = 0; j < cJ; ++j)
+						tmp(i, j) += val*tJ(col, j);
+				}
+			}
+		}
+
+		result.resize(rI, cJ);
+		result.setTo(0.0);
+		psimag::BLAS::GEMM('C',
+		                   'N',
+		                   rI,
+		                   cJ,
+		                   r,
+		                   1.0,
+		                   &(tI(0,0)),
+		                   r,
+		                   &(tmp(0,0)),
+		                   r,
+		                   0.0,
+		                   &(result(0,0)),
+		                   rI);
+	}
+
+	template<typename VectorType>
+	static void fromTriplets(SparseMatrixType& m,
+	                         SizeType rows,
+	                         SizeType cols,
+	                         const VectorSizeType& rowInd,
+	                         const VectorSizeType& colInd,
+	                         const VectorType& values)
+	{
+		SizeType nonzeros = rowInd.size();
+		VectorSizeType rowPtr(rows + 1, 0);
+		for (SizeType x = 0; x < nonzeros; ++x)
+			++rowPtr[rowInd[x] + 1];
+		for (SizeType i = 0; i < rows; ++i)
+			rowPtr[i + 1] += rowPtr[i];
+
+		VectorSizeType where(rowPtr.begin(), rowPtr.end() - 1);
+		VectorSizeType order(nonzeros);
+		for (SizeType x = 0; x < nonzeros; ++x)
+			order[where[rowInd[x]]++] = x;
+
+		m.resize(rows, cols);
+		for (SizeType i = 0; i < rows; ++i) {
+			m.setRow(i, rowPtr[i]);
+			for (SizeType k = rowPtr[i]; k < rowPtr[i + 1]; ++k) {
+				m.pushCol(colInd[order[k]]);
+				m.pushValue(values[order[k]]);
+			}
+		}
+
+		m.setRow(rows, nonzeros);
+		m.checkValidity();
+	}
+
+	RealType threshold_;
+	VectorSizeType rowPartition_;
+	VectorSizeType colPartition_;
+	VectorBlockType blocks_;
+	VectorIntType index_;
+}; // class BlockSparseOperator
+} // namespace Dmrg
+#endif // BLOCKSPARSEOPERATOR_H
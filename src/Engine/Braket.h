@@ -5,6 +5,7 @@
 #include "Matrix.h"
 #include "OperatorSpec.h"
 #include "CanonicalExpression.h"
+#include "OperatorExpressionCache.h"
 
 namespace Dmrg {
 
@@ -25,8 +26,12 @@ class Braket {
 public:
 
 	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
+	typedef OperatorExpressionCache<ModelType> OperatorExpressionCacheType;
 
-	Braket(const ModelType& model,const PsimagLite::String& braket)
+	// The operators are taken from cache, if given, instead of built anew
+	Braket(const ModelType& model,
+	       const PsimagLite::String& braket,
+	       OperatorExpressionCacheType* cache = 0)
 	    : model_(model), braket_(2,""),savedString_(braket)
 	{
 		VectorStringType vecStr;
@@ -56,6 +61,12 @@ public:
 
 		sites_.resize(opExprName_.size(),-1);
 
+		if (cache) {
+			for (SizeType i = 0; i < opExprName_.size(); ++i)
+				op_.push_back((*cache)(opExprName_[i],sites_[i]));
+			return;
+		}
+
 		OperatorSpecType opSpec(model);
 		PsimagLite::CanonicalExpression<OperatorSpecType> canonicalExpression(opSpec);
 
@@ -86,6 +86,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "ProgressIndicator.h"
 #include "ProgramGlobals.h"
 #include "BaseStack.h"
+#include "RecoveryJournal.h"
 
 namespace Dmrg {
 
@@ -105,6 +106,7 @@ public:
 	typedef typename OperatorType::SparseMatrixType SparseMatrixType;
 	typedef BaseStack<BasisWithOperatorsType> MemoryStackType;
 	typedef DiskStack<BasisWithOperatorsType>  DiskStackType;
+	typedef RecoveryJournal<BasisWithOperatorsType> RecoveryJournalType;
 	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
 	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
 
@@ -120,19 +122,33 @@ public:
 	    parameters_(parameters),
 	    enabled_(parameters_.options.find("checkpoint")!=PsimagLite::String::npos ||
 	        parameters_.options.find("restart")!=PsimagLite::String::npos),
-	    systemStack_(parameters_.options.find("diskstacks")!=PsimagLite::String::npos),
-	    envStack_(parameters_.options.find("diskstacks")!=PsimagLite::String::npos),
+	    systemStack_(parameters_.options.find("diskstacks")!=PsimagLite::String::npos,
+	                 parameters_.options.find("binaryStacks")!=PsimagLite::String::npos,
+	                 parameters_.options.find("compressedStacks")!=PsimagLite::String::npos),
+	    envStack_(parameters_.options.find("diskstacks")!=PsimagLite::String::npos,
+	              parameters_.options.find("binaryStacks")!=PsimagLite::String::npos,
+	              parameters_.options.find("compressedStacks")!=PsimagLite::String::npos),
+	    restartFromIndex_(enabled_ && DiskStackBinaryFile<BasisWithOperatorsType>::isIndexFile(
+	                          utils::pathPrepend(SYSTEM_STACK_STRING,
+	                                             parameters_.checkpoint.filename))),
 	    systemDisk_(utils::pathPrepend(SYSTEM_STACK_STRING,parameters_.checkpoint.filename),
 	                utils::pathPrepend(SYSTEM_STACK_STRING,parameters_.filename),
-	                enabled_,
+	                enabled_ && !restartFromIndex_,
 	                isObserveCode),
 	    envDisk_(utils::pathPrepend(ENVIRON_STACK_STRING,parameters_.checkpoint.filename),
 	             utils::pathPrepend(ENVIRON_STACK_STRING,parameters_.filename),
-	             enabled_,
+	             enabled_ && !restartFromIndex_,
 	             isObserveCode),
+	    systemJournal_(0),
+	    envJournal_(0),
 	    progress_("Checkpoint"),
 	    energyFromFile_(0.0)
 	{
+		systemStack_.setAsync(parameters_.diskStackPrefetch,
+		                      parameters_.diskStackWriteBudget*1024*1024);
+		envStack_.setAsync(parameters_.diskStackPrefetch,
+		                   parameters_.diskStackWriteBudget*1024*1024);
+
 		SizeType site = 0; // FIXME for Immm model, find max of hilbert(site) over site
 		SizeType hilbertOneSite = model.hilbertSize(site);
 		if (parameters_.keptStatesInfinite < hilbertOneSite) {
@@ -144,6 +160,10 @@ public:
 
 		checkFiniteLoops(model.geometry().numberOfSites(), hilbertOneSite, ioIn);
 
+		if (!isObserveCode && parameters_.recoverySave != "0" &&
+		        parameters_.options.find("incrementalRecovery") != PsimagLite::String::npos)
+			createJournals();
+
 		if (!enabled_) return;
 
 		{
@@ -173,7 +193,7 @@ public:
 			}
 		}
 
-		loadStacksDiskToMemory();
+		loadStacksDiskToMemory(isObserveCode);
 	}
 
 	~Checkpoint()
@@ -183,6 +203,22 @@ public:
 			systemDisk_.finalize();
 			envDisk_.finalize();
 		}
+
+		if (!systemJournal_) return;
+
+		VectorStringType files;
+		systemJournal_->appendFiles(files);
+		envJournal_->appendFiles(files);
+		delete systemJournal_;
+		systemJournal_ = 0;
+		delete envJournal_;
+		envJournal_ = 0;
+
+		if (parameters_.options.find("recoveryNoDelete") != PsimagLite::String::npos)
+			return;
+
+		for (SizeType i = 0; i < files.size(); ++i)
+			unlink(files[i].c_str());
 	}
 
 	// Not related to stacks
@@ -224,20 +260,44 @@ public:
 	{
 		systemStack_.push(pS);
 		envStack_.push(pE);
+		if (!systemJournal_) return;
+		systemJournal_->push(pS);
+		envJournal_->push(pE);
 	}
 
 	void push(const BasisWithOperatorsType &pSorE,SizeType what)
 	{
 		if (what==ProgramGlobals::ENVIRON) envStack_.push(pSorE);
 		else systemStack_.push(pSorE);
+		RecoveryJournalType* journal = journalFor(what);
+		if (journal) journal->push(pSorE);
 	}
 
 	BasisWithOperatorsType shrink(SizeType what,const TargettingType& target)
 	{
+		RecoveryJournalType* journal = journalFor(what);
+		if (journal) journal->pop();
 		if (what==ProgramGlobals::ENVIRON) return shrink(envStack_,target);
 		else return shrink(systemStack_,target);
 	}
 
+	bool hasRecoveryJournal() const { return (systemJournal_ != 0); }
+
+	// Queues the index files of the stacks as they are now; see RecoveryJournal.h
+	void saveRecoveryIndex(PsimagLite::String sysFile, PsimagLite::String envFile) const
+	{
+		assert(systemJournal_ && envJournal_);
+		systemJournal_->saveIndex(sysFile);
+		envJournal_->saveIndex(envFile);
+	}
+
+	void flushRecovery() const
+	{
+		if (!systemJournal_) return;
+		systemJournal_->flush();
+		envJournal_->flush();
+	}
+
 	bool operator()() const { return enabled_; }
 
 	SizeType stackSize(SizeType what) const
@@ -246,6 +306,13 @@ public:
 		return systemStack_.size();
 	}
 
+	// Adds the compression statistics of the stacks since the last call
+	void takeStackStats(DiskStackCompression::Stats& stats) const
+	{
+		systemStack_.takeStats(stats);
+		envStack_.takeStats(stats);
+	}
+
 	const MemoryStackType& memoryStack(SizeType option) const
 	{
 		return (option == ProgramGlobals::SYSTEM) ? systemStack_ : envStack_;
@@ -370,6 +437,26 @@ private:
 		}
 	}
 
+	void createJournals()
+	{
+		bool compressed = (parameters_.options.find("compressedStacks") !=
+		        PsimagLite::String::npos);
+		PsimagLite::String root = utils::pathPrepend("RecoveryJournal",parameters_.filename);
+		systemJournal_ = new RecoveryJournalType(utils::pathPrepend(SYSTEM_STACK_STRING,
+		                                                            root),
+		                                         compressed);
+		envJournal_ = new RecoveryJournalType(utils::pathPrepend(ENVIRON_STACK_STRING,
+		                                                         root),
+		                                      compressed);
+		systemJournal_->startThread(parameters_.diskStackWriteBudget*1024*1024);
+		envJournal_->startThread(parameters_.diskStackWriteBudget*1024*1024);
+	}
+
+	RecoveryJournalType* journalFor(SizeType what) const
+	{
+		return (what == ProgramGlobals::ENVIRON) ? envJournal_ : systemJournal_;
+	}
+
 	//! shrink  (we don't really shrink, we just undo the growth)
 	BasisWithOperatorsType shrink(MemoryStackType& thisStack,
 	                              const TargettingType& target)
@@ -382,14 +469,40 @@ private:
 		return basisWithOps;
 	}
 
-	void loadStacksDiskToMemory()
+	void loadStacksDiskToMemory(bool isObserveCode)
 	{
 		PsimagLite::OstringStream msg;
 		msg<<"Loading sys. and env. stacks from disk...";
 		progress_.printline(msg,std::cout);
 
-		loadStack(systemStack_,systemDisk_);
-		loadStack(envStack_,envDisk_);
+		if (restartFromIndex_) {
+			PsimagLite::String file = parameters_.checkpoint.filename;
+			RecoveryJournalType::load(systemStack_,
+			                          utils::pathPrepend(SYSTEM_STACK_STRING,file),
+			                          systemJournal_,
+			                          isObserveCode);
+			RecoveryJournalType::load(envStack_,
+			                          utils::pathPrepend(ENVIRON_STACK_STRING,file),
+			                          envJournal_,
+			                          isObserveCode);
+			return;
+		}
+
+		loadStack(systemStack_,systemDisk_,systemJournal_);
+		loadStack(envStack_,envDisk_,envJournal_);
+	}
+
+	// the memory stacks are not persistent, so the journals need their entries
+	static void loadStack(MemoryStackType& stackInMemory,
+	                      DiskStackType& stackInDisk,
+	                      RecoveryJournalType* journal)
+	{
+		while (stackInDisk.size()>0) {
+			BasisWithOperatorsType b = stackInDisk.top();
+			stackInMemory.push(b);
+			if (journal) journal->push(b);
+			stackInDisk.pop();
+		}
 	}
 
 	void loadStacksMemoryToDisk()
@@ -418,8 +531,11 @@ private:
 	bool enabled_;
 	MemoryStackType systemStack_;
 	MemoryStackType envStack_;
+	bool restartFromIndex_;
 	DiskStackType systemDisk_;
 	DiskStackType envDisk_;
+	RecoveryJournalType* systemJournal_;
+	RecoveryJournalType* envJournal_;
 	PsimagLite::ProgressIndicator progress_;
 	RealType energyFromFile_;
 }; // class Checkpoint
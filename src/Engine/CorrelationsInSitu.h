@@ -0,0 +1,325 @@
+#ifndef CORRELATIONSINSITU_H
+#define CORRELATIONSINSITU_H
+#include "Vector.h"
+#include "CrsMatrix.h"
+#include "ProgressIndicator.h"
+#include "FermionSign.h"
+#include "CorrelationsSkeleton.h"
+#include <fstream>
+
+/* Two-point correlations measured during the last finite loop that grows
+   the system
+
+   Each braket <gs|A[r];B|gs> of InSituTwoPoint gives <A_r B_j> for
+   j = r, r+1, ..., up to the last site, without saving data for observe.
+   As the loop adds site r to the system, A_r is put in the basis of the
+   system, and is then carried from step to step, transformed with the
+   truncation of each step as observe transforms it with the saved data.
+   At the step that adds site j the carried A_r is bracketed with B on that
+   site, and the last site is measured at the step where it is the whole
+   environment. The brackets are those of CorrelationsSkeleton, through
+   CorrelationsInSituHelper, which gives it the current step instead of a
+   saved one.
+*/
+namespace Dmrg {
+
+template<typename LeftRightSuperType_, typename VectorWithOffsetType_>
+class CorrelationsInSituHelper {
+
+public:
+
+	typedef LeftRightSuperType_ LeftRightSuperType;
+	typedef VectorWithOffsetType_ VectorWithOffsetType;
+	typedef typename VectorWithOffsetType::value_type FieldType;
+	typedef PsimagLite::Matrix<FieldType> MatrixType;
+	typedef typename PsimagLite::Vector<FieldType>::Type VectorType;
+	typedef typename LeftRightSuperType::BasisWithOperatorsType BasisWithOperatorsType;
+	typedef typename BasisWithOperatorsType::SparseMatrixType SparseMatrixType;
+	typedef typename BasisWithOperatorsType::BasisType BasisType;
+	typedef FermionSign FermionSignType;
+
+	enum {LEFT_BRAKET=0,RIGHT_BRAKET=1};
+
+	CorrelationsInSituHelper()
+	    : lrs_(0),psi_(0),fs_(PsimagLite::Vector<SizeType>::Type())
+	{}
+
+	// pS is the system before the site was added
+	void setStep(const LeftRightSuperType& lrs,
+	             const BasisWithOperatorsType& pS,
+	             const VectorWithOffsetType& psi)
+	{
+		lrs_ = &lrs;
+		psi_ = &psi;
+		fs_ = FermionSignType(pS.electronsVector(BasisType::AFTER_TRANSFORM));
+	}
+
+	void setTransform(const SparseMatrixType& transform)
+	{
+		transform_ = transform;
+	}
+
+	const LeftRightSuperType& leftRightSuper(SizeType) const
+	{
+		assert(lrs_);
+		return *lrs_;
+	}
+
+	ProgramGlobals::DirectionEnum direction(SizeType) const
+	{
+		return ProgramGlobals::EXPAND_SYSTEM;
+	}
+
+	const FermionSignType& fermionicSignLeft(SizeType) const { return fs_; }
+
+	const VectorWithOffsetType& getVectorFromBracketId(SizeType, SizeType) const
+	{
+		assert(psi_);
+		return *psi_;
+	}
+
+	void setPointer(SizeType, SizeType) {}
+
+	// ret = T^\dagger O T, as DmrgSerializer::transform
+	void transform(SparseMatrixType& ret,const SparseMatrixType& O,SizeType)
+	{
+		transposeConjugate(workspace_.first,O);
+		multiply(workspace_.second,workspace_.first,transform_);
+		transposeConjugate(workspace_.first,workspace_.second);
+		multiply(ret,workspace_.first,transform_);
+	}
+
+private:
+
+	const LeftRightSuperType* lrs_;
+	const VectorWithOffsetType* psi_;
+	FermionSignType fs_;
+	SparseMatrixType transform_;
+	std::pair<SparseMatrixType,SparseMatrixType> workspace_;
+}; // class CorrelationsInSituHelper
+
+template<typename LeftRightSuperType, typename ModelType, typename VectorWithOffsetType>
+class CorrelationsInSitu {
+
+	typedef CorrelationsInSituHelper<LeftRightSuperType,VectorWithOffsetType> HelperType;
+	typedef CorrelationsSkeleton<HelperType,ModelType> CorrelationsSkeletonType;
+	typedef typename CorrelationsSkeletonType::BraketType BraketType;
+	typedef typename HelperType::BasisWithOperatorsType BasisWithOperatorsType;
+	typedef typename HelperType::BasisType BasisType;
+	typedef typename HelperType::FieldType FieldType;
+	typedef typename PsimagLite::Vector<FieldType>::Type VectorFieldType;
+	typedef PsimagLite::Vector<bool>::Type VectorBoolType;
+	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
+
+public:
+
+	typedef typename HelperType::SparseMatrixType SparseMatrixType;
+
+	CorrelationsInSitu(const ModelType& model)
+	    : skeleton_(helper_,model),
+	      sites_(model.geometry().numberOfSites()),
+	      pending_(false)
+	{
+		VectorStringType vecStr;
+		PsimagLite::split(vecStr, model.params().inSituTwoPoint, ",");
+		if (vecStr.size() == 0) return;
+
+		if (model.params().sitesPerBlock != 1 || BasisType::useSu2Symmetry())
+			err("InSituTwoPoint: needs SitesPerBlock=1 and no SU(2)\n");
+
+		rows_.resize(vecStr.size());
+		for (SizeType i = 0; i < vecStr.size(); ++i)
+			rows_[i].init(model, vecStr[i], sites_);
+	}
+
+	bool enabled() const { return (rows_.size() > 0); }
+
+	// At the step that adds a site to the system, after the diagonalization:
+	// pS is the system before the site was added, psi the ground state
+	void measure(const LeftRightSuperType& lrs,
+	             const BasisWithOperatorsType& pS,
+	             const VectorWithOffsetType& psi)
+	{
+		if (!enabled()) return;
+
+		helper_.setStep(lrs,pS,psi);
+		const typename BasisType::BlockType& block = lrs.left().block();
+		SizeType s = block[block.size() - 1];
+		bool corner = (lrs.right().block().size() == 1 &&
+		               lrs.right().block()[0] == sites_ - 1);
+		SizeType threadId = 0;
+		SizeType ns = 0; // the step is set, so unused
+
+		SparseMatrixType identityBlock;
+		identityBlock.makeDiagonal(pS.size(),1.0);
+		SparseMatrixType identitySite;
+		identitySite.makeDiagonal(lrs.left().size()/pS.size(),1.0);
+		SparseMatrixType tmp;
+
+		for (SizeType x = 0; x < rows_.size(); ++x) {
+			Row& row = rows_[x];
+			SizeType r = row.site;
+			int sign = row.fermionSign;
+			row.grown = false;
+
+			if (r == 0 && s == 1) { // the system is site 0 alone
+				skeleton_.dmrgMultiply(tmp,row.AB,identitySite,1,ns,threadId);
+				row.set(0,skeleton_.bracket(tmp,1,threadId));
+				row.carried = row.A;
+				row.carrying = true;
+			}
+
+			if (s == r) {
+				skeleton_.dmrgMultiply(tmp,identityBlock,row.AB,1,ns,threadId);
+				row.set(r,skeleton_.bracket(tmp,1,threadId));
+				if (corner)
+					row.set(sites_ - 1,skeleton_.bracketRightCorner(identityBlock,
+					                                                row.A,
+					                                                row.B,
+					                                                sign,
+					                                                threadId));
+				skeleton_.dmrgMultiply(row.grownA,identityBlock,row.A,sign,ns,threadId);
+				row.grown = true;
+			} else if (row.carrying && s > r) {
+				skeleton_.dmrgMultiply(tmp,row.carried,row.B,sign,ns,threadId);
+				row.set(s,skeleton_.bracket(tmp,sign,threadId));
+				if (corner)
+					row.set(sites_ - 1,skeleton_.bracketRightCorner(row.carried,
+					                                                row.B,
+					                                                sign,
+					                                                threadId));
+				skeleton_.dmrgMultiply(row.grownA,row.carried,identitySite,1,ns,threadId);
+				row.grown = true;
+			}
+
+			if (corner && r == sites_ - 1)
+				row.set(r,skeleton_.bracketRightCorner(identityBlock,
+				                                       identitySite,
+				                                       row.AB,
+				                                       1,
+				                                       threadId));
+
+			if (row.grown) pending_ = true;
+		}
+	}
+
+	// After the truncation of the step: carries the operators grown by
+	// measure to the new basis of the system
+	template<typename TransformType>
+	void advance(const TransformType& transform)
+	{
+		if (!pending_) return;
+		pending_ = false;
+
+		SparseMatrixType t;
+		transform.toSparse(t);
+		helper_.setTransform(t);
+		SizeType threadId = 0;
+		for (SizeType x = 0; x < rows_.size(); ++x) {
+			Row& row = rows_[x];
+			if (!row.grown) continue;
+			helper_.transform(row.carried,row.grownA,threadId);
+			row.carrying = true;
+			row.grown = false;
+			row.grownA = SparseMatrixType();
+		}
+	}
+
+	// Writes, for each braket, the sites j and <A_r B_j> that were measured
+	void write(PsimagLite::String file, SizeType precision) const
+	{
+		if (!enabled()) return;
+
+		std::ofstream fout(file.c_str());
+		if (!fout || !fout.good())
+			err("CorrelationsInSitu: cannot write to " + file + "\n");
+
+		fout.precision(precision);
+		SizeType missing = 0;
+		for (SizeType x = 0; x < rows_.size(); ++x) {
+			const Row& row = rows_[x];
+			fout<<row.name<<"\n";
+			for (SizeType j = row.site; j < sites_; ++j) {
+				if (!row.measured[j]) {
+					missing++;
+					continue;
+				}
+
+				fout<<j<<" "<<row.values[j]<<"\n";
+			}
+		}
+
+		fout.close();
+
+		PsimagLite::OstringStream msg;
+		msg<<"Wrote "<<rows_.size()<<" in-situ correlations to "<<file;
+		if (missing > 0)
+			msg<<"; "<<missing<<" sites were not reached by the last loop";
+		PsimagLite::ProgressIndicator progress("CorrelationsInSitu");
+		progress.printline(msg,std::cout);
+	}
+
+private:
+
+	struct Row {
+
+		void init(const ModelType& model,
+		          const PsimagLite::String& braketString,
+		          SizeType sites)
+		{
+			BraketType braket(model,braketString);
+			if (braket.points() != 2 || braket.bra() != "gs" || braket.ket() != "gs")
+				err("InSituTwoPoint: " + braketString + " is not <gs|A[site];B|gs>\n");
+
+			name = braketString;
+			site = braket.site(0);
+			if (site >= sites)
+				err("InSituTwoPoint: site out of range in " + braketString + "\n");
+
+			A = braket.op(0).data;
+			B = braket.op(1).data;
+			AB = A*B;
+			fermionSign = braket.op(0).fermionSign;
+			carrying = grown = false;
+			values.resize(sites,0.0);
+			measured.resize(sites,false);
+		}
+
+		void set(SizeType j, const FieldType& value)
+		{
+			values[j] = value;
+			measured[j] = true;
+		}
+
+		PsimagLite::String name;
+		SizeType site;
+		SparseMatrixType A;
+		SparseMatrixType B;
+		SparseMatrixType AB;
+		int fermionSign;
+		// A at site, in the basis of the system, once the loop has passed site
+		SparseMatrixType carried;
+		bool carrying;
+		// carried, or A at site, in the basis of the system and the added site
+		SparseMatrixType grownA;
+		bool grown;
+		VectorFieldType values;
+		VectorBoolType measured;
+	};
+
+	typedef typename PsimagLite::Vector<Row>::Type VectorRowType;
+
+	CorrelationsInSitu(const CorrelationsInSitu&);
+
+	CorrelationsInSitu& operator=(const CorrelationsInSitu&);
+
+	HelperType helper_;
+	CorrelationsSkeletonType skeleton_;
+	SizeType sites_;
+	bool pending_;
+	VectorRowType rows_;
+}; // class CorrelationsInSitu
+
+} // namespace Dmrg
+
+#endif // CORRELATIONSINSITU_H
@@ -87,6 +87,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "ApplyOperatorLocal.h"
 #include "Braket.h"
 #include <numeric>
+#include <algorithm>
 
 namespace Dmrg {
 
@@ -131,6 +132,9 @@ public:
 	typedef PsimagLite::Profiling ProfilingType;
 	typedef typename BasisWithOperatorsType::OperatorType OperatorType;
 	typedef PsimagLite::CrsMatrix<FieldType> SparseMatrixType;
+	typedef typename PsimagLite::Vector<SparseMatrixType>::Type VectorSparseMatrixType;
+	typedef PsimagLite::Vector<int>::Type VectorIntType;
+	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
 
 	enum {GROW_RIGHT,GROW_LEFT};
 
@@ -166,10 +170,11 @@ public:
 		int nt=i-1;
 		if (nt<0) nt=0;
 
+		// fluffUp overwrites Onew, which keeps its storage across steps
+		SparseMatrixType Onew;
 		for (SizeType s=nt;s<ns;s++) {
 			helper_.setPointer(threadId,s);
 			SizeType growOption = growthDirection(s,nt,i,threadId);
-			SparseMatrixType Onew(helper_.columns(threadId),helper_.columns(threadId));
 
 			fluffUp(Onew,Odest,fermionicSign,growOption,false,threadId);
 			if (!transform && s == ns-1) {
@@ -208,6 +213,28 @@ public:
 		fluffUpEnviron(ret2,O,fermionicSign,growOption,transform,threadId);
 	}
 
+	// fluffUp of several operators of the same size, without transform
+	void fluffUp(VectorSparseMatrixType& rets,
+	             const VectorSparseMatrixType& Os,
+	             const VectorIntType& fermionicSigns,
+	             int growOption,
+	             SizeType threadId)
+	{
+		SizeType ops = Os.size();
+		assert(fermionicSigns.size() == ops);
+		rets.resize(ops);
+		if (ops == 0) return;
+
+		bool system = (helper_.direction(threadId)==EXPAND_SYSTEM);
+		const BasisType& basis = (system) ? helper_.leftRightSuper(threadId).left() :
+		                                    helper_.leftRightSuper(threadId).right();
+		VectorRealType signs;
+		for (SizeType x=0;x<ops;x++) {
+			fluffUpSigns(signs,Os[x].rows(),fermionicSigns[x],growOption,system,threadId);
+			fluffUpSparse(rets[x],Os[x],basis,growOption,signs);
+		}
+	}
+
 	void dmrgMultiply(SparseMatrixType& result,
 	                  const SparseMatrixType& O1,
 	                  const SparseMatrixType& O2,
@@ -316,35 +343,33 @@ private:
 			throw PsimagLite::RuntimeError("problem in dmrgMultiply\n");
 		}
 
-		PsimagLite::Vector<SizeType>::Type col(sprime,0);
-		typename PsimagLite::Vector<FieldType>::Type value(sprime,0);
+		const BasisType& basis = helper_.leftRightSuper(threadId).left();
+		const FermionSignType& fs = helper_.fermionicSignLeft(threadId);
+		VectorSizeType col(sprime,0);
+		VectorSizeType cols;
+		VectorType value(sprime,0);
 
 		PackIndicesType pack(ni);
 
 		SizeType counter = 0;
 		for (SizeType r=0;r<sprime;r++) {
 			SizeType e,u;
-			pack.unpack(e,u,helper_.leftRightSuper(threadId).left().permutation(r));
-			RealType f = helper_.fermionicSignLeft(threadId)(e,fermionicSign);
+			pack.unpack(e,u,basis.permutation(r));
+			RealType f = fs(e,fermionicSign);
 			result.setRow(r,counter);
 			for (int k=O1.getRowPtr(e);k<O1.getRowPtr(e+1);k++) {
 				SizeType e2 = O1.getCol(k);
 				for (int k2=O2.getRowPtr(u);k2<O2.getRowPtr(u+1);k2++) {
 					SizeType u2 = O2.getCol(k2);
-					SizeType r2 = helper_.leftRightSuper(threadId).left().
-					        permutationInverse(e2 + u2*ni);
+					SizeType r2 = basis.permutationInverse(e2 + u2*ni);
 					value[r2] += O1.getValue(k)*O2.getValue(k2)*f;
+					if (col[r2] == 1) continue;
 					col[r2] = 1;
+					cols.push_back(r2);
 				}
 			}
-			for (SizeType i=0;i<col.size();i++) {
-				if (col[i]==0) continue;
-				result.pushCol(i);
-				result.pushValue(value[i]);
-				counter++;
-				value[i] = 0.0;
-				col[i] = 0;
-			}
+
+			pushRow(result,counter,cols,col,value);
 		}
 		result.setRow(result.rows(),counter);
 		result.checkValidity();
@@ -371,8 +396,10 @@ private:
 			throw PsimagLite::RuntimeError("problem in dmrgMultiply\n");
 		}
 
-		PsimagLite::Vector<SizeType>::Type col(eprime,0);
-		typename PsimagLite::Vector<FieldType>::Type value(eprime,0);
+		const BasisType& basis = helper_.leftRightSuper(threadId).right();
+		VectorSizeType col(eprime,0);
+		VectorSizeType cols;
+		VectorType value(eprime,0);
 
 		PackIndicesType pack(nj);
 
@@ -381,28 +408,22 @@ private:
 			result.setRow(r,counter);
 			SizeType e,u;
 
-			pack.unpack(e,u,helper_.leftRightSuper(threadId).right().permutation(r));
+			pack.unpack(e,u,basis.permutation(r));
 
 			for (int k=O2.getRowPtr(e);k<O2.getRowPtr(e+1);k++) {
 				SizeType e2 = O2.getCol(k);
 				for (int k2=O1.getRowPtr(u);k2<O1.getRowPtr(u+1);k2++) {
 					SizeType u2 = O1.getCol(k2);
-					SizeType r2 = helper_.leftRightSuper(threadId).right().
-					        permutationInverse(e2 + u2*nj);
+					SizeType r2 = basis.permutationInverse(e2 + u2*nj);
 					assert(r2<eprime);
-					col[r2] = 1;
 					value[r2] += O2.getValue(k)*O1.getValue(k2)*f;
+					if (col[r2] == 1) continue;
+					col[r2] = 1;
+					cols.push_back(r2);
 				}
 			}
 
-			for (SizeType i=0;i<col.size();i++) {
-				if (col[i]==0) continue;
-				result.pushCol(i);
-				result.pushValue(value[i]);
-				counter++;
-				value[i] = 0.0;
-				col[i] = 0;
-			}
+			pushRow(result,counter,cols,col,value);
 		}
 
 		result.setRow(result.rows(),counter);
@@ -417,23 +438,18 @@ private:
 	                   bool transform,
 	                   SizeType threadId)
 	{
-		SizeType n =helper_.leftRightSuper(threadId).left().size();
-
-		MatrixType ret(n,n);
-
-		for (SizeType e=0;e<n;e++) {
-			for (SizeType e2=0;e2<n;e2++) {
-				ret(e,e2) = fluffUpSystem_(O,e,e2,fermionicSign,growOption,threadId);
-			}
-		}
+		const BasisType& basis = helper_.leftRightSuper(threadId).left();
+		VectorRealType signs;
+		fluffUpSigns(signs,O.rows(),fermionicSign,growOption,true,threadId);
 
 		if (transform) {
-			SparseMatrixType ret3(ret);
+			SparseMatrixType ret3;
+			fluffUpSparse(ret3,O,basis,growOption,signs);
 			helper_.transform(ret2,ret3,threadId);
 			return;
 		}
 
-		fullMatrixToCrsMatrix(ret2,ret);
+		fluffUpSparse(ret2,O,basis,growOption,signs);
 	}
 
 	// Perfomance critical:
@@ -444,88 +460,114 @@ private:
 	                    bool transform,
 	                    SizeType threadId)
 	{
-		SizeType n =helper_.leftRightSuper(threadId).right().size();
+		const BasisType& basis = helper_.leftRightSuper(threadId).right();
+		VectorRealType signs;
+		fluffUpSigns(signs,O.rows(),fermionicSign,growOption,false,threadId);
 
-		MatrixType ret(n,n);
-		for (SizeType e=0;e<n;e++) {
-			for (SizeType e2=0;e2<n;e2++) {
-				ret(e,e2) = fluffUpEnviron_(
-				            O,e,e2,fermionicSign,growOption,threadId);
-			}
-		}
 		if (transform) {
-			SparseMatrixType ret3(ret);
+			SparseMatrixType ret3;
+			fluffUpSparse(ret3,O,basis,growOption,signs);
 			helper_.transform(ret2,ret3,threadId);
 			return;
 		}
 
-		fullMatrixToCrsMatrix(ret2,ret);
+		fluffUpSparse(ret2,O,basis,growOption,signs);
 	}
 
-	// Perfomance critical:
-	FieldType fluffUpSystem_(const SparseMatrixType& O,
-	                         SizeType e,
-	                         SizeType e2,
-	                         int fermionicSign,
-	                         int growOption,
-	                         SizeType threadId)
+	// signs[k] is the sign of O grown with the state k of the other space
+	void fluffUpSigns(VectorRealType& signs,
+	                  SizeType n,
+	                  int fermionicSign,
+	                  int growOption,
+	                  bool system,
+	                  SizeType threadId)
 	{
-		SizeType n = O.rows();
-		SizeType m = SizeType(helper_.leftRightSuper(threadId).left().size()/n);
-		RealType sign = static_cast<RealType>(1.0);
-
-		// Sperm[e] = i +k*n or e= k + i*m
-		// Sperm[e2] = j+k*n or e2=k+j*m
-		SizeType i,j,k,k2;
-		if (growOption==GROW_RIGHT) {
-			if (SizeType(helper_.leftRightSuper(threadId).left().permutation(e)/n)!=
-			    SizeType(helper_.leftRightSuper(threadId).left().permutation(e2)/n))
-				return 0;
-			PackIndicesType pack(n);
-			pack.unpack(i,k,helper_.leftRightSuper(threadId).left().permutation(e));
-			pack.unpack(j,k2,helper_.leftRightSuper(threadId).left().permutation(e2));
-		} else {
-			if (SizeType(helper_.leftRightSuper(threadId).left().permutation(e)%m)!=
-			    SizeType(helper_.leftRightSuper(threadId).left().permutation(e2)%m))
-				return 0;
-			PackIndicesType pack(m);
-			pack.unpack(k,i,helper_.leftRightSuper(threadId).left().permutation(e));
-			pack.unpack(k2,j,helper_.leftRightSuper(threadId).left().permutation(e2));
-			sign = helper_.fermionicSignLeft(threadId)(k,fermionicSign);
+		const BasisType& basis = (system) ? helper_.leftRightSuper(threadId).left() :
+		                                    helper_.leftRightSuper(threadId).right();
+		SizeType m = basis.size()/n;
+		signs.resize(m);
+
+		if (system) {
+			const FermionSignType& fs = helper_.fermionicSignLeft(threadId);
+			for (SizeType k=0;k<m;k++)
+				signs[k] = (growOption==GROW_RIGHT) ? 1 : fs(k,fermionicSign);
+			return;
 		}
-		if (k!=k2) return 0;
-		return O.element(i,j)*sign;
+
+		const BasisType& b = (growOption==GROW_RIGHT) ?
+		            helper_.leftRightSuper(threadId).left() :
+		            helper_.leftRightSuper(threadId).super();
+		std::fill(signs.begin(),signs.end(),fermionSignBasis(fermionicSign,b));
 	}
 
 	// Perfomance critical:
-	FieldType fluffUpEnviron_(const SparseMatrixType& O,
-	                          SizeType e,SizeType e2,
-	                          int fermionicSign,
-	                          int growOption,
-	                          SizeType threadId)
+	// ret is O grown to basis, whose states before the permutation are
+	// i + k*n for GROW_RIGHT or k + i*m for GROW_LEFT, i a state of O and
+	// k one of the other space. ret is block diagonal in k, and within the
+	// block of k it is O times signs[k]; only the nonzeros of O are visited
+	// for each k, so that the work is proportional to that of the result
+	void fluffUpSparse(SparseMatrixType& ret,
+	                   const SparseMatrixType& O,
+	                   const BasisType& basis,
+	                   int growOption,
+	                   const VectorRealType& signs) const
 	{
+		SizeType total = basis.size();
 		SizeType n = O.rows();
-		SizeType m = SizeType(helper_.leftRightSuper(threadId).right().size()/n);
-		RealType sign = 1;
-
-		// Eperm[e] = i +k*n or e= k + i*m
-		// Eperm[e2] = j+k*n or e2=k+j*m
-
-		SizeType i,j,k,k2;
-
-		if (growOption==GROW_RIGHT) {
-			PackIndicesType pack(n);
-			pack.unpack(i,k,helper_.leftRightSuper(threadId).right().permutation(e));
-			pack.unpack(j,k2,helper_.leftRightSuper(threadId).right().permutation(e2));
-			sign = fermionSignBasis(fermionicSign, helper_.leftRightSuper(threadId).left());
-		} else {
-			PackIndicesType pack(m);
-			pack.unpack(k,i,helper_.leftRightSuper(threadId).right().permutation(e));
-			pack.unpack(k2,j,helper_.leftRightSuper(threadId).right().permutation(e2));
-			sign = fermionSignBasis(fermionicSign,  helper_.leftRightSuper(threadId).super());
+		SizeType m = total/n;
+		assert(signs.size() == m);
+		PackIndicesType pack((growOption==GROW_RIGHT) ? n : m);
+
+		VectorSizeType col(total,0);
+		VectorSizeType cols;
+		VectorType value(total,0);
+
+		ret.resize(total,total);
+		SizeType counter = 0;
+		for (SizeType e=0;e<total;e++) {
+			ret.setRow(e,counter);
+			SizeType i = 0;
+			SizeType k = 0;
+			if (growOption==GROW_RIGHT) pack.unpack(i,k,basis.permutation(e));
+			else pack.unpack(k,i,basis.permutation(e));
+
+			for (int kk=O.getRowPtr(i);kk<O.getRowPtr(i+1);kk++) {
+				if (O.getValue(kk) == static_cast<RealType>(0.0)) continue;
+				SizeType j = O.getCol(kk);
+				SizeType e2 = (growOption==GROW_RIGHT) ? j + k*n : k + j*m;
+				e2 = basis.permutationInverse(e2);
+				value[e2] = O.getValue(kk)*signs[k];
+				col[e2] = 1;
+				cols.push_back(e2);
+			}
+
+			pushRow(ret,counter,cols,col,value);
+		}
+
+		ret.setRow(total,counter);
+		ret.checkValidity();
+	}
+
+	// Pushes the row whose nonzeros are in the columns cols, with values
+	// in value, in increasing order of column; then clears cols, and col
+	// and value for those columns, for the next row
+	static void pushRow(SparseMatrixType& result,
+	                    SizeType& counter,
+	                    VectorSizeType& cols,
+	                    VectorSizeType& col,
+	                    VectorType& value)
+	{
+		std::sort(cols.begin(),cols.end());
+		for (SizeType x=0;x<cols.size();x++) {
+			SizeType c = cols[x];
+			result.pushCol(c);
+			result.pushValue(value[c]);
+			counter++;
+			value[c] = 0.0;
+			col[c] = 0;
 		}
 
-		return (k != k2) ? 0 : O.element(i,j)*sign;
+		cols.clear();
 	}
 
 	FieldType bracket_(const SparseMatrixType& A,
@@ -319,9 +319,9 @@ class DensityMatrixSvd : public DensityMatrixBase<TargettingType> {
 					assert(!expandSys || (i < nl && j < lrs_.right().size()));
 					assert(expandSys || (j < nl && i < lrs_.right().size()));
 
-					assert(ij < lrs_.super().permutationInverse().size());
+					assert(ij < lrs_.super().size());
 
-					SizeType r = lrs_.super().permutationInverse()[ij];
+					SizeType r = lrs_.super().permutationInverse(ij);
 					if (r < offset || r >= offset + v_.effectiveSize(m))
 						continue;
 
@@ -76,31 +76,78 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Stack.h"
 #include "IoSimple.h"
 #include "ProgressIndicator.h"
+#include "DiskStackBinaryFile.h"
 
 // A disk stack, similar to std::stack but stores in disk not in memory
+// In binary mode each entry is written once as a raw, optionally compressed,
+// record, and an index lets top() read only the entry it needs;
+// see DiskStackBinaryFile.h.
+// With setAsync(depth, budget) entries are written in the background and the
+// next depth entries to be popped are loaded while the current one is in use.
 namespace Dmrg {
 template<typename DataType>
 class DiskStack {
 
 	typedef typename PsimagLite::IoSimple::In IoInType;
 	typedef typename PsimagLite::IoSimple::Out IoOutType;
+	typedef DiskStackBinaryFile<DataType> DiskStackBinaryFileType;
+	typedef typename DiskStackBinaryFileType::VectorSizeType VectorSizeType;
+	typedef DiskStackBinaryOut::VectorCharType VectorCharType;
+	typedef PsimagLite::Stack<int>::Type StackType;
+
+	// std::stack keeps its container protected; this reads it in place
+	class StackContainer : public StackType {
+
+	public:
+
+		typedef StackType::container_type ContainerType;
+
+		static const ContainerType& get(const StackType& st)
+		{
+			return st.*(&StackContainer::c);
+		}
+	};
 
 public:
 
+	typedef typename DiskStackBinaryFileType::StatsType StatsType;
+
 	DiskStack(const PsimagLite::String &file1,
 	          const PsimagLite::String &file2,
 	          bool hasLoad,
-	          bool isObserveCode)
+	          bool isObserveCode,
+	          bool isBinary = false,
+	          bool isCompressed = false)
 	    : fileIn_(file1),
 	      fileOut_(file2),
 	      isObserveCode_(isObserveCode),
+	      isBinary_(isBinary),
 	      total_(0),
 	      progress_("DiskStack"),
+	      binaryFile_(0),
 	      dt_(0)
 	{
 		unlink(fileOut_.c_str());
+		if (isBinary_)
+			binaryFile_ = new DiskStackBinaryFileType(fileIn_,
+			                                          fileOut_,
+			                                          isObserveCode_,
+			                                          isCompressed);
+
 		if (!hasLoad) return;
 
+		if (isBinary_) {
+			VectorSizeType ids;
+			binaryFile_->loadFooter(ids);
+			for (SizeType i = 0; i < ids.size(); ++i)
+				stack_.push(ids[i]);
+
+			PsimagLite::OstringStream msg;
+			msg<<"Attempt to read from file " + fileIn_ + " succeeded";
+			progress_.printline(msg,std::cout);
+			return;
+		}
+
 		try {
 			ioIn_.open(fileIn_);
 		} catch (std::exception& e) {
@@ -121,10 +168,32 @@ public:
 	{
 		delete dt_;
 		dt_ = 0;
+		delete binaryFile_;
+		binaryFile_ = 0;
+	}
+
+	// depth entries are prefetched, and at most budget bytes are queued for writing
+	void setAsync(SizeType depth, SizeType budget)
+	{
+		if (depth == 0 && budget == 0) return;
+		if (!binaryFile_) {
+			std::cerr<<"WARNING: DiskStack prefetch and write queue need binaryStacks\n";
+			return;
+		}
+
+		binaryFile_->startThread(depth, budget);
 	}
 
 	void finalize()
 	{
+		if (isBinary_) {
+			const typename StackContainer::ContainerType& c = StackContainer::get(stack_);
+			VectorSizeType ids(c.begin(), c.end());
+
+			binaryFile_->finalize(ids);
+			return;
+		}
+
 		ioOut_.open(fileOut_,std::ios_base::app);
 		finalizeInternal(ioOut_, "#STACKMETASTACK\n");
 		ioOut_.close();
@@ -136,6 +205,11 @@ public:
 
 	void push(DataType const &d)
 	{
+		if (isBinary_) {
+			pushBinary(d);
+			return;
+		}
+
 		ioOut_.open(fileOut_,std::ios_base::app);
 		d.save(ioOut_,DataType::SAVE_ALL);
 		ioOut_.close();
@@ -151,10 +225,16 @@ public:
 
 	const DataType& top() const
 	{
-		ioIn_.open(fileIn_);
 		if (dt_) delete dt_;
 		dt_ = 0;
 		assert(stack_.size() > 0);
+		if (isBinary_) {
+			dt_ = binaryFile_->take(stack_.top());
+			prefetchNext();
+			return *dt_;
+		}
+
+		ioIn_.open(fileIn_);
 		dt_ = new DataType(ioIn_,"",stack_.top(),isObserveCode_);
 		ioIn_.close();
 		return *dt_;
@@ -162,8 +242,17 @@ public:
 
 	SizeType size() const { return stack_.size(); }
 
+	// Adds the compression statistics since the last call to stats
+	void takeStats(StatsType& stats) const
+	{
+		if (binaryFile_) binaryFile_->takeStats(stats);
+	}
+
 	void copyFromIo(PsimagLite::IoSimple::In& io, PsimagLite::String label)
 	{
+		if (isBinary_)
+			err("DiskStack::copyFromIo(): not supported for binary stacks\n");
+
 		std::cerr<<"WARNING: EXPECT A CRASH SOON!\n";
 		std::ofstream fout(fileIn_.c_str());
 		io.rewind();
@@ -194,6 +283,19 @@ public:
 
 		io<<label<<"\n";
 		io<<stack_.size()<<"\n";
+		if (isBinary_) {
+			binaryFile_->flush();
+			while (!stack_.empty()) {
+				DataType* dt = binaryFile_->take(stack_.top());
+				io<<"#NAME=\n";
+				io<<(*dt);
+				delete dt;
+				stack_.pop();
+			}
+
+			return;
+		}
+
 		ioIn_.open(fileIn_);
 		while (!stack_.empty()) {
 			DataType dt(ioIn_,"",stack_.top(),isObserveCode_);
@@ -209,8 +311,22 @@ public:
 	friend void copyDiskToDisk(DiskStack& dest, const DiskStack& src)
 	{
 		dest.isObserveCode_ = src.isObserveCode_;
+		dest.isBinary_ = src.isBinary_;
 		dest.total_ = src.total_;
 		dest.stack_ = src.stack_;
+		delete dest.binaryFile_;
+		dest.binaryFile_ = 0;
+		if (src.binaryFile_) {
+			src.binaryFile_->flush();
+			dest.binaryFile_ = new DiskStackBinaryFileType(dest.fileIn_,
+			                                               dest.fileOut_,
+			                                               dest.isObserveCode_,
+			                                               false);
+			dest.binaryFile_->copyIndex(*(src.binaryFile_));
+			dest.binaryFile_->startThread(src.binaryFile_->depth(),
+			                              src.binaryFile_->budget());
+		}
+
 		// copy src.fileIn_ --> dest.fileIn_
 		myCopy(src.fileIn_, dest.fileIn_);
 		// copy src.fileOut_ --> dest.fileOut_
@@ -248,6 +364,32 @@ private:
 		io.print(label, stack_);
 	}
 
+	void pushBinary(const DataType& d)
+	{
+		DiskStackBinaryOut io;
+		d.save(io,DataType::SAVE_ALL);
+		VectorCharType buffer;
+		io.swap(buffer);
+		SizeType id = binaryFile_->write(buffer);
+
+		stack_.push(id);
+		total_++;
+	}
+
+	// the entries below the top are the ones that the next pops will expose
+	void prefetchNext() const
+	{
+		SizeType depth = binaryFile_->depth();
+		if (depth == 0) return;
+
+		const typename StackContainer::ContainerType& c = StackContainer::get(stack_);
+		VectorSizeType wanted;
+		for (SizeType i = c.size(); i > 1 && wanted.size() < depth; --i)
+			wanted.push_back(c[i - 2]);
+
+		binaryFile_->prefetch(wanted);
+	}
+
 	void invertStack(PsimagLite::Stack<int>::Type& st)
 	{
 		PsimagLite::Stack<int>::Type tmp;
@@ -263,8 +405,10 @@ private:
 	PsimagLite::String fileIn_;
 	PsimagLite::String fileOut_;
 	bool isObserveCode_;
+	bool isBinary_;
 	int total_;
 	PsimagLite::ProgressIndicator progress_;
+	DiskStackBinaryFileType* binaryFile_;
 	mutable IoInType ioIn_;
 	IoOutType ioOut_;
 	PsimagLite::Stack<int>::Type stack_;
@@ -0,0 +1,465 @@
+#ifndef DISKSTACKBINARY_H
+#define DISKSTACKBINARY_H
+#include <complex>
+#include <cstring>
+#include <sstream>
+#include "Vector.h"
+#include "Matrix.h"
+#include "CrsMatrix.h"
+#include "IoSimple.h"
+#include "Su2Related.h"
+#include "Operator.h"
+#include "BlockDiagonalMatrix.h"
+
+/* In-memory binary serialization of one DiskStack entry
+
+   DiskStackBinaryOut and DiskStackBinaryIn provide the subset of the
+   IoSimple interface that the save functions and the loading constructors
+   of BasisWithOperators, BlockDiagonalMatrix and DmrgSerializer use.
+   The buffer is a sequence of records, each a length-prefixed label
+   followed by the byte size of its payload and the payload itself.
+   Lines have an empty payload; numbers, vectors, dense and CRS matrices
+   are stored as raw little-endian arrays. Like the text reader, the
+   reader finds labels by prefix and skips the records it is not asked for.
+   The reader does not copy its input, which may be a vector or any
+   contiguous bytes, such as a record of a memory-mapped file.
+*/
+namespace Dmrg {
+
+class DiskStackBinaryOut {
+
+public:
+
+	typedef PsimagLite::Vector<char>::Type VectorCharType;
+
+	DiskStackBinaryOut() { checkEndianness(); }
+
+	const VectorCharType& buffer() const { return buffer_; }
+
+	void swap(VectorCharType& buffer) { buffer_.swap(buffer); }
+
+	void printline(const PsimagLite::String& s) { writeRecord(s); }
+
+	void print(const PsimagLite::String& s) { writeRecord(s); }
+
+	template<typename T>
+	void printVector(const T& v, const PsimagLite::String& label)
+	{
+		SizeType start = beginRecord(label);
+		write(v);
+		endRecord(start);
+	}
+
+	template<typename T>
+	void printMatrix(const T& m, const PsimagLite::String& label)
+	{
+		SizeType start = beginRecord(label);
+		write(m);
+		endRecord(start);
+	}
+
+	DiskStackBinaryOut& operator<<(const char* s)
+	{
+		writeRecord(s);
+		return *this;
+	}
+
+	DiskStackBinaryOut& operator<<(const PsimagLite::String& s)
+	{
+		writeRecord(s);
+		return *this;
+	}
+
+	template<typename T>
+	DiskStackBinaryOut& operator<<(const T& x)
+	{
+		SizeType start = beginRecord("");
+		write(x);
+		endRecord(start);
+		return *this;
+	}
+
+	void write(bool x) { writeRaw(&x, 1); }
+
+	void write(int x) { writeRaw(&x, 1); }
+
+	void write(unsigned int x) { writeRaw(&x, 1); }
+
+	void write(long x) { writeRaw(&x, 1); }
+
+	void write(unsigned long x) { writeRaw(&x, 1); }
+
+	void write(long long x) { writeRaw(&x, 1); }
+
+	void write(unsigned long long x) { writeRaw(&x, 1); }
+
+	void write(float x) { writeRaw(&x, 1); }
+
+	void write(double x) { writeRaw(&x, 1); }
+
+	template<typename T>
+	void write(const std::complex<T>& x) { writeRaw(&x, 1); }
+
+	void write(const PsimagLite::String& s)
+	{
+		writeSize(s.length());
+		writeRaw(s.c_str(), s.length());
+	}
+
+	template<typename T1, typename T2>
+	void write(const std::pair<T1, T2>& p)
+	{
+		write(p.first);
+		write(p.second);
+	}
+
+	template<typename T, typename A>
+	void write(const std::vector<T, A>& v)
+	{
+		writeSize(v.size());
+		for (SizeType i = 0; i < v.size(); ++i)
+			write(v[i]);
+	}
+
+	template<typename T>
+	void write(const PsimagLite::Matrix<T>& m)
+	{
+		writeSize(m.rows());
+		writeSize(m.cols());
+		if (m.rows() == 0 || m.cols() == 0) return;
+		writeRaw(&(m(0, 0)), m.rows()*m.cols());
+	}
+
+	template<typename T>
+	void write(const PsimagLite::CrsMatrix<T>& m)
+	{
+		SizeType rows = m.rows();
+		writeSize(rows);
+		writeSize(m.cols());
+		if (rows == 0) return;
+		SizeType nonzeros = m.getRowPtr(rows);
+		writeSize(nonzeros);
+		for (SizeType i = 0; i < rows + 1; ++i)
+			writeSize(m.getRowPtr(i));
+		for (SizeType k = 0; k < nonzeros; ++k)
+			writeSize(m.getCol(k));
+		for (SizeType k = 0; k < nonzeros; ++k)
+			write(m.getValue(k));
+	}
+
+	void write(const Su2Related& su2Related)
+	{
+		writeSize(su2Related.offset);
+		write(su2Related.source);
+		write(su2Related.transpose);
+	}
+
+	template<typename SparseMatrixType>
+	void write(const Operator<SparseMatrixType>& op)
+	{
+		write(op.data);
+		write(op.fermionSign);
+		write(op.jm);
+		write(op.angularFactor);
+		write(op.su2Related);
+	}
+
+	template<typename T>
+	void write(const BlockDiagonalMatrix<T>& m)
+	{
+		m.writeBinary(*this);
+	}
+
+private:
+
+	void writeRecord(const PsimagLite::String& label)
+	{
+		endRecord(beginRecord(label));
+	}
+
+	SizeType beginRecord(const PsimagLite::String& label)
+	{
+		write(label);
+		SizeType start = buffer_.size();
+		writeSize(0);
+		return start;
+	}
+
+	void endRecord(SizeType start)
+	{
+		unsigned long long bytes = buffer_.size() - start - sizeof(bytes);
+		memcpy(&(buffer_[start]), &bytes, sizeof(bytes));
+	}
+
+	template<typename T>
+	void writeRaw(const T* x, SizeType n)
+	{
+		SizeType bytes = n*sizeof(T);
+		SizeType start = buffer_.size();
+		buffer_.resize(start + bytes);
+		if (bytes > 0) memcpy(&(buffer_[start]), x, bytes);
+	}
+
+	void writeSize(SizeType x)
+	{
+		unsigned long long y = x;
+		writeRaw(&y, 1);
+	}
+
+	static void checkEndianness()
+	{
+		int one = 1;
+		if (*(reinterpret_cast<char*>(&one)) == 1) return;
+		err("DiskStackBinary: binary stacks need a little-endian host\n");
+	}
+
+	VectorCharType buffer_;
+}; // class DiskStackBinaryOut
+
+class DiskStackBinaryIn {
+
+public:
+
+	typedef PsimagLite::Vector<char>::Type VectorCharType;
+
+	DiskStackBinaryIn(const VectorCharType& buffer)
+	    : data_((buffer.size() > 0) ? &(buffer[0]) : 0),
+	      size_(buffer.size()),
+	      position_(0),
+	      payloadEnd_(0)
+	{}
+
+	DiskStackBinaryIn(const char* data, SizeType size)
+	    : data_(data), size_(size), position_(0), payloadEnd_(0)
+	{}
+
+	std::pair<PsimagLite::String, SizeType> advance(const PsimagLite::String& label,
+	                                                SizeType counter = 0)
+	{
+		if (counter != 0)
+			err("DiskStackBinaryIn::advance(): entries are read one at a time\n");
+
+		PsimagLite::String s = findRecord(label);
+		return std::pair<PsimagLite::String, SizeType>(s, 0);
+	}
+
+	template<typename T>
+	void readline(T& x, const PsimagLite::String& label)
+	{
+		PsimagLite::String s = findRecord(label);
+		std::istringstream is(s.substr(label.length()));
+		is>>x;
+	}
+
+	template<typename T>
+	void read(T& x, const PsimagLite::String& label)
+	{
+		findRecord(label);
+		readPayload(x, label);
+	}
+
+	template<typename T>
+	void readMatrix(T& m, const PsimagLite::String& label)
+	{
+		read(m, label);
+	}
+
+	template<typename T>
+	DiskStackBinaryIn& operator>>(T& x)
+	{
+		findRecord("");
+		readPayload(x, "");
+		return *this;
+	}
+
+	void read(bool& x) { readRaw(&x, 1); }
+
+	void read(int& x) { readRaw(&x, 1); }
+
+	void read(unsigned int& x) { readRaw(&x, 1); }
+
+	void read(long& x) { readRaw(&x, 1); }
+
+	void read(unsigned long& x) { readRaw(&x, 1); }
+
+	void read(long long& x) { readRaw(&x, 1); }
+
+	void read(unsigned long long& x) { readRaw(&x, 1); }
+
+	void read(float& x) { readRaw(&x, 1); }
+
+	void read(double& x) { readRaw(&x, 1); }
+
+	template<typename T>
+	void read(std::complex<T>& x) { readRaw(&x, 1); }
+
+	void read(PsimagLite::String& s)
+	{
+		SizeType n = readSize();
+		checkAvailable(n);
+		s = PsimagLite::String(data_ + position_, n);
+		position_ += n;
+	}
+
+	template<typename T1, typename T2>
+	void read(std::pair<T1, T2>& p)
+	{
+		read(p.first);
+		read(p.second);
+	}
+
+	template<typename T, typename A>
+	void read(std::vector<T, A>& v)
+	{
+		SizeType n = readSize();
+		v.clear();
+		v.resize(n);
+		for (SizeType i = 0; i < n; ++i)
+			read(v[i]);
+	}
+
+	template<typename T>
+	void read(PsimagLite::Matrix<T>& m)
+	{
+		SizeType rows = readSize();
+		SizeType cols = readSize();
+		m.resize(rows, cols);
+		if (rows == 0 || cols == 0) return;
+		readRaw(&(m(0, 0)), rows*cols);
+	}
+
+	template<typename T>
+	void read(PsimagLite::CrsMatrix<T>& m)
+	{
+		SizeType rows = readSize();
+		SizeType cols = readSize();
+		m.clear();
+		m.resize(rows, cols);
+		if (rows == 0) return;
+
+		SizeType nonzeros = readSize();
+
+		PsimagLite::Vector<SizeType>::Type rowptr(rows + 1);
+		for (SizeType i = 0; i < rows + 1; ++i)
+			rowptr[i] = readSize();
+
+		SizeType colStart = position_;
+		checkAvailable(nonzeros*sizeof(unsigned long long));
+		position_ += nonzeros*sizeof(unsigned long long);
+		for (SizeType i = 0; i < rows; ++i) {
+			m.setRow(i, rowptr[i]);
+			for (SizeType k = rowptr[i]; k < rowptr[i + 1]; ++k) {
+				T value;
+				read(value);
+				m.pushValue(value);
+				m.pushCol(sizeAt(colStart, k));
+			}
+		}
+
+		m.setRow(rows, nonzeros);
+		m.checkValidity();
+	}
+
+	void read(Su2Related& su2Related)
+	{
+		su2Related.offset = readSize();
+		read(su2Related.source);
+		read(su2Related.transpose);
+	}
+
+	template<typename SparseMatrixType>
+	void read(Operator<SparseMatrixType>& op)
+	{
+		read(op.data);
+		read(op.fermionSign);
+		read(op.jm);
+		read(op.angularFactor);
+		read(op.su2Related);
+	}
+
+	template<typename T>
+	void read(BlockDiagonalMatrix<T>& m)
+	{
+		m.readBinary(*this);
+	}
+
+private:
+
+	// Skips what is left of the current record and the records whose label
+	// does not start with label; leaves position_ at the found payload
+	PsimagLite::String findRecord(const PsimagLite::String& label)
+	{
+		position_ = payloadEnd_;
+		PsimagLite::String s;
+		while (position_ < size_) {
+			read(s);
+			SizeType bytes = readSize();
+			checkAvailable(bytes);
+			payloadEnd_ = position_ + bytes;
+			if (s.substr(0, label.length()) == label) return s;
+			position_ = payloadEnd_;
+		}
+
+		err("DiskStackBinaryIn: label " + label + " not found\n");
+		return s;
+	}
+
+	template<typename T>
+	void readPayload(T& x, const PsimagLite::String& label)
+	{
+		read(x);
+		if (position_ == payloadEnd_) return;
+		err("DiskStackBinaryIn: payload of " + label + " has the wrong type\n");
+	}
+
+	template<typename T>
+	void readRaw(T* x, SizeType n)
+	{
+		SizeType bytes = n*sizeof(T);
+		checkAvailable(bytes);
+		if (bytes > 0) memcpy(x, data_ + position_, bytes);
+		position_ += bytes;
+	}
+
+	SizeType readSize()
+	{
+		unsigned long long y = 0;
+		readRaw(&y, 1);
+		return y;
+	}
+
+	SizeType sizeAt(SizeType start, SizeType k) const
+	{
+		unsigned long long y = 0;
+		memcpy(&y, data_ + start + k*sizeof(y), sizeof(y));
+		return y;
+	}
+
+	void checkAvailable(SizeType bytes) const
+	{
+		if (position_ + bytes <= size_) return;
+		err("DiskStackBinaryIn: entry is truncated\n");
+	}
+
+	const char* data_;
+	SizeType size_;
+	SizeType position_;
+	SizeType payloadEnd_;
+}; // class DiskStackBinaryIn
+
+} // namespace Dmrg
+
+namespace PsimagLite {
+
+template<>
+struct IsOutputLike<Dmrg::DiskStackBinaryOut> {
+	enum {True = true};
+};
+
+template<>
+struct IsInputLike<Dmrg::DiskStackBinaryIn> {
+	enum {True = true};
+};
+} // namespace PsimagLite
+
+#endif // DISKSTACKBINARY_H
@@ -0,0 +1,818 @@
+#ifndef DISKSTACKBINARYFILE_H
+#define DISKSTACKBINARYFILE_H
+#include <fstream>
+#include <deque>
+#include <map>
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include "DiskStackBinary.h"
+#include "DiskStackCompression.h"
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+/* Reads and writes the entries of a binary DiskStack, and its index
+
+   A file starts with the header [header magic][FORMAT_VERSION], and files
+   without it, such as those of builds before entries were labeled records
+   (see DiskStackBinary.h), are refused.
+   Entry i is stored at indexOut()[i] = (offset, size). finalize() appends
+   the index and the stack as a footer:
+   [nIndex][(offset, size) ...][nStack][stack from bottom to top]
+   [footer offset][magic]
+   and loadFooter() reads them back for a file given as input.
+
+   If compressed, entries go through DiskStackCompression on the way to and
+   from the disk, and the footer magic records it.
+
+   saveIndexFile() writes the footer to a small file of its own instead,
+   [index file magic][FORMAT_VERSION][length][name of fileOut][footer],
+   so that a file that
+   is only appended to can hold the entries of many stacks; loadIndexFile()
+   reads such a file, and entries are then read from the file that it names.
+
+   Entries are read and written with pread and pwrite on one descriptor
+   per direction, opened on first use and kept open, so that the calling
+   thread and the background thread need no lock to do I/O.
+
+   By default entries are written and read in the calling thread.
+   After startThread(depth, budget), and if compiled with USE_PTHREADS,
+   a background thread compresses and writes pushed entries, holding at most
+   budget bytes in its queue, and loads and deserializes the entries given to
+   prefetch(), keeping at most depth of them, so that take() does not wait
+   for the disk.
+*/
+namespace Dmrg {
+
+template<typename DataType>
+class DiskStackBinaryFile {
+
+	typedef DiskStackBinaryFile<DataType> ThisType;
+	typedef DiskStackBinaryOut::VectorCharType VectorCharType;
+	typedef DiskStackCompression::BinarySizeType BinarySizeType;
+	typedef std::pair<BinarySizeType, BinarySizeType> PairType;
+	typedef typename PsimagLite::Vector<PairType>::Type VectorPairType;
+
+	enum {MAGIC = 0x444d5253, MAGIC_COMPRESSED = 0x444d525a, MAGIC_INDEX_FILE = 0x444d524d};
+
+	enum {MAGIC_HEADER = 0x444d5248, FORMAT_VERSION = 2};
+
+	enum {HEADER_BYTES = 2*sizeof(BinarySizeType)};
+
+public:
+
+	typedef DiskStackCompression::Stats StatsType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+
+	DiskStackBinaryFile(PsimagLite::String fileIn,
+	                    PsimagLite::String fileOut,
+	                    bool isObserveCode,
+	                    bool compressed)
+	    : fileIn_(fileIn),
+	      fileOut_(fileOut),
+	      isObserveCode_(isObserveCode),
+	      compressed_(compressed),
+	      compressedIn_(compressed),
+	      dataEnd_(HEADER_BYTES),
+	      depth_(0),
+	      budget_(0),
+	      running_(false),
+	      stop_(false),
+	      pendingBytes_(0),
+	      hasInFlight_(false),
+	      inFlight_(0),
+	      fdIn_(-1),
+	      fdOut_(-1)
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_init(&mutex_, 0);
+		pthread_cond_init(&cond_, 0);
+#endif
+	}
+
+	~DiskStackBinaryFile()
+	{
+		stopThread();
+		typename MapType::iterator it = cache_.begin();
+		for (; it != cache_.end(); ++it)
+			delete it->second;
+		cache_.clear();
+		closeFd(fdIn_);
+		closeFd(fdOut_);
+#ifdef USE_PTHREADS
+		pthread_cond_destroy(&cond_);
+		pthread_mutex_destroy(&mutex_);
+#endif
+	}
+
+	void startThread(SizeType depth, SizeType budget)
+	{
+		if (running_) return;
+		depth_ = depth;
+		budget_ = budget;
+		if (depth_ == 0 && budget_ == 0) return;
+#ifdef USE_PTHREADS
+		stop_ = false;
+		int ret = pthread_create(&thread_, 0, threadFunction, this);
+		if (ret != 0)
+			err("DiskStackBinaryFile: pthread_create failed\n");
+		running_ = true;
+#else
+		std::cerr<<"WARNING: DiskStack prefetch and write queue need USE_PTHREADS\n";
+#endif
+	}
+
+	SizeType depth() const { return depth_; }
+
+	SizeType budget() const { return budget_; }
+
+	// the index, the data end and the compression of other, which must be flushed
+	void copyIndex(const DiskStackBinaryFile& other)
+	{
+		compressed_ = other.compressed_;
+		compressedIn_ = other.compressedIn_;
+		dataEnd_ = other.dataEnd_;
+		indexIn_ = other.indexIn_;
+		indexOut_ = other.indexOut_;
+	}
+
+	// Takes ownership of buffer's contents; returns the id of the entry
+	SizeType write(VectorCharType& buffer)
+	{
+		if (!running_ || budget_ == 0) {
+			StatsType stats;
+			VectorCharType stored;
+			const VectorCharType& data = pack(stored, buffer, stats, false);
+			writeEntry(dataEnd_, data);
+			lock();
+			SizeType id = indexOut_.size();
+			indexOut_.push_back(PairType(dataEnd_, data.size()));
+			dataEnd_ += data.size();
+			stats_ += stats;
+			unlock();
+			return id;
+		}
+
+		lock();
+		while (errorMessage_ == "" && pendingBytes_ > 0 &&
+		       pendingBytes_ + buffer.size() > budget_)
+			wait();
+
+		checkError();
+
+		SizeType id = nextId();
+		writes_.push_back(WriteJobType());
+		writes_.back().id = id;
+		writes_.back().buffer.swap(buffer);
+		pendingBytes_ += writes_.back().buffer.size();
+		broadcast();
+		unlock();
+		return id;
+	}
+
+	// Returns a new object that the caller owns
+	DataType* take(SizeType id)
+	{
+		if (!running_) {
+			StatsType stats;
+			DataType* dt = load(entry(id), stats, false);
+			stats_ += stats;
+			return dt;
+		}
+
+		lock();
+		while (hasInFlight_ && inFlight_ == id) wait();
+		checkError();
+
+		typename MapType::iterator it = cache_.find(id);
+		if (it != cache_.end()) {
+			DataType* dt = it->second;
+			cache_.erase(it);
+			unlock();
+			return dt;
+		}
+
+		VectorCharType buffer;
+		bool pending = findPending(buffer, id);
+		PairType e = (pending) ? PairType(0, 0) : entry(id);
+		unlock();
+
+		if (pending) return deserialize(buffer);
+
+		StatsType stats;
+		DataType* dt = load(e, stats, false);
+		lock();
+		stats_ += stats;
+		unlock();
+		return dt;
+	}
+
+	// The entries that will be needed next, in the order they will be needed
+	void prefetch(const VectorSizeType& wanted)
+	{
+		if (!running_ || depth_ == 0) return;
+
+		lock();
+		wanted_ = wanted;
+		if (wanted_.size() > depth_) wanted_.resize(depth_);
+
+		typename MapType::iterator it = cache_.begin();
+		while (it != cache_.end()) {
+			if (isWanted(it->first)) {
+				++it;
+				continue;
+			}
+
+			delete it->second;
+			cache_.erase(it++);
+		}
+
+		broadcast();
+		unlock();
+	}
+
+	void flush()
+	{
+		if (!running_) return;
+		lock();
+		while (!writes_.empty() && errorMessage_ == "") wait();
+		checkError();
+		unlock();
+	}
+
+	// Adds the compression statistics since the last call to stats
+	void takeStats(StatsType& stats)
+	{
+		lock();
+		stats += stats_;
+		stats_ = StatsType();
+		unlock();
+	}
+
+	void finalize(const VectorSizeType& stackBottomToTop)
+	{
+		flush();
+
+		VectorCharType footer;
+		writeFooter(footer, indexOut_, stackBottomToTop, dataEnd_, compressed_);
+		writeEntry(dataEnd_, footer);
+	}
+
+	// In the background, after the entries queued before it, if the thread runs
+	void saveIndexFile(PsimagLite::String file, const VectorSizeType& stackBottomToTop)
+	{
+		if (!running_ || budget_ == 0) {
+			lock();
+			VectorPairType index = indexOut_;
+			unlock();
+			writeIndexFile(file, stackBottomToTop, index);
+			return;
+		}
+
+		lock();
+		checkError();
+		writes_.push_back(WriteJobType());
+		writes_.back().id = 0;
+		writes_.back().indexFile = file;
+		writes_.back().ids = stackBottomToTop;
+		broadcast();
+		unlock();
+	}
+
+	void loadIndexFile(PsimagLite::String file, VectorSizeType& stackBottomToTop)
+	{
+		std::ifstream fin(file.c_str(), std::ios::binary);
+		if (!fin.good() || readSize(fin) != MAGIC_INDEX_FILE)
+			err("DiskStack: " + file + " is not an index file\n");
+		if (readSize(fin) != FORMAT_VERSION)
+			err("DiskStack: index file " + file + " is of another format version\n");
+
+		SizeType n = readSize(fin);
+		VectorCharType name(n + 1, 0);
+		if (n > 0) fin.read(&(name[0]), n);
+		if (!fin.good())
+			err("DiskStack: cannot read index file " + file + "\n");
+
+		lock();
+		closeFd(fdIn_);
+		fileIn_ = &(name[0]);
+		unlock();
+		if (fileIn_ == fileOut_)
+			err("DiskStack: index file " + file + " names the output file\n");
+		checkHeader(fileIn_);
+		readFooter(file, stackBottomToTop);
+	}
+
+	static bool isIndexFile(PsimagLite::String file)
+	{
+		std::ifstream fin(file.c_str(), std::ios::binary);
+		if (!fin.good()) return false;
+		BinarySizeType magic = readSize(fin);
+		return (fin.good() && magic == MAGIC_INDEX_FILE);
+	}
+
+	// Continues writing after the entries of other, whose index was loaded
+	// from an index file naming this output file
+	void resumeFrom(const DiskStackBinaryFile& other)
+	{
+		lock();
+		compressed_ = other.compressedIn_;
+		indexOut_ = other.indexIn_;
+		dataEnd_ = HEADER_BYTES;
+		if (indexOut_.size() > 0)
+			dataEnd_ = indexOut_.back().first + indexOut_.back().second;
+		unlock();
+	}
+
+	const PsimagLite::String& fileIn() const { return fileIn_; }
+
+	const PsimagLite::String& fileOut() const { return fileOut_; }
+
+	void loadFooter(VectorSizeType& stackBottomToTop)
+	{
+		checkHeader(fileIn_);
+		readFooter(fileIn_, stackBottomToTop);
+	}
+
+private:
+
+	typedef std::map<SizeType, DataType*> MapType;
+
+	// index jobs have a non empty indexFile and no buffer
+	struct WriteJobType {
+		SizeType id;
+		VectorCharType buffer;
+		PsimagLite::String indexFile;
+		VectorSizeType ids;
+	};
+
+	static void checkHeader(PsimagLite::String file)
+	{
+		std::ifstream fin(file.c_str(), std::ios::binary);
+		if (!fin.good())
+			err("DiskStack: cannot open " + file + "\n");
+
+		BinarySizeType magic = readSize(fin);
+		BinarySizeType version = readSize(fin);
+		if (!fin.good() || magic != MAGIC_HEADER)
+			err("DiskStack: " + file + " has no header; it is not a binary stack, " +
+			    "or was written by an older build\n");
+		if (version != FORMAT_VERSION)
+			err("DiskStack: " + file + " is of format version " + ttos(version) +
+			    ", but this build reads version " + ttos(FORMAT_VERSION) + "\n");
+	}
+
+	void readFooter(PsimagLite::String file, VectorSizeType& stackBottomToTop)
+	{
+		std::ifstream fin(file.c_str(), std::ios::binary);
+		if (!fin.good()) {
+			std::cerr<<"Problem opening reading file "<<file<<"\n";
+			throw PsimagLite::RuntimeError("DiskStack::load(...)\n");
+		}
+
+		fin.seekg(0, std::ios::end);
+		BinarySizeType fileSize = fin.tellg();
+		if (fileSize < 2*sizeof(BinarySizeType))
+			err("DiskStack: " + file + " has no index\n");
+		fin.seekg(fileSize - 2*sizeof(BinarySizeType));
+		BinarySizeType footer = readSize(fin);
+		BinarySizeType magic = readSize(fin);
+		if (magic != MAGIC && magic != MAGIC_COMPRESSED)
+			err("DiskStack: " + file + " is not a binary stack\n");
+		compressedIn_ = (magic == MAGIC_COMPRESSED);
+
+		fin.seekg(footer);
+		SizeType n = readSize(fin);
+		indexIn_.resize(n);
+		for (SizeType i = 0; i < n; ++i) {
+			indexIn_[i].first = readSize(fin);
+			indexIn_[i].second = readSize(fin);
+		}
+
+		n = readSize(fin);
+		stackBottomToTop.resize(n);
+		for (SizeType i = 0; i < n; ++i)
+			stackBottomToTop[i] = readSize(fin);
+
+		if (!fin.good())
+			err("DiskStack: cannot read index from " + file + "\n");
+	}
+
+	static void writeFooter(VectorCharType& fout,
+	                        const VectorPairType& index,
+	                        const VectorSizeType& stackBottomToTop,
+	                        BinarySizeType footerOffset,
+	                        bool compressed)
+	{
+		fout.clear();
+		writeSize(fout, index.size());
+		for (SizeType i = 0; i < index.size(); ++i) {
+			writeSize(fout, index[i].first);
+			writeSize(fout, index[i].second);
+		}
+
+		writeSize(fout, stackBottomToTop.size());
+		for (SizeType i = 0; i < stackBottomToTop.size(); ++i)
+			writeSize(fout, stackBottomToTop[i]);
+
+		writeSize(fout, footerOffset);
+		writeSize(fout, (compressed) ? MAGIC_COMPRESSED : MAGIC);
+	}
+
+	// written to a temporary first, so that a crash leaves the last one whole
+	void writeIndexFile(PsimagLite::String file,
+	                    const VectorSizeType& stackBottomToTop,
+	                    const VectorPairType& index) const
+	{
+		PsimagLite::String tmp = file + ".tmp";
+		std::fstream fout(tmp.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!fout.is_open())
+			err("DiskStack: cannot open " + tmp + "\n");
+
+		VectorCharType header;
+		writeSize(header, MAGIC_INDEX_FILE);
+		writeSize(header, FORMAT_VERSION);
+		writeSize(header, fileOut_.length());
+		header.insert(header.end(), fileOut_.begin(), fileOut_.end());
+		VectorCharType footer;
+		writeFooter(footer, index, stackBottomToTop, header.size(), compressed_);
+		fout.write(&(header[0]), header.size());
+		fout.write(&(footer[0]), footer.size());
+		fout.close();
+		if (fout.fail())
+			err("DiskStack: cannot write index file " + tmp + "\n");
+
+		if (rename(tmp.c_str(), file.c_str()) != 0)
+			err("DiskStack: cannot rename " + tmp + " to " + file + "\n");
+	}
+
+	PsimagLite::String tryWriteIndexFile(const WriteJobType& job,
+	                                     const VectorPairType& index) const
+	{
+		try {
+			writeIndexFile(job.indexFile, job.ids, index);
+		} catch (std::exception& e) {
+			return e.what();
+		}
+
+		return "";
+	}
+
+	// must be called with the lock held if the thread runs
+	SizeType nextId() const
+	{
+		SizeType id = indexOut_.size();
+		typename std::deque<WriteJobType>::const_iterator it = writes_.begin();
+		for (; it != writes_.end(); ++it)
+			if (it->indexFile == "") ++id;
+		return id;
+	}
+
+	static void* threadFunction(void* arg)
+	{
+		ThisType* ptr = static_cast<ThisType*>(arg);
+		ptr->run();
+		return 0;
+	}
+
+	void run()
+	{
+		lock();
+		while (errorMessage_ == "") {
+			if (!writes_.empty()) {
+				// the job stays in the queue until written, so take() can find it
+				// only this thread moves dataEnd_ while it runs
+				WriteJobType& job = writes_.front();
+				if (job.indexFile != "") {
+					VectorPairType index = indexOut_;
+					unlock();
+					PsimagLite::String msg = tryWriteIndexFile(job, index);
+					lock();
+					errorMessage_ = msg;
+					writes_.pop_front();
+					broadcast();
+					continue;
+				}
+
+				BinarySizeType offset = dataEnd_;
+				unlock();
+				StatsType stats;
+				VectorCharType stored;
+				BinarySizeType size = 0;
+				PsimagLite::String msg = tryWrite(size, stored, job.buffer, offset, stats);
+				lock();
+				errorMessage_ = msg;
+				stats_ += stats;
+				indexOut_.push_back(PairType(offset, size));
+				dataEnd_ += size;
+				pendingBytes_ -= job.buffer.size();
+				writes_.pop_front();
+				broadcast();
+				continue;
+			}
+
+			SizeType ind = 0;
+			if (nextToPrefetch(ind)) {
+				SizeType id = wanted_[ind];
+				PairType e = entry(id);
+				hasInFlight_ = true;
+				inFlight_ = id;
+				unlock();
+				DataType* dt = 0;
+				StatsType stats;
+				PsimagLite::String msg = tryLoad(&dt, e, stats);
+				lock();
+				errorMessage_ = msg;
+				stats_ += stats;
+				hasInFlight_ = false;
+				if (dt && isWanted(id)) cache_[id] = dt;
+				else delete dt;
+				broadcast();
+				continue;
+			}
+
+			if (stop_) break;
+			wait();
+		}
+
+		unlock();
+	}
+
+	void stopThread()
+	{
+		if (!running_) return;
+#ifdef USE_PTHREADS
+		lock();
+		stop_ = true;
+		broadcast();
+		unlock();
+		pthread_join(thread_, 0);
+#endif
+		running_ = false;
+	}
+
+	bool nextToPrefetch(SizeType& ind) const
+	{
+		for (SizeType i = 0; i < wanted_.size(); ++i) {
+			SizeType id = wanted_[i];
+			if (cache_.find(id) != cache_.end()) continue;
+			if (isPending(id)) continue;
+			ind = i;
+			return true;
+		}
+
+		return false;
+	}
+
+	bool isWanted(SizeType id) const
+	{
+		for (SizeType i = 0; i < wanted_.size(); ++i)
+			if (wanted_[i] == id) return true;
+		return false;
+	}
+
+	bool isPending(SizeType id) const
+	{
+		typename std::deque<WriteJobType>::const_iterator it = writes_.begin();
+		for (; it != writes_.end(); ++it)
+			if (it->indexFile == "" && it->id == id) return true;
+		return false;
+	}
+
+	bool findPending(VectorCharType& buffer, SizeType id) const
+	{
+		typename std::deque<WriteJobType>::const_iterator it = writes_.begin();
+		for (; it != writes_.end(); ++it) {
+			if (it->indexFile != "" || it->id != id) continue;
+			buffer = it->buffer;
+			return true;
+		}
+
+		return false;
+	}
+
+	// must be called with the lock held if the thread runs
+	const PairType& entry(SizeType id) const
+	{
+		const VectorPairType& index = (fileIn_ == fileOut_) ? indexOut_ : indexIn_;
+		if (id >= index.size())
+			err("DiskStack: no entry " + ttos(id) + " in " + fileIn_ + "\n");
+		return index[id];
+	}
+
+	PsimagLite::String tryWrite(BinarySizeType& size,
+	                            VectorCharType& stored,
+	                            const VectorCharType& buffer,
+	                            BinarySizeType offset,
+	                            StatsType& stats) const
+	{
+		try {
+			const VectorCharType& data = pack(stored, buffer, stats, true);
+			writeEntry(offset, data);
+			size = data.size();
+		} catch (std::exception& e) {
+			return e.what();
+		}
+
+		return "";
+	}
+
+	PsimagLite::String tryLoad(DataType** dt,
+	                           const PairType& entryToLoad,
+	                           StatsType& stats) const
+	{
+		try {
+			*dt = load(entryToLoad, stats, true);
+		} catch (std::exception& e) {
+			return e.what();
+		}
+
+		return "";
+	}
+
+	// the background thread compresses alone, so that it does not compete
+	// with the threads of the calling code
+	const VectorCharType& pack(VectorCharType& stored,
+	                           const VectorCharType& buffer,
+	                           StatsType& stats,
+	                           bool inBackground) const
+	{
+		if (!compressed_) return buffer;
+		SizeType threads = (inBackground) ? 1 : PsimagLite::Concurrency::npthreads;
+		DiskStackCompression::compress(stored, buffer, threads, stats);
+		return stored;
+	}
+
+	DataType* load(const PairType& e, StatsType& stats, bool inBackground) const
+	{
+		VectorCharType buffer;
+		readEntry(buffer, e);
+		if (!compressedIn_) return deserialize(buffer);
+
+		VectorCharType raw;
+		SizeType threads = (inBackground) ? 1 : PsimagLite::Concurrency::npthreads;
+		DiskStackCompression::decompress(raw, buffer, threads, stats);
+		return deserialize(raw);
+	}
+
+	void readEntry(VectorCharType& buffer, const PairType& e) const
+	{
+		lock();
+		if (fdIn_ < 0) fdIn_ = open(fileIn_.c_str(), O_RDONLY);
+		int fd = fdIn_;
+		unlock();
+		if (fd < 0)
+			err("DiskStack: cannot open " + fileIn_ + "\n");
+
+		buffer.resize(e.second);
+		SizeType done = 0;
+		while (done < buffer.size()) {
+			ssize_t x = pread(fd, &(buffer[done]), buffer.size() - done, e.first + done);
+			if (x < 0 && errno == EINTR) continue;
+			if (x <= 0)
+				err("DiskStack: cannot read entry from " + fileIn_ + "\n");
+			done += x;
+		}
+	}
+
+	// the output file is truncated, and gets a new header, if its first
+	// write is right after the header
+	void writeEntry(BinarySizeType offset, const VectorCharType& buffer) const
+	{
+		assert(offset >= HEADER_BYTES);
+		lock();
+		bool fresh = false;
+		if (fdOut_ < 0) {
+			int flags = O_RDWR | O_CREAT;
+			fresh = (offset == HEADER_BYTES);
+			if (fresh) flags |= O_TRUNC;
+			fdOut_ = open(fileOut_.c_str(), flags, 0644);
+		}
+
+		int fd = fdOut_;
+		unlock();
+		if (fd < 0)
+			err("DiskStack: cannot open " + fileOut_ + "\n");
+
+		if (fresh) {
+			VectorCharType header;
+			writeSize(header, MAGIC_HEADER);
+			writeSize(header, FORMAT_VERSION);
+			writeAt(fd, 0, header);
+		}
+
+		writeAt(fd, offset, buffer);
+	}
+
+	void writeAt(int fd, BinarySizeType offset, const VectorCharType& buffer) const
+	{
+		SizeType done = 0;
+		while (done < buffer.size()) {
+			ssize_t x = pwrite(fd, &(buffer[done]), buffer.size() - done, offset + done);
+			if (x < 0 && errno == EINTR) continue;
+			if (x <= 0)
+				err("DiskStack: cannot write to " + fileOut_ + "\n");
+			done += x;
+		}
+	}
+
+	static void closeFd(int& fd)
+	{
+		if (fd >= 0) close(fd);
+		fd = -1;
+	}
+
+	static void writeSize(VectorCharType& fout, BinarySizeType x)
+	{
+		const char* ptr = reinterpret_cast<const char*>(&x);
+		fout.insert(fout.end(), ptr, ptr + sizeof(x));
+	}
+
+	static BinarySizeType readSize(std::ifstream& fin)
+	{
+		BinarySizeType x = 0;
+		fin.read(reinterpret_cast<char*>(&x), sizeof(x));
+		return x;
+	}
+
+	DataType* deserialize(const VectorCharType& buffer) const
+	{
+		DiskStackBinaryIn io(buffer);
+		return new DataType(io,"",0,isObserveCode_);
+	}
+
+	// must be called with the lock held
+	void checkError()
+	{
+		if (errorMessage_ == "") return;
+		PsimagLite::String msg = errorMessage_;
+		unlock();
+		err("DiskStack background I/O: " + msg);
+	}
+
+	void lock() const
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex_);
+#endif
+	}
+
+	void unlock() const
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&mutex_);
+#endif
+	}
+
+	void wait()
+	{
+#ifdef USE_PTHREADS
+		pthread_cond_wait(&cond_, &mutex_);
+#endif
+	}
+
+	void broadcast()
+	{
+#ifdef USE_PTHREADS
+		pthread_cond_broadcast(&cond_);
+#endif
+	}
+
+	DiskStackBinaryFile(const DiskStackBinaryFile&);
+
+	DiskStackBinaryFile& operator=(const DiskStackBinaryFile&);
+
+	PsimagLite::String fileIn_;
+	PsimagLite::String fileOut_;
+	bool isObserveCode_;
+	bool compressed_;
+	bool compressedIn_;
+	BinarySizeType dataEnd_;
+	VectorPairType indexIn_;
+	VectorPairType indexOut_;
+	StatsType stats_;
+	SizeType depth_;
+	SizeType budget_;
+	bool running_;
+	bool stop_;
+	SizeType pendingBytes_;
+	bool hasInFlight_;
+	SizeType inFlight_;
+	PsimagLite::String errorMessage_;
+	std::deque<WriteJobType> writes_;
+	VectorSizeType wanted_;
+	MapType cache_;
+	mutable int fdIn_;
+	mutable int fdOut_;
+#ifdef USE_PTHREADS
+	pthread_t thread_;
+	mutable pthread_mutex_t mutex_;
+	pthread_cond_t cond_;
+#endif
+}; // class DiskStackBinaryFile
+
+} // namespace Dmrg
+
+#endif // DISKSTACKBINARYFILE_H
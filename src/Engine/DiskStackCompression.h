@@ -0,0 +1,436 @@
+#ifndef DISKSTACKCOMPRESSION_H
+#define DISKSTACKCOMPRESSION_H
+#include <cstring>
+#include <sys/time.h>
+#include "Vector.h"
+#include "Concurrency.h"
+#ifdef USE_PTHREADS
+#include "PthreadsNg.h"
+#else
+#include "NoPthreadsNg.h"
+#endif
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+
+/* Lossless block compression of DiskStack entries
+
+   An entry is cut in blocks of BLOCK_SIZE bytes that are compressed
+   independently, and in parallel if more than one thread is given.
+   Blocks are compressed with zlib if compiled with USE_ZLIB, and otherwise
+   with a byte shuffle of 8-byte words followed by run length encoding,
+   which turns the equal high bytes of doubles into long runs.
+   A block that does not shrink is stored as is.
+
+   Format: [magic][raw size][number of blocks]
+           [(codec, stored size) for each block][blocks]
+*/
+namespace Dmrg {
+
+class DiskStackCompression {
+
+public:
+
+	typedef PsimagLite::Vector<char>::Type VectorCharType;
+	typedef unsigned long long BinarySizeType;
+
+	struct Stats {
+
+		Stats()
+		    : rawBytes(0),
+		      storedBytes(0),
+		      compressSeconds(0),
+		      loadedBytes(0),
+		      decompressSeconds(0)
+		{}
+
+		void operator+=(const Stats& other)
+		{
+			rawBytes += other.rawBytes;
+			storedBytes += other.storedBytes;
+			compressSeconds += other.compressSeconds;
+			loadedBytes += other.loadedBytes;
+			decompressSeconds += other.decompressSeconds;
+		}
+
+		bool empty() const { return (rawBytes == 0 && loadedBytes == 0); }
+
+		friend std::ostream& operator<<(std::ostream& os, const Stats& s)
+		{
+			double ratio = (s.storedBytes > 0) ? double(s.rawBytes)/s.storedBytes : 0;
+			os<<"compressed "<<megabytes(s.rawBytes)<<" MB to ";
+			os<<megabytes(s.storedBytes)<<" MB, ratio="<<ratio;
+			os<<" at "<<throughput(s.rawBytes, s.compressSeconds)<<" MB/s,";
+			os<<" decompressed "<<megabytes(s.loadedBytes)<<" MB";
+			os<<" at "<<throughput(s.loadedBytes, s.decompressSeconds)<<" MB/s";
+			return os;
+		}
+
+		BinarySizeType rawBytes;
+		BinarySizeType storedBytes;
+		double compressSeconds;
+		BinarySizeType loadedBytes;
+		double decompressSeconds;
+
+	private:
+
+		static double megabytes(BinarySizeType bytes)
+		{
+			return bytes/1048576.0;
+		}
+
+		static double throughput(BinarySizeType bytes, double secs)
+		{
+			return (secs > 0) ? megabytes(bytes)/secs : 0;
+		}
+	};
+
+	static void compress(VectorCharType& dest,
+	                     const VectorCharType& src,
+	                     SizeType threads,
+	                     Stats& stats)
+	{
+		double t0 = seconds();
+		SizeType blocks = (src.size() + BLOCK_SIZE - 1)/BLOCK_SIZE;
+		PsimagLite::Vector<VectorCharType>::Type stored(blocks);
+		VectorSizeType codecs(blocks, CODEC_NONE);
+		CompressHelper helper(stored, codecs, src);
+		runInParallel(helper, threads);
+
+		dest.clear();
+		append(dest, MAGIC);
+		append(dest, src.size());
+		append(dest, blocks);
+		for (SizeType i = 0; i < blocks; ++i) {
+			append(dest, codecs[i]);
+			append(dest, stored[i].size());
+		}
+
+		for (SizeType i = 0; i < blocks; ++i)
+			dest.insert(dest.end(), stored[i].begin(), stored[i].end());
+
+		stats.rawBytes += src.size();
+		stats.storedBytes += dest.size();
+		stats.compressSeconds += seconds() - t0;
+	}
+
+	static void decompress(VectorCharType& dest,
+	                       const VectorCharType& src,
+	                       SizeType threads,
+	                       Stats& stats)
+	{
+		double t0 = seconds();
+		SizeType pos = 0;
+		if (readAt(src, pos) != MAGIC)
+			err("DiskStackCompression: entry is not compressed\n");
+
+		SizeType rawSize = readAt(src, pos);
+		SizeType blocks = readAt(src, pos);
+		VectorSizeType codecs(blocks);
+		VectorSizeType offsets(blocks + 1);
+		for (SizeType i = 0; i < blocks; ++i) {
+			codecs[i] = readAt(src, pos);
+			offsets[i + 1] = offsets[i] + readAt(src, pos);
+		}
+
+		for (SizeType i = 0; i < blocks + 1; ++i)
+			offsets[i] += pos;
+
+		if (offsets[blocks] != src.size() || (rawSize + BLOCK_SIZE - 1)/BLOCK_SIZE != blocks)
+			err("DiskStackCompression: corrupted entry\n");
+
+		dest.resize(rawSize);
+		DecompressHelper helper(dest, src, codecs, offsets);
+		runInParallel(helper, threads);
+
+		stats.loadedBytes += rawSize;
+		stats.decompressSeconds += seconds() - t0;
+	}
+
+	static PsimagLite::String codecName()
+	{
+#ifdef USE_ZLIB
+		return "zlib";
+#else
+		return "shuffle+rle";
+#endif
+	}
+
+private:
+
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+
+	enum {CODEC_NONE, CODEC_RLE, CODEC_ZLIB};
+
+	enum {BLOCK_SIZE = 1048576, WORD = 8, MAGIC = 0x5a4b5344};
+
+	class CompressHelper {
+
+	public:
+
+		CompressHelper(PsimagLite::Vector<VectorCharType>::Type& stored,
+		               VectorSizeType& codecs,
+		               const VectorCharType& src)
+		    : stored_(stored), codecs_(codecs), src_(src)
+		{}
+
+		SizeType tasks() const { return stored_.size(); }
+
+		void doTask(SizeType t, SizeType)
+		{
+			SizeType start = t*BLOCK_SIZE;
+			SizeType n = std::min(src_.size() - start, SizeType(BLOCK_SIZE));
+			const char* block = &(src_[start]);
+			VectorCharType& out = stored_[t];
+#ifdef USE_ZLIB
+			codecs_[t] = CODEC_ZLIB;
+			zlibCompress(out, block, n);
+#else
+			codecs_[t] = CODEC_RLE;
+			shuffleRleCompress(out, block, n);
+#endif
+			if (out.size() < n) return;
+			codecs_[t] = CODEC_NONE;
+			out.assign(block, block + n);
+		}
+
+	private:
+
+		PsimagLite::Vector<VectorCharType>::Type& stored_;
+		VectorSizeType& codecs_;
+		const VectorCharType& src_;
+	};
+
+	class DecompressHelper {
+
+	public:
+
+		DecompressHelper(VectorCharType& dest,
+		                 const VectorCharType& src,
+		                 const VectorSizeType& codecs,
+		                 const VectorSizeType& offsets)
+		    : dest_(dest), src_(src), codecs_(codecs), offsets_(offsets)
+		{}
+
+		SizeType tasks() const { return codecs_.size(); }
+
+		void doTask(SizeType t, SizeType)
+		{
+			SizeType start = t*BLOCK_SIZE;
+			SizeType n = std::min(dest_.size() - start, SizeType(BLOCK_SIZE));
+			SizeType storedSize = offsets_[t + 1] - offsets_[t];
+			const char* in = (storedSize > 0) ? &(src_[offsets_[t]]) : 0;
+			char* out = &(dest_[start]);
+
+			switch (codecs_[t]) {
+			case CODEC_NONE:
+				if (storedSize != n)
+					err("DiskStackCompression: corrupted block\n");
+				memcpy(out, in, n);
+				break;
+			case CODEC_RLE:
+				shuffleRleDecompress(out, n, in, storedSize);
+				break;
+			case CODEC_ZLIB:
+				zlibDecompress(out, n, in, storedSize);
+				break;
+			default:
+				err("DiskStackCompression: unknown codec\n");
+			}
+		}
+
+	private:
+
+		VectorCharType& dest_;
+		const VectorCharType& src_;
+		const VectorSizeType& codecs_;
+		const VectorSizeType& offsets_;
+	};
+
+	template<typename HelperType>
+	static void runInParallel(HelperType& helper, SizeType threads)
+	{
+		threads = std::min(threads, helper.tasks());
+		if (threads < 2) {
+			for (SizeType t = 0; t < helper.tasks(); ++t)
+				helper.doTask(t, 0);
+			return;
+		}
+
+		// Every rank packs or loads its own entries, so the blocks are
+		// shared among threads only
+#ifdef USE_PTHREADS
+		typedef PsimagLite::PthreadsNg<HelperType> ThreadsOnlyType;
+#else
+		typedef PsimagLite::NoPthreadsNg<HelperType> ThreadsOnlyType;
+#endif
+		ThreadsOnlyType threaded(threads,0,false);
+		threaded.loopCreate(helper);
+	}
+
+	// Bytes of position j of each 8-byte word are grouped together, and
+	// the result is encoded as literal runs (control byte < 128, length + 1)
+	// and repeated bytes (control byte >= 128, count - MIN_REPEAT + 128).
+	static void shuffleRleCompress(VectorCharType& out, const char* in, SizeType n)
+	{
+		VectorCharType shuffled(n);
+		shuffle(&(shuffled[0]), in, n);
+
+		out.clear();
+		out.reserve(n/2 + 16);
+		SizeType i = 0;
+		SizeType literalStart = 0;
+		while (i < n) {
+			SizeType run = 1;
+			while (i + run < n && run < MAX_REPEAT && shuffled[i + run] == shuffled[i])
+				++run;
+
+			if (run < MIN_REPEAT) {
+				i += run;
+				continue;
+			}
+
+			flushLiterals(out, shuffled, literalStart, i);
+			out.push_back(static_cast<char>(128 + run - MIN_REPEAT));
+			out.push_back(shuffled[i]);
+			i += run;
+			literalStart = i;
+			if (out.size() >= n) return;
+		}
+
+		flushLiterals(out, shuffled, literalStart, n);
+	}
+
+	static void shuffleRleDecompress(char* out,
+	                                 SizeType n,
+	                                 const char* in,
+	                                 SizeType storedSize)
+	{
+		VectorCharType shuffled(n);
+		SizeType j = 0;
+		SizeType i = 0;
+		while (i < storedSize) {
+			unsigned char c = in[i++];
+			if (c < 128) {
+				SizeType len = c + 1;
+				if (i + len > storedSize || j + len > n)
+					err("DiskStackCompression: corrupted literal run\n");
+				memcpy(&(shuffled[j]), in + i, len);
+				i += len;
+				j += len;
+				continue;
+			}
+
+			SizeType len = c - 128 + MIN_REPEAT;
+			if (i >= storedSize || j + len > n)
+				err("DiskStackCompression: corrupted repeated run\n");
+			memset(&(shuffled[j]), in[i++], len);
+			j += len;
+		}
+
+		if (j != n)
+			err("DiskStackCompression: block has wrong size\n");
+
+		unshuffle(out, &(shuffled[0]), n);
+	}
+
+	static void flushLiterals(VectorCharType& out,
+	                          const VectorCharType& shuffled,
+	                          SizeType start,
+	                          SizeType end)
+	{
+		while (start < end) {
+			SizeType len = std::min(end - start, SizeType(MAX_LITERAL));
+			out.push_back(static_cast<char>(len - 1));
+			out.insert(out.end(), shuffled.begin() + start, shuffled.begin() + start + len);
+			start += len;
+		}
+	}
+
+	static void shuffle(char* out, const char* in, SizeType n)
+	{
+		SizeType words = n/WORD;
+		for (SizeType i = 0; i < words; ++i)
+			for (SizeType j = 0; j < WORD; ++j)
+				out[j*words + i] = in[i*WORD + j];
+		memcpy(out + words*WORD, in + words*WORD, n - words*WORD);
+	}
+
+	static void unshuffle(char* out, const char* in, SizeType n)
+	{
+		SizeType words = n/WORD;
+		for (SizeType i = 0; i < words; ++i)
+			for (SizeType j = 0; j < WORD; ++j)
+				out[i*WORD + j] = in[j*words + i];
+		memcpy(out + words*WORD, in + words*WORD, n - words*WORD);
+	}
+
+#ifdef USE_ZLIB
+	static void zlibCompress(VectorCharType& out, const char* in, SizeType n)
+	{
+		uLongf size = compressBound(n);
+		out.resize(size);
+		int ret = compress2(reinterpret_cast<Bytef*>(&(out[0])),
+		                    &size,
+		                    reinterpret_cast<const Bytef*>(in),
+		                    n,
+		                    Z_BEST_SPEED);
+		if (ret != Z_OK)
+			err("DiskStackCompression: zlib compress2 failed\n");
+		out.resize(size);
+	}
+
+	static void zlibDecompress(char* out,
+	                           SizeType n,
+	                           const char* in,
+	                           SizeType storedSize)
+	{
+		uLongf size = n;
+		int ret = uncompress(reinterpret_cast<Bytef*>(out),
+		                     &size,
+		                     reinterpret_cast<const Bytef*>(in),
+		                     storedSize);
+		if (ret != Z_OK || size != n)
+			err("DiskStackCompression: zlib uncompress failed\n");
+	}
+#else
+	static void zlibCompress(VectorCharType&, const char*, SizeType)
+	{
+		err("DiskStackCompression: compile with USE_ZLIB to use zlib\n");
+	}
+
+	static void zlibDecompress(char*, SizeType, const char*, SizeType)
+	{
+		err("DiskStackCompression: compile with USE_ZLIB to read zlib blocks\n");
+	}
+#endif
+
+	static void append(VectorCharType& dest, BinarySizeType x)
+	{
+		const char* ptr = reinterpret_cast<const char*>(&x);
+		dest.insert(dest.end(), ptr, ptr + sizeof(x));
+	}
+
+	static BinarySizeType readAt(const VectorCharType& src, SizeType& pos)
+	{
+		BinarySizeType x = 0;
+		if (pos + sizeof(x) > src.size())
+			err("DiskStackCompression: truncated entry\n");
+		memcpy(&x, &(src[pos]), sizeof(x));
+		pos += sizeof(x);
+		return x;
+	}
+
+	static double seconds()
+	{
+		struct timeval tv;
+		gettimeofday(&tv, 0);
+		return tv.tv_sec + 1e-6*tv.tv_usec;
+	}
+
+	enum {MIN_REPEAT = 3, MAX_REPEAT = 127 + MIN_REPEAT, MAX_LITERAL = 128};
+}; // class DiskStackCompression
+
+} // namespace Dmrg
+
+#endif // DISKSTACKCOMPRESSION_H
@@ -83,6 +83,8 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "IoSimple.h"
 #include "FermionSign.h"
 #include "ProgramGlobals.h"
+#include "BlockDiagonalMatrix.h"
+#include <algorithm>
 
 namespace Dmrg {
 // Move also checkpointing from DmrgSolver to here (FIXME)
@@ -93,18 +95,33 @@ class DmrgSerializer {
 	typedef typename LeftRightSuperType::SparseMatrixType SparseMatrixType;
 	typedef typename SparseMatrixType::value_type ComplexOrRealType;
 	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
+	typedef typename PsimagLite::Vector<MatrixType>::Type VectorMatrixType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef PsimagLite::Vector<int>::Type VectorIntType;
 
 public:
 	typedef typename LeftRightSuperType::BasisWithOperatorsType BasisWithOperatorsType;
 	typedef typename BasisWithOperatorsType::BasisType BasisType;
 	typedef FermionSign FermionSignType;
 	typedef typename BasisType::RealType RealType;
+	typedef BlockDiagonalMatrix<MatrixType> BlockDiagonalMatrixType;
+
+	// The storage of transform, kept from one call to the next
+	struct TransformWorkspaceType {
+		VectorIntType slot; // of each block of T in blockO, or -1
+		VectorSizeType blocksOfO; // of T, that a block of rows of O touches
+		VectorSizeType nonZeros; // of O_{kl}, by slot
+		typename PsimagLite::Vector<bool>::Type dense; // O_{kl} is dense, by slot
+		VectorMatrixType blockO; // O_{kl} if dense, else O_{kl} T_l
+		VectorMatrixType blockRet; // T_k^\dagger O_{kl} T_l
+		MatrixType tmp; // O_{kl} T_l, if O_{kl} is dense
+	};
 
 	DmrgSerializer(const FermionSignType& fS,
 		       const FermionSignType& fE,
 		       const LeftRightSuperType& lrs,
 		       const VectorType& wf,
-		       const SparseMatrixType& transform,
+		       const BlockDiagonalMatrixType& transform,
 		       ProgramGlobals::DirectionEnum direction)
 		: fS_(fS),
 		  fE_(fE),
@@ -113,13 +130,16 @@ public:
 		  transform_(transform),
 		  direction_(direction)
 	{
-		transposeConjugate(transformC_,transform_);
+		setBlockOfRow();
 	}
 
 
-	DmrgSerializer(typename PsimagLite::IoSimple::In& io,
+	template<typename IoInputType>
+	DmrgSerializer(IoInputType& io,
 	               bool bogus,
-	               bool isObserveCode)
+	               bool isObserveCode,
+	               typename PsimagLite::EnableIf<
+	               PsimagLite::IsInputLike<IoInputType>::True, int>::Type = 0)
 		: fS_(io,bogus),
 		  fE_(io,bogus),
 		  lrs_(io, isObserveCode)
@@ -128,8 +148,10 @@ public:
 		PsimagLite::String s = "#WAVEFUNCTION_sites=";
 		wavefunction_.load(io,s);
 		s = "#TRANSFORM_sites=";
-		io.readMatrix(transform_,s);
-		transposeConjugate(transformC_,transform_);
+		SparseMatrixType transform;
+		io.readMatrix(transform,s);
+		transform_.fromSparse(transform);
+		setBlockOfRow();
 		s = "#DIRECTION=";
 		io.readline(direction_,s);
 	}
@@ -158,7 +180,9 @@ public:
 		for (SizeType i=0;i<lrs_.left().block().size();i++) {
 			label += ttos(lrs_.left().block()[i])+",";
 		}
-		io.printMatrix(transform_,label);
+		SparseMatrixType transform;
+		transform_.toSparse(transform);
+		io.printMatrix(transform,label);
 		PsimagLite::String s = "#DIRECTION="+ttos(direction_);
 		io.printline(s);
 //		io.print("#DIRECTION=",direction_);
@@ -195,9 +219,156 @@ public:
 
 	void transform(SparseMatrixType& ret,const SparseMatrixType& O) const
 	{
-		SparseMatrixType ret2;
-		multiply(ret2,transformC_,O);
-		multiply(ret,ret2,transform_);
+		TransformWorkspaceType workspace;
+		transform(ret,O,workspace);
+	}
+
+	// ret = T^\dagger O T, one block of rows of T at a time: for block k
+	// the nonzeros of O in its rows are split in O_{kl}, one for each
+	// block l of T that they touch, and the block (k,l) of ret is
+	// T_k^\dagger O_{kl} T_l. If at least denseFraction() of O_{kl} is
+	// nonzero it is made dense and multiplied by T_l with a GEMM; otherwise
+	// O_{kl} T_l is summed from its nonzeros, so that no dense copy of a
+	// mostly empty O_{kl} is made. The rows of ret for block k
+	// are written, as CRS, once its blocks (k,l) are done
+	void transform(SparseMatrixType& ret,
+	               const SparseMatrixType& O,
+	               TransformWorkspaceType& workspace) const
+	{
+		assert(O.rows() == transform_.rows() && O.cols() == transform_.rows());
+		SizeType nblocks = transform_.blocks();
+		SizeType c = transform_.cols();
+		ComplexOrRealType one = 1.0;
+		ComplexOrRealType zero = 0.0;
+		VectorIntType& slot = workspace.slot;
+		VectorSizeType& blocksOfO = workspace.blocksOfO;
+		slot.assign(nblocks, -1);
+		ret.resize(c, c);
+		SizeType counter = 0;
+		for (SizeType k = 0; k < nblocks; ++k) {
+			const MatrixType& tk = transform_(k);
+			SizeType rowOffset = transform_.offsetsRows(k);
+			SizeType colOffset = transform_.offsetsCols(k);
+			SizeType rk = transform_.offsetsRows(k + 1) - rowOffset;
+			SizeType ck = transform_.offsetsCols(k + 1) - colOffset;
+			if (ck == 0) continue;
+
+			blocksOfO.clear();
+			for (SizeType i = 0; i < rk; ++i) {
+				SizeType row = i + rowOffset;
+				for (int kk = O.getRowPtr(row); kk < O.getRowPtr(row + 1); ++kk) {
+					SizeType l = blockOfRow_[O.getCol(kk)];
+					if (transform_(l).cols() == 0) continue;
+					if (slot[l] < 0) {
+						slot[l] = blocksOfO.size();
+						blocksOfO.push_back(l);
+						if (workspace.blockO.size() < blocksOfO.size()) {
+							workspace.blockO.resize(blocksOfO.size());
+							workspace.blockRet.resize(blocksOfO.size());
+							workspace.nonZeros.resize(blocksOfO.size());
+							workspace.dense.resize(blocksOfO.size());
+						}
+
+						workspace.nonZeros[slot[l]] = 0;
+					}
+
+					++workspace.nonZeros[slot[l]];
+				}
+			}
+
+			for (SizeType x = 0; x < blocksOfO.size(); ++x) {
+				const MatrixType& tl = transform_(blocksOfO[x]);
+				SizeType area = rk*tl.rows();
+				bool dense = (workspace.nonZeros[x] >= denseFraction()*area);
+				workspace.dense[x] = dense;
+				workspace.blockO[x].resize(rk, (dense) ? tl.rows() : tl.cols());
+				workspace.blockO[x].setTo(zero);
+			}
+
+			for (SizeType i = 0; i < rk; ++i) {
+				SizeType row = i + rowOffset;
+				for (int kk = O.getRowPtr(row); kk < O.getRowPtr(row + 1); ++kk) {
+					SizeType col = O.getCol(kk);
+					SizeType l = blockOfRow_[col];
+					const MatrixType& tl = transform_(l);
+					if (tl.cols() == 0) continue;
+					SizeType j = col - transform_.offsetsRows(l);
+					MatrixType& blockO = workspace.blockO[slot[l]];
+					if (workspace.dense[slot[l]]) {
+						blockO(i, j) += O.getValue(kk);
+						continue;
+					}
+
+					ComplexOrRealType val = O.getValue(kk);
+					for (SizeType b = 0; b < tl.cols(); ++b)
+						blockO(i, b) += val*tl(j, b);
+				}
+			}
+
+			std::sort(blocksOfO.begin(), blocksOfO.end());
+			for (SizeType x = 0; x < blocksOfO.size(); ++x) {
+				SizeType l = blocksOfO[x];
+				const MatrixType& tl = transform_(l);
+				SizeType cl = tl.cols();
+				MatrixType& blockO = workspace.blockO[slot[l]];
+				MatrixType& blockRet = workspace.blockRet[slot[l]];
+				blockRet.resize(ck, cl);
+				const MatrixType* oTl = &blockO;
+				if (workspace.dense[slot[l]]) {
+					workspace.tmp.resize(rk, cl);
+					psimag::BLAS::GEMM('N',
+					                   'N',
+					                   rk,
+					                   cl,
+					                   tl.rows(),
+					                   one,
+					                   &(blockO(0,0)),
+					                   rk,
+					                   &(tl(0,0)),
+					                   tl.rows(),
+					                   zero,
+					                   &(workspace.tmp(0,0)),
+					                   rk);
+					oTl = &workspace.tmp;
+				}
+
+				psimag::BLAS::GEMM('C',
+				                   'N',
+				                   ck,
+				                   cl,
+				                   rk,
+				                   one,
+				                   &(tk(0,0)),
+				                   rk,
+				                   &((*oTl)(0,0)),
+				                   rk,
+				                   zero,
+				                   &(blockRet(0,0)),
+				                   ck);
+			}
+
+			for (SizeType a = 0; a < ck; ++a) {
+				ret.setRow(a + colOffset, counter);
+				for (SizeType x = 0; x < blocksOfO.size(); ++x) {
+					SizeType l = blocksOfO[x];
+					const MatrixType& blockRet = workspace.blockRet[slot[l]];
+					for (SizeType b = 0; b < blockRet.cols(); ++b) {
+						ComplexOrRealType val = blockRet(a, b);
+						if (PsimagLite::norm(val) == 0)
+							continue;
+						ret.pushValue(val);
+						ret.pushCol(b + transform_.offsetsCols(l));
+						++counter;
+					}
+				}
+			}
+
+			for (SizeType x = 0; x < blocksOfO.size(); ++x)
+				slot[blocksOfO[x]] = -1;
+		}
+
+		ret.setRow(c, counter);
+		ret.checkValidity();
 	}
 
 private:
@@ -206,12 +377,24 @@ private:
 	DmrgSerializer(const ThisType& ds);
 	ThisType& operator=(const ThisType& ds);
 
+	void setBlockOfRow()
+	{
+		blockOfRow_.resize(transform_.rows());
+		for (SizeType k = 0; k < transform_.blocks(); ++k)
+			for (SizeType i = transform_.offsetsRows(k);
+			     i < transform_.offsetsRows(k + 1);
+			     ++i)
+				blockOfRow_[i] = k;
+	}
+
+	// same as the default of DenseSparseThreshold=
+	static RealType denseFraction() { return 0.1; }
 
 	FermionSignType fS_,fE_;
 	LeftRightSuperType lrs_;
 	VectorType wavefunction_;
-	SparseMatrixType transform_;
-	SparseMatrixType transformC_;
+	BlockDiagonalMatrixType transform_;
+	VectorSizeType blockOfRow_;
 	ProgramGlobals::DirectionEnum direction_;
 }; // class DmrgSerializer
 } // namespace Dmrg 
@@ -85,9 +85,11 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Diagonalization.h"
 #include "ProgressIndicator.h"
 #include "DmrgSerializer.h"
+#include "ObserveDataFile.h"
 #include "Recovery.h"
 #include "Truncation.h"
 #include "ObservablesInSitu.h"
+#include "CorrelationsInSitu.h"
 #include "TargetingGroundState.h"
 #include "TargetingTimeStep.h"
 #include "TargetingDynamic.h"
@@ -175,6 +177,8 @@ public:
 	typedef TargetingRixsStatic<LanczosSolverType,VectorWithOffsetType> TargetingRixsStaticType;
 	typedef TargetingRixsDynamic<LanczosSolverType,VectorWithOffsetType> TargetingRixsDynamicType;
 	typedef PrinterInDetail<LeftRightSuperType> PrinterInDetailType;
+	typedef CorrelationsInSitu<LeftRightSuperType,ModelType,VectorWithOffsetType>
+	CorrelationsInSituType;
 	typedef typename DiagonalizationType::BasisWithOperatorsType BasisWithOperatorsType;
 	typedef typename BasisWithOperatorsType::BlockDiagonalMatrixType BlockDiagonalMatrixType;
 
@@ -209,10 +213,12 @@ public:
 	      truncate_(reflectionOperator_,
 	                wft_,
 	                parameters_,
-	                model.geometry().maxConnections(),
+	                model.geometry(),
 	                verbose_),
+	      correlationsInSitu_(model),
 	      energy_(0.0),
-	      saveData_(parameters_.options.find("noSaveData") == PsimagLite::String::npos)
+	      saveData_(parameters_.options.find("noSaveData") == PsimagLite::String::npos),
+	      observeData_(0)
 	{
 		std::cout<<appInfo_;
 		PsimagLite::OstringStream msg;
@@ -227,10 +233,22 @@ public:
 		ioOut_.print("PARAMETERS\n", parameters_);
 		ioOut_.print(model);
 		if (parameters_.options.find("verbose")!=PsimagLite::String::npos) verbose_=true;
+
+		bool binaryObserveData = (parameters_.options.find("binaryObserveData") !=
+		        PsimagLite::String::npos);
+		if (saveData_ && binaryObserveData) {
+			PsimagLite::String file = utils::pathPrepend(ProgramGlobals::OBSERVE_DATA_STRING,
+			                                             parameters_.filename);
+			observeData_ = new ObserveDataFile::Out(file);
+			observeData_->startThread(parameters_.observeDataWriteBudget*1024*1024);
+		}
 	}
 
 	~DmrgSolver()
 	{
+		delete observeData_;
+		observeData_ = 0;
+
 		Finalize finalize(appInfo_);
 		ioOut_.action(finalize);
 
@@ -309,6 +327,14 @@ public:
 
 		finiteDmrgLoops(S,E,pS,pE,*psi);
 
+		PsimagLite::String file = utils::pathPrepend(ProgramGlobals::IN_SITU_STRING,
+		                                             parameters_.filename);
+		correlationsInSitu_.write(file,parameters_.precision);
+
+		file = utils::pathPrepend(ProgramGlobals::STRUCTURE_FACTOR_STRING,
+		                          parameters_.filename);
+		psi->write(file,parameters_.precision);
+
 		inSitu_.init(*psi,geometry.numberOfSites());
 
 		delete psi;
@@ -403,7 +429,7 @@ private:
 
 			updateQuantumSector(lrs_.sites(),ProgramGlobals::INFINITE,step);
 
-			lrs_.setToProduct(quantumSector_);
+			lrs_.setToProduct(quantumSector_,parameters_);
 
 			const BlockType& ystep = findRightBlock(Y,step,E);
 			energy_ = diagonalization_(psi,ProgramGlobals::INFINITE,X[step],ystep);
@@ -499,6 +525,7 @@ private:
 			}
 
 			finiteStep(S,E,pS,pE,i,psi);
+			printStackStats(i);
 			if (psi.end()) break;
 			recovery.save(psi,sitesIndices_[stepCurrent_],lastSign,false);
 		}
@@ -511,6 +538,19 @@ private:
 		ioOut_<<msg2.str();
 	}
 
+	void printStackStats(SizeType loopIndex) const
+	{
+		DiskStackCompression::Stats stats;
+		checkpoint_.takeStackStats(stats);
+		wft_.takeStackStats(stats);
+		if (stats.empty()) return;
+
+		PsimagLite::OstringStream msg;
+		msg<<"Finite loop number "<<loopIndex<<" stacks ";
+		msg<<DiskStackCompression::codecName()<<": "<<stats;
+		progress_.printline(msg,std::cout);
+	}
+
 	void finiteStep(BlockType const &,
 	                BlockType const &,
 	                MyBasisWithOperators &pS,
@@ -537,6 +577,9 @@ private:
 			stepLengthCorrected = int((stepLength+sitesPerBlock-1)/sitesPerBlock);
 		int stepFinal = stepCurrent_+stepLengthCorrected;
 
+		bool measureInSitu = (correlationsInSitu_.enabled() &&
+		                      loopIndex == lastLoopToTheRight());
+
 		while (true) {
 			if (SizeType(stepCurrent_)>=sitesIndices_.size())
 				throw PsimagLite::RuntimeError("stepCurrent_ too large!\n");
@@ -564,7 +607,7 @@ private:
 
 			updateQuantumSector(lrs_.sites(),direction,stepCurrent_);
 
-			lrs_.setToProduct(quantumSector_);
+			lrs_.setToProduct(quantumSector_,parameters_);
 
 			bool needsPrinting = (saveOption & 1);
 			energy_ = diagonalization_(target,
@@ -574,8 +617,12 @@ private:
 			                           needsPrinting);
 			printEnergy(energy_);
 
+			if (measureInSitu) correlationsInSitu_.measure(lrs_,pS,target.gs());
+
 			changeTruncateAndSerialize(pS,pE,target,keptStates,direction,saveOption);
 
+			if (measureInSitu) correlationsInSitu_.advance(truncate_.transform(direction));
+
 			if (finalStep(stepLength,stepFinal)) break;
 			if (stepCurrent_<0) {
 				PsimagLite::String msg("DmrgSolver::finiteStep()");
@@ -636,16 +683,37 @@ private:
 		if (!(saveOption & 1)) return;
 		if (!saveData_) return;
 
-		SparseMatrixType transform;
-		truncate_.transform(direction).toSparse(transform);
-		DmrgSerializerType ds(fsS,fsE,lrs_,target.gs(),transform,direction);
+		DmrgSerializerType ds(fsS,
+		                      fsE,
+		                      lrs_,
+		                      target.gs(),
+		                      truncate_.transform(direction),
+		                      direction);
 
 		SizeType saveOption2 = (saveOption & 4) ? SAVE_ALL : SAVE_PARTIAL;
-		ds.save(ioOut_,saveOption2,model_.geometry().numberOfSites());
+		if (observeData_) {
+			DiskStackBinaryOut io;
+			ds.save(io,saveOption2,model_.geometry().numberOfSites());
+			DiskStackBinaryOut::VectorCharType buffer;
+			io.swap(buffer);
+			observeData_->write(buffer,ds.site(),direction);
+		} else {
+			ds.save(ioOut_,saveOption2,model_.geometry().numberOfSites());
+		}
 
 		target.save(sitesIndices_[stepCurrent_],ioOut_);
 	}
 
+	// the finite loop where InSituTwoPoint is measured
+	SizeType lastLoopToTheRight() const
+	{
+		SizeType loops = parameters_.finiteLoop.size();
+		for (SizeType i = loops; i > 0; --i)
+			if (parameters_.finiteLoop[i - 1].stepLength > 0) return i - 1;
+
+		return loops;
+	}
+
 	bool finalStep(int stepLength,int stepFinal)
 	{
 		if (stepLength<0) {
@@ -732,8 +800,10 @@ private:
 	DiagonalizationType diagonalization_;
 	TruncationType truncate_;
 	ObservablesInSituType inSitu_;
+	CorrelationsInSituType correlationsInSitu_;
 	RealType energy_;
 	bool saveData_;
+	ObserveDataFile::Out* observeData_;
 }; //class DmrgSolver
 } // namespace Dmrg
 
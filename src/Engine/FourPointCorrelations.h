@@ -83,6 +83,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 #include "CrsMatrix.h"
 #include "Braket.h"
+#include "GrownOperatorCache.h"
 
 namespace Dmrg {
 template<typename CorrelationsSkeletonType>
@@ -108,15 +109,22 @@ public:
 	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
 	typedef typename PsimagLite::Vector<SparseMatrixType>::Type VectorSparseMatrixType;
 	typedef typename CorrelationsSkeletonType::BraketType BraketType;
+	typedef GrownOperatorCache<SparseMatrixType> GrownOperatorCacheType;
 
+	// cacheBudget is in megabytes, for the operators grown by the first
+	// and middle stages; 0 disables the cache
 	FourPointCorrelations(ObserverHelperType& precomp,
 	                      CorrelationsSkeletonType& skeleton,
+	                      SizeType cacheBudget = 0,
 	                      bool verbose=false)
-	    : helper_(precomp),skeleton_(skeleton),verbose_(verbose)
+	    : helper_(precomp),
+	      skeleton_(skeleton),
+	      verbose_(verbose),
+	      cache_(cacheBudget*1024*1024)
 	{
 	}
 
-	//! Four-point: these are expensive and uncached!!!
+	//! Four-point: O1 O2 grown up to i3 are cached, see grownPrefix
 	//! requires i1<i2<i3<i4
 	FieldType operator()(SizeType i1,
 	                     SizeType i2,
@@ -134,14 +142,26 @@ public:
 		if (i2==i3 || i1==i4)
 			throw PsimagLite::RuntimeError("calcCorrelation: FourPoint needs distinct points\n");
 
-		SparseMatrixType O2gt;
+		return fourPoint(i1,i2,'C',i3,'C',i4,braket,threadId);
+	}
 
-		firstStage(O2gt,'N',i1,'N',i2,braket,0,1,threadId);
+	//! As above but with modifiers for the last two operators
+	FieldType fourPoint(SizeType i1,
+	                    SizeType i2,
+	                    char mod3,
+	                    SizeType i3,
+	                    char mod4,
+	                    SizeType i4,
+	                    const BraketType& braket,
+	                    SizeType threadId) const
+	{
+		SparseMatrixType Otmp;
+		grownPrefix(Otmp,i1,i2,i3-1,braket,threadId);
 
-		return secondStage(O2gt,i2,'C',i3,'C',i4,braket,2,3,threadId);
+		return secondStageGrown(Otmp,mod3,i3,mod4,i4,braket,2,3,threadId);
 	}
 
-	//! 3-point: these are expensive and uncached!!!
+	//! 3-point: O1 O2 grown up to i3 are cached, see grownPrefix
 	//! requires i1<i2<i3
 	FieldType threePoint(SizeType i1,
 	                     SizeType i2,
@@ -154,11 +174,10 @@ public:
 		if (i1==i2 || i1==i3 || i2==i3)
 			throw PsimagLite::RuntimeError("calcCorrelation: FourPoint needs distinct points\n");
 
-		SparseMatrixType O2gt;
-
-		firstStage(O2gt,'N',i1,'N',i2,braket,0,1,threadId);
+		SparseMatrixType Otmp;
+		grownPrefix(Otmp,i1,i2,i3-1,braket,threadId);
 
-		return secondStage(O2gt,i2,'N',i3,braket,2,threadId);
+		return secondStageGrown(Otmp,'N',i3,braket,2,threadId);
 	}
 
 	//! 4-points or more: these are expensive and uncached!!!
@@ -267,11 +286,6 @@ public:
 	                      SizeType index1,
 	                      SizeType threadId) const
 	{
-		// Take care of modifiers
-		SparseMatrixType O3m,O4m;
-		skeleton_.createWithModification(O3m,braket.op(index0).data,mod3);
-		skeleton_.createWithModification(O4m,braket.op(index1).data,mod4);
-
 		int ns = i3-1;
 		if (ns<0) ns = 0;
 		helper_.setPointer(threadId,ns);
@@ -285,6 +299,27 @@ public:
 			std::cerr<<Otmp;
 		}
 
+		return secondStageGrown(Otmp,mod3,i3,mod4,i4,braket,index0,index1,threadId);
+	}
+
+	//! secondStage from Otmp, the operator already grown up to i3
+	FieldType secondStageGrown(SparseMatrixType& Otmp,
+	                           char mod3,
+	                           SizeType i3,
+	                           char mod4,
+	                           SizeType i4,
+	                           const BraketType& braket,
+	                           SizeType index0,
+	                           SizeType index1,
+	                           SizeType threadId) const
+	{
+		// Take care of modifiers
+		SparseMatrixType O3m,O4m;
+		skeleton_.createWithModification(O3m,braket.op(index0).data,mod3);
+		skeleton_.createWithModification(O4m,braket.op(index1).data,mod4);
+
+		int ns = i3-1;
+		if (ns<0) ns = 0;
 		SparseMatrixType O3g,O4g;
 		if (i4==skeleton_.numberOfSites(threadId)-1) {
 			if (i3<i4-1) { // not tested
@@ -396,10 +431,6 @@ private:
 	                      SizeType index,
 	                      SizeType threadId) const
 	{
-		// Take care of modifiers
-		SparseMatrixType O3m;
-		skeleton_.createWithModification(O3m,braket.op(index).data,mod3);
-
 		int ns = i3-1;
 		if (ns<0) ns = 0;
 		SparseMatrixType Otmp;
@@ -411,6 +442,23 @@ private:
 			std::cerr<<Otmp;
 		}
 
+		return secondStageGrown(Otmp,mod3,i3,braket,index,threadId);
+	}
+
+	//! requires i2<i3, with Otmp already grown up to i3
+	FieldType secondStageGrown(const SparseMatrixType& Otmp,
+	                           char mod3,
+	                           SizeType i3,
+	                           const BraketType& braket,
+	                           SizeType index,
+	                           SizeType threadId) const
+	{
+		// Take care of modifiers
+		SparseMatrixType O3m;
+		skeleton_.createWithModification(O3m,braket.op(index).data,mod3);
+
+		int ns = i3-1;
+		if (ns<0) ns = 0;
 		if (i3 == skeleton_.numberOfSites(threadId)-1) {
 			helper_.setPointer(threadId,i3-2);
 			return skeleton_.bracketRightCorner(Otmp,
@@ -431,6 +479,34 @@ private:
 		return skeleton_.bracket(O3g,braket.op(index).fermionSign,threadId);
 	}
 
+	// Otmp is O1 at i1 times O2 at i2, grown through the sites before ns,
+	// as secondStage grows it. The cache keeps it and the product at i2
+	// alone; the grown operator of the same O1, O2, i1 and i2 that is
+	// grown the furthest up to ns is grown only the rest of the way
+	void grownPrefix(SparseMatrixType& Otmp,
+	                 SizeType i1,
+	                 SizeType i2,
+	                 SizeType ns,
+	                 const BraketType& braket,
+	                 SizeType threadId) const
+	{
+		PsimagLite::String key = "N" + braket.opName(0) + ";N" + braket.opName(1) +
+		        ";" + ttos(i1) + ";" + ttos(i2);
+		SizeType grownTo = 0;
+		if (!cache_.find(Otmp,grownTo,key,ns)) {
+			firstStage(Otmp,'N',i1,'N',i2,braket,0,1,threadId);
+			grownTo = i2;
+			cache_.insert(key,grownTo,Otmp);
+		}
+
+		if (grownTo >= ns) return;
+
+		int fermionS = braket.op(1).fermionSign;
+		SparseMatrixType Osrc = Otmp;
+		growDirectly4p(Otmp,Osrc,grownTo+1,fermionS,ns,threadId);
+		cache_.insert(key,ns,Otmp);
+	}
+
 	//! i can be zero here!!
 	void growDirectly4p(SparseMatrixType& Odest,
 	                    const SparseMatrixType& Osrc,
@@ -476,6 +552,7 @@ private:
 	ObserverHelperType& helper_; // <-- NB: not the owner
 	CorrelationsSkeletonType& skeleton_; // <-- NB: not the owner
 	bool verbose_;
+	mutable GrownOperatorCacheType cache_;
 };  //class FourPointCorrelations
 } // namespace Dmrg
 
@@ -0,0 +1,150 @@
+#ifndef GROWNOPERATORCACHE_H
+#define GROWNOPERATORCACHE_H
+#include "Vector.h"
+#include <map>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+/* Operators grown site by site, kept under a budget of memory
+
+   An entry is an operator named by key, for example the product of the
+   first two operators of a correlation at their sites, grown through
+   all sites before grownTo. find() returns the entry of key grown the
+   furthest without passing a given site, so that callers only grow the
+   rest. When the entries exceed the budget the least recently used ones
+   are dropped. Safe to call from several threads.
+*/
+namespace Dmrg {
+
+template<typename SparseMatrixType>
+class GrownOperatorCache {
+
+	typedef typename SparseMatrixType::value_type FieldType;
+	typedef std::pair<PsimagLite::String, SizeType> PairStringSizeType;
+
+	struct Entry {
+		SparseMatrixType data;
+		SizeType bytes;
+		SizeType lastUse;
+	};
+
+	typedef std::map<PairStringSizeType, Entry> MapType;
+
+public:
+
+	// budget is in bytes; 0 disables the cache
+	GrownOperatorCache(SizeType budget)
+	    : budget_(budget), used_(0), clock_(0)
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_init(&mutex_, 0);
+#endif
+	}
+
+	~GrownOperatorCache()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_destroy(&mutex_);
+#endif
+	}
+
+	bool enabled() const { return (budget_ > 0); }
+
+	// Copies into O the entry of key with the largest grownTo not above upTo,
+	// and sets grownTo to it; returns false if there is none
+	bool find(SparseMatrixType& O,
+	          SizeType& grownTo,
+	          const PsimagLite::String& key,
+	          SizeType upTo)
+	{
+		if (!enabled()) return false;
+
+		lock();
+		typename MapType::iterator it = entries_.upper_bound(PairStringSizeType(key, upTo));
+		bool found = (it != entries_.begin());
+		if (found) {
+			--it;
+			found = (it->first.first == key);
+		}
+
+		if (found) {
+			it->second.lastUse = ++clock_;
+			O = it->second.data;
+			grownTo = it->first.second;
+		}
+
+		unlock();
+		return found;
+	}
+
+	void insert(const PsimagLite::String& key,
+	            SizeType grownTo,
+	            const SparseMatrixType& O)
+	{
+		SizeType bytes = O.nonZeros()*(sizeof(FieldType) + sizeof(int)) +
+		        (O.rows() + 1)*sizeof(int);
+		if (!enabled() || bytes > budget_) return;
+
+		lock();
+		PairStringSizeType index(key, grownTo);
+		typename MapType::iterator it = entries_.find(index);
+		if (it != entries_.end()) {
+			used_ -= it->second.bytes;
+			entries_.erase(it);
+		}
+
+		while (used_ + bytes > budget_ && entries_.size() > 0)
+			evictOne();
+
+		Entry& entry = entries_[index];
+		entry.data = O;
+		entry.bytes = bytes;
+		entry.lastUse = ++clock_;
+		used_ += bytes;
+		unlock();
+	}
+
+private:
+
+	GrownOperatorCache(const GrownOperatorCache&);
+
+	GrownOperatorCache& operator=(const GrownOperatorCache&);
+
+	void evictOne()
+	{
+		typename MapType::iterator oldest = entries_.begin();
+		typename MapType::iterator it = entries_.begin();
+		for (; it != entries_.end(); ++it)
+			if (it->second.lastUse < oldest->second.lastUse) oldest = it;
+
+		used_ -= oldest->second.bytes;
+		entries_.erase(oldest);
+	}
+
+	void lock()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex_);
+#endif
+	}
+
+	void unlock()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&mutex_);
+#endif
+	}
+
+	SizeType budget_;
+	SizeType used_;
+	SizeType clock_;
+	MapType entries_;
+#ifdef USE_PTHREADS
+	pthread_mutex_t mutex_;
+#endif
+}; // class GrownOperatorCache
+
+} // namespace Dmrg
+
+#endif // GROWNOPERATORCACHE_H
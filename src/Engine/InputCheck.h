@@ -174,6 +174,8 @@ public:
 		knownLabels_.push_back("CorrectionVectorOmega");
 		knownLabels_.push_back("CorrectionVectorEta");
 		knownLabels_.push_back("CorrectionVectorAlgorithm");
+		knownLabels_.push_back("CorrectionVectorSqPoints");
+		knownLabels_.push_back("CorrectionVectorSqPeriodic");
 		knownLabels_.push_back("CorrelationsType");
 		knownLabels_.push_back("LongChainDistance");
 		knownLabels_.push_back("IsPeriodicY");
@@ -195,6 +197,12 @@ public:
 		knownLabels_.push_back("GeometryMaxConnections");
 		knownLabels_.push_back("LanczosNoSaveLanczosVectors");
 		knownLabels_.push_back("DenseSparseThreshold");
+		knownLabels_.push_back("DiskStackPrefetch");
+		knownLabels_.push_back("DiskStackWriteBudget");
+		knownLabels_.push_back("ObserveDataWriteBudget");
+		knownLabels_.push_back("ObserveWindow");
+		knownLabels_.push_back("FourPointCacheBudget");
+		knownLabels_.push_back("InSituTwoPoint");
 		knownLabels_.push_back("TridiagonalEps");
 	}
 
@@ -321,6 +329,10 @@ public:
 			\item[tarEnable] Tar output files
 			\item[tarNoDelete] Do not delete output files after taring them.
 			\item[recoveryNoDelete] Do not delete recovery files even if run finishes OK
+			\item[incrementalRecovery] Recovery points write, in the background, only the
+			stack entries pushed since the previous one, to the binary journals
+			SystemStackRecoveryJournal and EnvironStackRecoveryJournal, and
+			small index files instead of full copies of the stacks
 			\item[neverNormalizeVectors] TBW
 			\item [advanceOnlyAtBorder] Advance time only at borders
 			\item [findSymmetrySector] Find symmetry sector with lowest energy, and
@@ -335,8 +347,33 @@ public:
 							   instead of to and from memory
 			\item [wftWithTemp] Accelerate the WFT by using a temporary
 			\item [wftInBlocks] Accelerate the WFT by using dense blocks
+			\item [wftSparseTwoSite] Use sparse loops for the two-site WFT
+							   instead of the default dense products per symmetry sector
 			\item [wftStacksInDisk] Save and load stacks for WFT to and from disk,
 							   instead of to and from memory. Cannot be used with restart yet.
+			\item [binaryStacks] Stacks saved to disk with diskstacks or wftStacksInDisk
+							   use an indexed binary format instead of text
+			\item [compressedStacks] Binary stacks are compressed, with zlib if
+							   compiled with USE_ZLIB, and otherwise with a byte shuffle and
+							   run length encoding
+			\item [binaryObserveData] dmrg saves the data for observe in an indexed
+							   binary file with prefix ObserveData instead of in the text data
+							   file; time vectors stay in the text file. observe reads this
+							   binary file, converting the text data file into it first if it
+							   does not exist
+			\item [observeDistributed] With MPI, each rank of observe computes
+							   some of the rows of the two-point correlations, and all ranks
+							   get all rows at the end. With binaryObserveData and
+							   ObserveWindow, each rank reads only the data its rows need
+			\item [blockSparseOperators] Rotate and expand local operators by blocks
+			of symmetry sectors. Not supported for SU(2).
+			\item [lazySuperBasis] Build the superblock basis keeping only the
+			tables of its symmetry sectors; permutations are computed on demand.
+			Ignored for SU(2).
+			\item [connectedOperatorsOnly] On truncation, keep the local operators
+			of a block only for the sites that the geometry connects to a site out
+			of the block, instead of those of the most recent GeometryMaxConnections
+			sites. Removed operators cannot be used afterwards.
 		\end{itemize}
 		*/
 	void check(const PsimagLite::String& label,
@@ -381,6 +418,7 @@ public:
 		registerOpts.push_back("tarNoDelete");
 		registerOpts.push_back("tarCoutNoDelete");
 		registerOpts.push_back("recoveryNoDelete");
+		registerOpts.push_back("incrementalRecovery");
 		registerOpts.push_back("normalizeTimeVectors");
 		registerOpts.push_back("neverNormalizeVectors");
 		registerOpts.push_back("noSaveStacks");
@@ -397,9 +435,17 @@ public:
 		registerOpts.push_back("setAffinities");
 		registerOpts.push_back("wftInPatches");
 		registerOpts.push_back("wftInBlocks");
+		registerOpts.push_back("wftSparseTwoSite");
 		registerOpts.push_back("diskstacks");
 		registerOpts.push_back("wftWithTemp");
 		registerOpts.push_back("wftStacksInDisk");
+		registerOpts.push_back("binaryStacks");
+		registerOpts.push_back("compressedStacks");
+		registerOpts.push_back("binaryObserveData");
+		registerOpts.push_back("observeDistributed");
+		registerOpts.push_back("blockSparseOperators");
+		registerOpts.push_back("lazySuperBasis");
+		registerOpts.push_back("connectedOperatorsOnly");
 
 		PsimagLite::Options::Writeable optWriteable(registerOpts,
 		                                            PsimagLite::Options::Writeable::PERMISSIVE);
@@ -75,7 +75,10 @@ public:
 		printOneBasis("Right",lrs.right(),p->nOfQns);
 
 		fout_<<"#SuperBasisPermutation\n";
-		fout_<<lrs.super().permutationVector();
+		VectorSizeType permutation(lrs.super().size());
+		for (SizeType i = 0; i < permutation.size(); ++i)
+			permutation[i] = lrs.super().permutation(i);
+		fout_<<permutation;
 		SizeType qtarget = lrs.super().qn(lrs.super().partition(m));
 
 		PairSizeType etarget = getNupNdown(qtarget,p->nOfQns);
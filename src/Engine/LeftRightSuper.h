@@ -195,10 +195,16 @@ public:
 		return left_->block().size() + right_->block().size();
 	}
 
+	// lazySuperBasis in SolverOptions= builds the superblock basis with
+	// setToProductLazy
 	/*!PTEX_LABEL{setToProductLrs} */
-	void setToProduct(SizeType quantumSector)
+	template<typename SomeParametersType>
+	void setToProduct(SizeType quantumSector, const SomeParametersType& params)
 	{
-		super_->setToProduct(*left_,*right_,quantumSector);
+		if (params.options.find("lazySuperBasis") != PsimagLite::String::npos)
+			super_->setToProductLazy(*left_,*right_,quantumSector);
+		else
+			super_->setToProduct(*left_,*right_,quantumSector);
 	}
 
 	template<typename IoOutputType>
@@ -298,7 +304,7 @@ private:
 		BasisWithOperatorsType Xbasis("Xbasis");
 
 		Xbasis.setVarious(X,hmatrix,q,creationMatrix);
-		leftOrRight.setToProduct(pS,Xbasis,dir);
+		leftOrRight.setToProduct(pS,Xbasis,dir,model.params());
 
 		SparseMatrixType matrix=leftOrRight.hamiltonian();
 
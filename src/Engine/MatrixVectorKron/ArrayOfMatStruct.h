@@ -82,6 +82,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #define ARRAY_OF_MAT_STRUCT_H
 #include "GenIjPatch.h"
 #include "CrsMatrix.h"
+#include "../BlockSparseOperator.h"
 #include "../KronUtil/MatrixDenseOrSparse.h"
 
 namespace Dmrg {
@@ -99,6 +100,7 @@ public:
 	typedef GenIjPatch<LeftRightSuperType> GenIjPatchType;
 	typedef typename GenIjPatchType::VectorSizeType VectorSizeType;
 	typedef typename GenIjPatchType::BasisType BasisType;
+	typedef BlockSparseOperator<typename SparseMatrixType::value_type> BlockSparseOperatorType;
 
 	ArrayOfMatStruct(const SparseMatrixType& sparse,
 	                 const GenIjPatchType& patchOld,
@@ -113,6 +115,14 @@ public:
 		            patchNew.lrs().left() : patchNew.lrs().right();
 		SizeType npatchOld = patchOld(leftOrRight).size();
 		SizeType npatchNew = patchNew(leftOrRight).size();
+
+		// the blocks of sparse are found once, and not once per patch
+		typename BlockSparseOperatorType::VectorSizeType rowPartition;
+		typename BlockSparseOperatorType::VectorSizeType colPartition;
+		BlockSparseOperatorType::partitionFromBasis(rowPartition, basisNew, sparse.rows());
+		BlockSparseOperatorType::partitionFromBasis(colPartition, basisOld, sparse.cols());
+		BlockSparseOperatorType blocks(sparse, rowPartition, colPartition);
+
 		for (SizeType jpatch=0; jpatch < npatchOld; ++jpatch) {
 			SizeType jgroup = patchOld(leftOrRight)[jpatch];
 			SizeType j1 = basisOld.partition(jgroup);
@@ -127,22 +137,8 @@ public:
 
 				data_(ipatch, jpatch) = new MatrixDenseOrSparseType(rows, cols);
 
-				MatrixType& m = data_(ipatch, jpatch)->matrix();
-
-				// for WFT we need padding of the matrices:
-				if (i2 > sparse.rows()) i2 = sparse.rows();
-
-				for (SizeType ii = i1; ii < i2; ++ii) {
-					SizeType start = sparse.getRowPtr(ii);
-					SizeType end = sparse.getRowPtr(ii+1);
-					for (SizeType k = start; k < end; ++k) {
-						int col = sparse.getCol(k) - j1;
-						if (col < 0) continue;
-						if (static_cast<SizeType>(col) >= cols)
-							continue;
-						m(ii - i1, col) = sparse.getValue(k);
-					}
-				}
+				// for WFT we need padding of the matrices, which fillPatch does
+				blocks.fillPatch(data_(ipatch, jpatch)->matrix(), igroup, jgroup);
 
 				data_(ipatch, jpatch)->finalize(threshold);
 			}
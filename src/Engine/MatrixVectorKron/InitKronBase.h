@@ -299,7 +299,7 @@ protected:
 	             const VectorType& xout,
 	             const VectorSizeType& vstart) const
 	{
-		const VectorSizeType& permInverse = lrs(NEW).super().permutationInverse();
+		const BasisType& super = lrs(NEW).super();
 		SizeType offset1 = offset(NEW);
 		SizeType nl = lrs(NEW).left().hamiltonian().rows();
 		SizeType npatches = patch(NEW, GenIjPatchType::LEFT).size();
@@ -329,9 +329,9 @@ protected:
 					assert(i < nl);
 					assert(j < lrs(NEW).right().hamiltonian().rows());
 
-					assert(i + j*nl < permInverse.size());
+					assert(i + j*nl < super.size());
 
-					SizeType r = permInverse[i + j*nl];
+					SizeType r = super.permutationInverse(i + j*nl);
 					assert( !(  (r < offset1) || (r >= (offset1 + size(NEW))) ) );
 
 					SizeType ip = vstart[ipatch] + (iright + ileft * sizeRight);
@@ -143,7 +143,7 @@ public:
 		VectorType& xout = xout_;
 		VectorType& yin = yin_;
 
-		const VectorSizeType& permInverse = BaseType::lrs(BaseType::NEW).super().permutationInverse();
+		const BasisType& super = BaseType::lrs(BaseType::NEW).super();
 		const SparseMatrixType& leftH = BaseType::lrs(BaseType::NEW).left().hamiltonian();
 		SizeType nl = leftH.rows();
 
@@ -177,9 +177,9 @@ public:
 					assert(i < nl);
 					assert(j < BaseType::lrs(BaseType::NEW).right().hamiltonian().rows());
 
-					assert(ij < permInverse.size());
+					assert(ij < super.size());
 
-					SizeType r = permInverse[ ij ];
+					SizeType r = super.permutationInverse(ij);
 					assert(!((r < offset) || (r >= (offset + BaseType::size(BaseType::NEW)))));
 
 					SizeType ip = vstart_[ipatch] + (iright + ileft * sizeRight);
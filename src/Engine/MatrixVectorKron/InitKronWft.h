@@ -223,7 +223,7 @@ private:
 	            const VectorSizeType& vstart,
 	            typename BaseType::WhatBasisEnum what) const
 	{
-		const VectorSizeType& permInverse = BaseType::lrs(what).super().permutationInverse();
+		const BasisType& super = BaseType::lrs(what).super();
 		const SparseMatrixType& leftH = BaseType::lrs(what).left().hamiltonian();
 		SizeType nl = leftH.rows();
 
@@ -257,9 +257,9 @@ private:
 					assert(i < nl);
 					assert(j < BaseType::lrs(what).right().hamiltonian().rows());
 
-					assert(ij < permInverse.size());
+					assert(ij < super.size());
 
-					SizeType r = permInverse[ ij ];
+					SizeType r = super.permutationInverse(ij);
 					assert(ipatch < vstart.size());
 					SizeType ip = vstart[ipatch] + (iright + ileft * sizeRight);
 					assert(ip < x.size());
@@ -311,9 +311,7 @@ private:
 				SizeType alphaPrime = packLeft.pack(alpha0,
 				                                    alpha1Prime,
 				                                    lrs_.left().permutationInverse());
-				SizeType iprime = packSuper.pack(alphaPrime,
-				                                 beta,
-				                                 lrs_.super().permutationInverse());
+				SizeType iprime = lrs_.super().permutationInverse(alphaPrime + beta*ns);
 				w.slowAccess(i+offset) += v.slowAccess(iprime)*
 				        collapseBasis_(alpha1Prime,indexFixed)*
 				        collapseBasis_(alpha1,indexFixed);
@@ -340,9 +338,7 @@ private:
 			packSuper.unpack(alpha,beta,lrs_.super().permutation(i+offset));
 
 			for (SizeType betaPrime=0;betaPrime<nk;betaPrime++) {
-				SizeType iprime = packSuper.pack(alpha,
-				                                 betaPrime,
-				                                 lrs_.super().permutationInverse());
+				SizeType iprime = lrs_.super().permutationInverse(alpha + betaPrime*ns);
 				w.slowAccess(i+offset) += v.slowAccess(iprime)*
 				        collapseBasis_(betaPrime,indexFixed)*
 				        collapseBasis_(beta,indexFixed);
@@ -386,9 +382,7 @@ private:
 				SizeType betaPrime =  packRight.pack(beta0Prime,
 				                                     beta1,
 				                                     lrs_.right().permutationInverse());
-				SizeType iprime = packSuper.pack(alpha,
-				                                 betaPrime,
-				                                 lrs_.super().permutationInverse());
+				SizeType iprime = lrs_.super().permutationInverse(alpha + betaPrime*ns);
 				w.slowAccess(i+offset) += v.slowAccess(iprime)*
 				        collapseBasis_(beta0Prime,indexFixed)*
 				        collapseBasis_(beta0,indexFixed);
@@ -414,9 +408,7 @@ private:
 			packSuper.unpack(alpha,beta,lrs_.super().permutation(i+offset));
 
 			for (SizeType alphaPrime=0;alphaPrime<nk;alphaPrime++) {
-				SizeType iprime = packSuper.pack(alphaPrime,
-				                                 beta,
-				                                 lrs_.super().permutationInverse());
+				SizeType iprime = lrs_.super().permutationInverse(alphaPrime + beta*ns);
 				w.slowAccess(i+offset) += v.slowAccess(iprime)*
 				        collapseBasis_(alphaPrime,indexFixed)*
 				        collapseBasis_(alpha,indexFixed);
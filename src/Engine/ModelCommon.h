@@ -135,6 +135,9 @@ public:
 
 		Su2SymmetryGlobals<RealType>::init(ModelHelperType::isSu2());
 		MyBasis::useSu2Symmetry(ModelHelperType::isSu2());
+
+		if (OperatorsType::useBlockSparse(params) && ModelHelperType::isSu2())
+			throw PsimagLite::RuntimeError("blockSparseOperators does not support SU(2)\n");
 	}
 
 	/** Let H be the hamiltonian of the  model for basis1 and partition m
@@ -431,13 +431,22 @@ private:
 		if (type==System) {
 			PairType ii =lrs_.left().getOperatorIndices(i,sigma);
 			assert(ii.first<basis2tc_.size());
+			if (lrs_.left().isOperatorRemoved(ii.first)) throwRemoved(i,sigma);
 			return basis2tc_[ii.first];
 		}
 		PairType ii =lrs_.right().getOperatorIndices(i,sigma);
 		assert(ii.first<basis3tc_.size());
+		if (lrs_.right().isOperatorRemoved(ii.first)) throwRemoved(i,sigma);
 		return basis3tc_[ii.first];
 	}
 
+	static void throwRemoved(SizeType i,SizeType sigma)
+	{
+		PsimagLite::String msg("ModelHelperLocal: operator sigma=" + ttos(sigma));
+		msg += " for block site " + ttos(i) + " was removed from its basis\n";
+		throw PsimagLite::RuntimeError(msg);
+	}
+
 	void createBuffer()
 	{
 		SizeType ns=lrs_.left().size();
@@ -460,9 +469,10 @@ private:
 	                       const BasisWithOperatorsType& basis)
 	{
 		if (basistc.size()==0) return;
-		SizeType n=basis.getOperatorByIndex(0).data.rows();
+		SizeType n=basis.hamiltonian().rows();
 		bool b = true;
 		for (SizeType i=0;i<basistc.size();i++) {
+			if (basis.isOperatorRemoved(i)) continue;
 			if (basis.getOperatorByIndex(i).data.rows()!=n) {
 				b=false;
 				break;
@@ -475,18 +485,21 @@ private:
 	void createTcOperatorsSimple(VectorSparseMatrixType& basistc,
 	                             const BasisWithOperatorsType& basis)
 	{
-		for (SizeType i=0;i<basistc.size();i++)
+		for (SizeType i=0;i<basistc.size();i++) {
+			if (basis.isOperatorRemoved(i)) continue;
 			transposeConjugate(basistc[i],basis.getOperatorByIndex(i).data);
+		}
 	}
 
 	void createTcOperatorsCached(VectorSparseMatrixType& basistc,
 	                             const BasisWithOperatorsType& basis)
 	{
 		if (basistc.size()==0) return;
-		SizeType n=basis.getOperatorByIndex(0).data.rows();
+		SizeType n=basis.hamiltonian().rows();
 		typename PsimagLite::Vector<PsimagLite::Vector<int>::Type>::Type col(n);
 		typename PsimagLite::Vector<VectorSparseElementType>::Type value(n);
 		for (SizeType i=0;i<basistc.size();i++) {
+			if (basis.isOperatorRemoved(i)) continue;
 			const SparseMatrixType& tmp = basis.getOperatorByIndex(i).data;
 			assert(tmp.rows()==n);
 			transposeConjugate(basistc[i],tmp,col,value);
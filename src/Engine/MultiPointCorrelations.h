@@ -83,6 +83,13 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "VectorWithOffsets.h" // for operator*
 #include "VectorWithOffset.h" // for operator*
 #include "Profiling.h"
+#ifdef USE_PTHREADS
+#include "PthreadsNg.h"
+#else
+#include "NoPthreadsNg.h"
+#endif
+#include "ParallelMultiPointCorrelations.h"
+#include <algorithm>
 
 namespace Dmrg {
 
@@ -99,7 +106,6 @@ class MultiPointCorrelations {
 	typedef typename BasisWithOperatorsType::RealType RealType;
 	typedef PsimagLite::Profiling ProfilingType;
 	typedef MultiPointCorrelations<CorrelationsSkeletonType> ThisType;
-	typedef typename CorrelationsSkeletonType::SparseMatrixType SparseMatrixType;
 
 	static SizeType const GROW_RIGHT = CorrelationsSkeletonType::GROW_RIGHT;
 	static SizeType const GROW_LEFT = CorrelationsSkeletonType::GROW_LEFT;
@@ -111,6 +117,9 @@ class MultiPointCorrelations {
 public:
 
 	typedef typename ObserverHelperType::MatrixType MatrixType;
+	typedef typename CorrelationsSkeletonType::SparseMatrixType SparseMatrixType;
+	typedef typename PsimagLite::Vector<SparseMatrixType>::Type VectorSparseMatrixType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
 
 	MultiPointCorrelations(SizeType nthreads,
 	                       ObserverHelperType& helper,
@@ -122,6 +131,10 @@ public:
 	      verbose_(verbose)
 	{}
 
+	// The operator of each i is grown from that of i-1, so growth is
+	// sequential; operators are grown in batches of nthreads, whose
+	// brackets are then computed in parallel, so that no more than one
+	// batch is kept in memory
 	template<typename VectorLikeType>
 	typename PsimagLite::EnableIf
 	<PsimagLite::IsVectorLike<VectorLikeType>::True,void>::Type
@@ -139,21 +152,61 @@ public:
 		identity.makeDiagonal(O.rows(),1.0);
 
 		size_t rowsOver2 = static_cast<size_t>(rows/2);
-
-		for (SizeType i=0;i<rowsOver2;i++) {
-			result[i] = calcCorrelation_(Og,i,O,identity,threadId);
+		SizeType batch = (nthreads_ > 0) ? nthreads_ : 1;
+
+		typedef ParallelMultiPointCorrelations<ThisType,VectorLikeType>
+		        ParallelMultiPointCorrelationsType;
+		// every rank computes all brackets, so only threads share them
+#ifdef USE_PTHREADS
+		typedef PsimagLite::PthreadsNg<ParallelMultiPointCorrelationsType> ThreadsOnlyType;
+#else
+		typedef PsimagLite::NoPthreadsNg<ParallelMultiPointCorrelationsType> ThreadsOnlyType;
+#endif
+
+		VectorSparseMatrixType O2gs;
+		VectorSizeType pointers;
+		for (SizeType i0=0;i0<rowsOver2;i0+=batch) {
+			SizeType total = std::min(batch,rowsOver2 - i0);
+			O2gs.resize(total);
+			pointers.resize(total);
+			for (SizeType x=0;x<total;x++)
+				pointers[x] = grow_(O2gs[x],Og,i0 + x,O,identity,threadId);
+
+			ThreadsOnlyType threadedMulti(PsimagLite::Concurrency::npthreads,0,false);
+
+			ParallelMultiPointCorrelationsType helperMulti(result,
+			                                               *this,
+			                                               O2gs,
+			                                               pointers,
+			                                               i0);
+
+			threadedMulti.loopCreate(helperMulti);
 		}
+
 		for (SizeType i=rowsOver2; i<rows; i++) result[i]=0;
 	}
 
+	// <O2g> at pointer, where O2g is grown by grow_
+	FieldType bracket(const SparseMatrixType& O2g,
+	                  SizeType pointer,
+	                  SizeType threadId)
+	{
+		int fermionicSign = 1;
+		helper_.setPointer(threadId,pointer);
+		return skeleton_.bracket(O2g,fermionicSign,threadId);
+	}
+
 private:
 
-	// from i to i+1
-	FieldType calcCorrelation_(SparseMatrixType& O2gt,
-	                           SizeType i,
-	                           const SparseMatrixType& O,
-	                           const SparseMatrixType& identity,
-	                           SizeType threadId)
+	// from i to i+1: O2g is the operator to bracket for i, and O2gt, the
+	// operator grown up to i, becomes that grown up to i+1; returns the
+	// pointer where O2g is to be bracketed
+	SizeType grow_(SparseMatrixType& O2g,
+	               SparseMatrixType& O2gt,
+	               SizeType i,
+	               const SparseMatrixType& O,
+	               const SparseMatrixType& identity,
+	               SizeType threadId)
 	{
 
 		if (i>=skeleton_.numberOfSites(threadId)-1)
@@ -161,12 +214,10 @@ private:
 		int fermionicSign = 1;
 
 		SizeType ns = i;
-		SparseMatrixType O2g;
 		if (i==0) {
 			skeleton_.growDirectly(O2gt,O,i,fermionicSign,ns,true,threadId);
 			skeleton_.dmrgMultiply(O2g,O2gt,identity,fermionicSign,ns,threadId);
-			FieldType ret = skeleton_.bracket(O2g,fermionicSign,threadId);
-			return ret;
+			return ns;
 		}
 
 		//			if (i==5) {
@@ -175,10 +226,9 @@ private:
 		//				skeleton_.dmrgMultiply(O2g,O2gt,identity,fermionicSign,ns-1,threadId);
 		//			}
 		O2gt.clear();
-		FieldType ret = skeleton_.bracket(O2g,fermionicSign,threadId);
 		helper_.setPointer(threadId,ns-1);
 		helper_.transform(O2gt,O2g,threadId);
-		return ret;
+		return ns-1;
 	}
 
 	SizeType nthreads_;
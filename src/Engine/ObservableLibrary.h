@@ -83,6 +83,8 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "PreOperatorSiteIndependent.h"
 #include "Concurrency.h"
 #include "Vector.h"
+#include <map>
+#include <algorithm>
 
 namespace Dmrg {
 
@@ -110,6 +112,9 @@ public:
 	typedef typename ObserverType::BraketType BraketType;
 	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
 	typedef std::pair<SizeType,SizeType> PairSizeType;
+	typedef typename BraketType::VectorStringType VectorStringType;
+	typedef typename BraketType::OperatorExpressionCacheType OperatorExpressionCacheType;
+	typedef std::map<PsimagLite::String, MatrixType> MapStringMatrixType;
 
 	template<typename IoInputter>
 	ObservableLibrary(IoInputter& io,
@@ -118,11 +123,13 @@ public:
 	                  const ModelType& model,
 	                  SizeType nf,
 	                  SizeType trail,
-	                  bool verbose)
+	                  bool verbose,
+	                  ObserveDataFile::In* dataFile = 0)
 	    : numberOfSites_(numberOfSites),
 	      hasTimeEvolution_(hasTimeEvolution),
 	      model_(model),
-	      observe_(io,nf,trail,hasTimeEvolution,model,verbose)
+	      observe_(io,nf,trail,hasTimeEvolution,model,verbose,dataFile),
+	      exprCache_(model)
 	{
 		PsimagLite::String modelName = model.params().model;
 		bool hubbardLike = (modelName == "HubbardOneBand" ||
@@ -146,7 +153,7 @@ public:
 		PsimagLite::split(vecStr, list, ",");
 
 		for (SizeType i = 0; i < vecStr.size(); ++i) {
-			BraketType braket(model_, vecStr[i]);
+			BraketType braket(model_,vecStr[i],&exprCache_);
 
 			SizeType threadId = 0;
 			if (braket.points() == 1) {
@@ -163,6 +170,77 @@ public:
 		}
 	}
 
+	// Computes now, in one traversal of the sites for each bra and ket,
+	// the two-point correlations without sites that items will ask for;
+	// manyPoint takes them from here then instead of computing them again
+	void prepareTwoPoint(const VectorStringType& items,
+	                     SizeType rows,
+	                     SizeType cols,
+	                     SizeType orbitals)
+	{
+		VectorStringType strs;
+		for (SizeType i = 0; i < items.size(); ++i) {
+			const PsimagLite::String& item = items[i];
+			if (item.find("%") == 0) continue;
+
+			if (item.length() > 0 && item[0] != '<') {
+				if (model_.params().model == "Immm") continue;
+				if (item == "ss") {
+					twoPointBrakets(strs,"szsz",orbitals);
+					twoPointBrakets(strs,"s+s-",orbitals);
+					twoPointBrakets(strs,"s-s+",orbitals);
+					continue;
+				}
+
+				twoPointBrakets(strs,item,orbitals);
+				continue;
+			}
+
+			VectorStringType vecStr;
+			PsimagLite::split(vecStr, item, ",");
+			strs.insert(strs.end(),vecStr.begin(),vecStr.end());
+		}
+
+		// brakets grouped by bra and ket; bad ones are left for interpret to report
+		typedef std::map<PsimagLite::String, VectorStringType> MapStringVectorType;
+		MapStringVectorType groups;
+		for (SizeType i = 0; i < strs.size(); ++i) {
+			try {
+				BraketType braket(model_,strs[i],&exprCache_);
+				if (braket.points() != 2 || hasSites(braket)) continue;
+				VectorStringType& group = groups[braket.bra() + "|" + braket.ket()];
+				if (std::find(group.begin(),group.end(),strs[i]) == group.end())
+					group.push_back(strs[i]);
+			} catch (std::exception&) {}
+		}
+
+		typename MapStringVectorType::const_iterator it = groups.begin();
+		for (; it != groups.end(); ++it) {
+			const VectorStringType& group = it->second;
+			SizeType n = group.size();
+			if (n < 2) continue;
+
+			typename ObserverType::VectorSparseMatrixType O1s(n), O2s(n);
+			typename ObserverType::VectorIntType fermionicSigns(n);
+			PsimagLite::String bra;
+			PsimagLite::String ket;
+			for (SizeType x = 0; x < n; ++x) {
+				BraketType braket(model_,group[x],&exprCache_);
+				O1s[x] = braket.op(0).data;
+				O2s[x] = braket.op(1).data;
+				fermionicSigns[x] = braket.op(0).fermionSign;
+				bra = braket.bra();
+				ket = braket.ket();
+			}
+
+			VectorMatrixType ms(n,MatrixType(rows,cols));
+			observe_.setBrakets(bra,ket);
+			observe_.twoPoint(ms,O1s,O2s,fermionicSigns);
+			for (SizeType x = 0; x < n; ++x)
+				prepared_[group[x]] = ms[x];
+		}
+	}
+
 	void measureTriage(const PsimagLite::String& label,
 	                   SizeType rows,
 	                   SizeType cols,
@@ -311,9 +389,11 @@ private:
 
 		// FIXME: No support for site varying operators
 		if (label=="cc") {
-			BraketType braket(model_,"<gs|c?0-;c'?0-|gs>");
+			VectorStringType brakets;
+			twoPointBrakets(brakets,label,orbitals);
+			BraketType braket(model_,brakets[0],&exprCache_);
 			manyPoint(0,braket,rows,cols); // c_{0,0} spin down
-			BraketType braket2(model_,"<gs|c?1-;c'?1-|gs>");
+			BraketType braket2(model_,brakets[1],&exprCache_);
 			manyPoint(0,braket2,rows,cols); // c_{0,0} spin down
 		} else if (label=="nn") {
 			MatrixType out(rows,cols);
@@ -355,12 +435,14 @@ private:
 
 		} else if (label=="szsz") {
 			resizeStorage(szsz_,rows,cols,orbitals);
+			VectorStringType brakets;
+			twoPointBrakets(brakets,label,orbitals);
 			MatrixType tSzTotal;
 			SizeType counter = 0;
 			for (SizeType i = 0; i < orbitals; ++i) {
 				for (SizeType j = i; j < orbitals; ++j) {
-					PsimagLite::String str = "<gs|z?" + ttos(i) + ";z?" + ttos(j) + "|gs>";
-					BraketType braket(model_,str);
+					PsimagLite::String str = brakets[counter];
+					BraketType braket(model_,str,&exprCache_);
 					manyPoint(&szsz_[counter],braket,rows,cols);
 					MatrixType tSzThis = szsz_[counter];
 					RealType factor = (i != j) ? 2.0 : 1.0;
@@ -403,12 +485,14 @@ private:
 		} else if (label=="s+s-") {
 			// Si^+ Sj^-
 			resizeStorage(sPlusSminus_,rows,cols,orbitals);
+			VectorStringType brakets;
+			twoPointBrakets(brakets,label,orbitals);
 			MatrixType tSpTotal;
 			SizeType counter = 0;
 			for (SizeType i = 0; i < orbitals; ++i) {
 				for (SizeType j = i; j < orbitals; ++j) {
-					PsimagLite::String str = "<gs|splus?" + ttos(i) + ";sminus?" + ttos(j) + "|gs>";
-					BraketType braket(model_,str);
+					PsimagLite::String str = brakets[counter];
+					BraketType braket(model_,str,&exprCache_);
 					manyPoint(&sPlusSminus_[counter],braket,rows,cols);
 					MatrixType tSpThis = sPlusSminus_[counter];
 					RealType factor = (i != j) ? 2.0 : 1.0;
@@ -451,12 +535,14 @@ private:
 		} else if (label=="s-s+") {
 			// Si^- Sj^+
 			resizeStorage(sMinusSplus_,rows,cols,orbitals);
+			VectorStringType brakets;
+			twoPointBrakets(brakets,label,orbitals);
 			MatrixType tSmTotal;
 			SizeType counter = 0;
 			for (SizeType i = 0; i < orbitals; ++i) {
 				for (SizeType j = i; j < orbitals; ++j) {
-					PsimagLite::String str = "<gs|sminus?" + ttos(i) + ";splus?" + ttos(j) + "|gs>";
-					BraketType braket(model_,str);
+					PsimagLite::String str = brakets[counter];
+					BraketType braket(model_,str,&exprCache_);
 					manyPoint(&sMinusSplus_[counter],braket,rows,cols);
 					MatrixType tSmThis = sMinusSplus_[counter];
 					RealType factor = (i != j) ? 2.0 : 1.0;
@@ -569,7 +655,9 @@ private:
 
 		} else if (label=="dd") {
 
-			BraketType braket(model_,"<gs|d;d'|gs>");
+			VectorStringType brakets;
+			twoPointBrakets(brakets,label,orbitals);
+			BraketType braket(model_,brakets[0],&exprCache_);
 			manyPoint(0,braket,rows,cols);
 
 		} else if (label == "pp") {
@@ -1039,7 +1127,7 @@ private:
 				// c(i3,orb1,1-spin1)
 				str2 += "c[" + ttos(site) + "]?" + ttos(orb4+(1-spin1)*orbitals) + "'|gs>";
 
-				BraketType braket(model_, str + str2);
+				BraketType braket(model_,str + str2,&exprCache_);
 				SizeType val = spin0 + spin1 + 1;
 				int signTerm = (val & 1) ? sign : 1;
 				sum +=  signTerm*observe_.fourpoint()(i1,i2,j1,j2,braket,threadId);
@@ -1276,7 +1364,8 @@ private:
 				storage = new MatrixType(rows,cols);
 			}
 
-			observe_.twoPoint(*storage,braket);
+			if (!takePrepared(*storage,braket))
+				observe_.twoPoint(*storage,braket);
 
 			if (needsPrinting) {
 				std::cout<<(*storage);
@@ -1501,6 +1590,66 @@ private:
 		std::cout<<"\n";
 	}
 
+	// The two-point brakets that measure computes for label, in its order
+	static void twoPointBrakets(VectorStringType& brakets,
+	                            const PsimagLite::String& label,
+	                            SizeType orbitals)
+	{
+		if (label == "cc") {
+			brakets.push_back("<gs|c?0-;c'?0-|gs>");
+			brakets.push_back("<gs|c?1-;c'?1-|gs>");
+			return;
+		}
+
+		if (label == "dd") {
+			brakets.push_back("<gs|d;d'|gs>");
+			return;
+		}
+
+		PsimagLite::String op1;
+		PsimagLite::String op2;
+		if (label == "szsz") {
+			op1 = op2 = "z";
+		} else if (label == "s+s-") {
+			op1 = "splus";
+			op2 = "sminus";
+		} else if (label == "s-s+") {
+			op1 = "sminus";
+			op2 = "splus";
+		} else {
+			return;
+		}
+
+		for (SizeType i = 0; i < orbitals; ++i)
+			for (SizeType j = i; j < orbitals; ++j)
+				brakets.push_back("<gs|" + op1 + "?" + ttos(i) + ";" +
+				                  op2 + "?" + ttos(j) + "|gs>");
+	}
+
+	static bool hasSites(const BraketType& braket)
+	{
+		for (SizeType i = 0; i < braket.points(); ++i) {
+			try {
+				braket.site(i);
+				return true;
+			} catch (std::exception&) {}
+		}
+
+		return false;
+	}
+
+	// Moves into storage the correlations of braket that prepareTwoPoint computed
+	bool takePrepared(MatrixType& storage, const BraketType& braket)
+	{
+		typename MapStringMatrixType::iterator it = prepared_.find(braket.toString());
+		if (it == prepared_.end()) return false;
+		if (it->second.n_row() != storage.n_row() ||
+		        it->second.n_col() != storage.n_col()) return false;
+		storage = it->second;
+		prepared_.erase(it);
+		return true;
+	}
+
 	void printMarker(SizeType threadId) const
 	{
 		if (!hasTimeEvolution_) return;
@@ -1523,6 +1672,8 @@ private:
 	ObserverType observe_;
 	OperatorType matrixNup_,matrixNdown_;
 	VectorMatrixType szsz_,sPlusSminus_,sMinusSplus_;
+	MapStringMatrixType prepared_;
+	mutable OperatorExpressionCacheType exprCache_;
 
 }; // class ObservableLibrary
 
@@ -0,0 +1,535 @@
+#ifndef OBSERVEDATAFILE_H
+#define OBSERVEDATAFILE_H
+#include <fstream>
+#include <deque>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Vector.h"
+#include "ProgramGlobals.h"
+#include "DiskStackBinary.h"
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+/* Indexed binary file with the data that observe needs
+
+   dmrg appends one record per serialized step, a DmrgSerializer saved with
+   DiskStackBinaryOut, and observe reads the records back in order, or seeks
+   to the ones of a given site. Every record is
+   [magic][size][site][direction][size bytes]
+   so that the file of an interrupted run can still be indexed by scanning,
+   and closing the file appends the index
+   [nRecords][(offset, size, site, direction) ...][index offset][magic]
+   Sizes are 64-bit and arrays are in native (little-endian) order.
+
+   In maps the file read-only when it can, so that records are deserialized
+   in place, without copying them, and by several threads at once.
+
+   After Out::startThread(budget), and if compiled with USE_PTHREADS,
+   records are written by a background thread that queues at most budget
+   bytes, so that the sweep waits only when the queue is full.
+*/
+namespace Dmrg {
+
+class ObserveDataFile {
+
+	typedef unsigned long long BinarySizeType;
+
+	enum {MAGIC_RECORD = 0x444d524f, MAGIC_INDEX = 0x444d5249};
+
+	enum {HEADER_SIZE = 4*sizeof(BinarySizeType)};
+
+public:
+
+	typedef DiskStackBinaryOut::VectorCharType VectorCharType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+
+	struct RecordType {
+
+		RecordType()
+		    : offset(0), size(0), site(0), direction(ProgramGlobals::INFINITE)
+		{}
+
+		BinarySizeType offset;
+		BinarySizeType size;
+		SizeType site;
+		ProgramGlobals::DirectionEnum direction;
+	};
+
+	typedef PsimagLite::Vector<RecordType>::Type VectorRecordType;
+
+	class Out {
+
+	public:
+
+		Out(PsimagLite::String filename)
+		    : filename_(filename),
+		      fout_(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc),
+		      offset_(0),
+		      budget_(0),
+		      running_(false),
+		      stop_(false),
+		      pendingBytes_(0)
+		{
+			if (!fout_.is_open())
+				err("ObserveDataFile: cannot open " + filename_ + "\n");
+#ifdef USE_PTHREADS
+			pthread_mutex_init(&mutex_, 0);
+			pthread_cond_init(&cond_, 0);
+#endif
+		}
+
+		~Out()
+		{
+			stopThread();
+#ifdef USE_PTHREADS
+			pthread_cond_destroy(&cond_);
+			pthread_mutex_destroy(&mutex_);
+#endif
+			if (errorMessage_ != "")
+				std::cerr<<"ObserveDataFile background writer: "<<errorMessage_;
+
+			fout_.seekp(offset_);
+			writeSize(fout_, index_.size());
+			for (SizeType i = 0; i < index_.size(); ++i) {
+				writeSize(fout_, index_[i].offset);
+				writeSize(fout_, index_[i].size);
+				writeSize(fout_, index_[i].site);
+				writeSize(fout_, index_[i].direction);
+			}
+
+			writeSize(fout_, offset_);
+			writeSize(fout_, MAGIC_INDEX);
+			if (!fout_.good())
+				std::cerr<<"ObserveDataFile: cannot write index to "<<filename_<<"\n";
+		}
+
+		void startThread(SizeType budget)
+		{
+			if (running_ || budget == 0) return;
+			budget_ = budget;
+#ifdef USE_PTHREADS
+			stop_ = false;
+			int ret = pthread_create(&thread_, 0, threadFunction, this);
+			if (ret != 0)
+				err("ObserveDataFile: pthread_create failed\n");
+			running_ = true;
+#else
+			std::cerr<<"WARNING: ObserveDataFile write queue needs USE_PTHREADS\n";
+#endif
+		}
+
+		// Takes ownership of buffer's contents
+		void write(VectorCharType& buffer,
+		           SizeType site,
+		           ProgramGlobals::DirectionEnum direction)
+		{
+			if (!running_) return writeRecord(buffer, site, direction);
+
+			lock();
+			while (errorMessage_ == "" && pendingBytes_ > 0 &&
+			       pendingBytes_ + buffer.size() > budget_)
+				wait();
+
+			checkError();
+
+			jobs_.push_back(JobType());
+			jobs_.back().buffer.swap(buffer);
+			jobs_.back().site = site;
+			jobs_.back().direction = direction;
+			pendingBytes_ += jobs_.back().buffer.size();
+			broadcast();
+			unlock();
+		}
+
+		const PsimagLite::String& filename() const { return filename_; }
+
+	private:
+
+		struct JobType {
+			VectorCharType buffer;
+			SizeType site;
+			ProgramGlobals::DirectionEnum direction;
+		};
+
+		Out(const Out&);
+
+		Out& operator=(const Out&);
+
+		static void* threadFunction(void* arg)
+		{
+			Out* ptr = static_cast<Out*>(arg);
+			ptr->run();
+			return 0;
+		}
+
+		// the job stays in the queue until written, so that pendingBytes_
+		// counts it; only this thread touches the file while it runs
+		void run()
+		{
+			lock();
+			while (errorMessage_ == "") {
+				if (jobs_.empty()) {
+					if (stop_) break;
+					wait();
+					continue;
+				}
+
+				JobType& job = jobs_.front();
+				unlock();
+				PsimagLite::String msg = tryWriteRecord(job);
+				lock();
+				errorMessage_ = msg;
+				pendingBytes_ -= job.buffer.size();
+				jobs_.pop_front();
+				broadcast();
+			}
+
+			unlock();
+		}
+
+		void stopThread()
+		{
+			if (!running_) return;
+#ifdef USE_PTHREADS
+			lock();
+			stop_ = true;
+			broadcast();
+			unlock();
+			pthread_join(thread_, 0);
+#endif
+			running_ = false;
+		}
+
+		PsimagLite::String tryWriteRecord(const JobType& job)
+		{
+			try {
+				writeRecord(job.buffer, job.site, job.direction);
+			} catch (std::exception& e) {
+				return e.what();
+			}
+
+			return "";
+		}
+
+		// Data is flushed record by record, so that observe can use it
+		// even if this run does not finish
+		void writeRecord(const VectorCharType& buffer,
+		                 SizeType site,
+		                 ProgramGlobals::DirectionEnum direction)
+		{
+			RecordType record;
+			record.offset = offset_ + HEADER_SIZE;
+			record.size = buffer.size();
+			record.site = site;
+			record.direction = direction;
+
+			fout_.seekp(offset_);
+			writeSize(fout_, MAGIC_RECORD);
+			writeSize(fout_, record.size);
+			writeSize(fout_, record.site);
+			writeSize(fout_, record.direction);
+			if (buffer.size() > 0) fout_.write(&(buffer[0]), buffer.size());
+			fout_.flush();
+			if (!fout_.good())
+				err("ObserveDataFile: cannot write to " + filename_ + "\n");
+
+			index_.push_back(record);
+			offset_ = record.offset + record.size;
+		}
+
+		// must be called with the lock held
+		void checkError()
+		{
+			if (errorMessage_ == "") return;
+			PsimagLite::String msg = errorMessage_;
+			unlock();
+			err("ObserveDataFile background writer: " + msg);
+		}
+
+		void lock()
+		{
+#ifdef USE_PTHREADS
+			pthread_mutex_lock(&mutex_);
+#endif
+		}
+
+		void unlock()
+		{
+#ifdef USE_PTHREADS
+			pthread_mutex_unlock(&mutex_);
+#endif
+		}
+
+		void wait()
+		{
+#ifdef USE_PTHREADS
+			pthread_cond_wait(&cond_, &mutex_);
+#endif
+		}
+
+		void broadcast()
+		{
+#ifdef USE_PTHREADS
+			pthread_cond_broadcast(&cond_);
+#endif
+		}
+
+		PsimagLite::String filename_;
+		std::ofstream fout_;
+		BinarySizeType offset_;
+		VectorRecordType index_;
+		SizeType budget_;
+		bool running_;
+		bool stop_;
+		SizeType pendingBytes_;
+		PsimagLite::String errorMessage_;
+		std::deque<JobType> jobs_;
+#ifdef USE_PTHREADS
+		pthread_t thread_;
+		pthread_mutex_t mutex_;
+		pthread_cond_t cond_;
+#endif
+	}; // class Out
+
+	class In {
+
+	public:
+
+		In(PsimagLite::String filename)
+		    : filename_(filename),
+		      fin_(filename.c_str(), std::ios::binary),
+		      cursor_(0),
+		      map_(0),
+		      mapSize_(0)
+		{
+			if (!fin_.is_open())
+				err("ObserveDataFile: cannot open " + filename_ + "\n");
+
+			fin_.seekg(0, std::ios::end);
+			BinarySizeType fileSize = fin_.tellg();
+			if (!loadIndex(fileSize)) scan(fileSize);
+			mapFile(fileSize);
+		}
+
+		~In()
+		{
+			if (map_) munmap(map_, mapSize_);
+		}
+
+		SizeType size() const { return index_.size(); }
+
+		const RecordType& record(SizeType i) const
+		{
+			assert(i < index_.size());
+			return index_[i];
+		}
+
+		void read(VectorCharType& buffer, SizeType i)
+		{
+			const RecordType& r = record(i);
+			buffer.resize(r.size);
+			fin_.clear();
+			fin_.seekg(r.offset);
+			if (buffer.size() > 0) fin_.read(&(buffer[0]), buffer.size());
+			if (!fin_.good())
+				err("ObserveDataFile: cannot read record from " + filename_ + "\n");
+		}
+
+		// the bytes of record i in the mapped file, or 0 if it is not mapped
+		const char* data(SizeType i) const
+		{
+			if (!map_) return 0;
+			return static_cast<const char*>(map_) + record(i).offset;
+		}
+
+		// indices of the records of this site, in the order they were written
+		VectorSizeType findSite(SizeType site) const
+		{
+			VectorSizeType v;
+			for (SizeType i = 0; i < index_.size(); ++i)
+				if (index_[i].site == site) v.push_back(i);
+			return v;
+		}
+
+		bool endOfData() const { return (cursor_ >= index_.size()); }
+
+		SizeType cursor() const { return cursor_; }
+
+		void next(VectorCharType& buffer)
+		{
+			if (endOfData())
+				err("ObserveDataFile: no more records in " + filename_ + "\n");
+			read(buffer, cursor_++);
+		}
+
+		void skip()
+		{
+			if (endOfData())
+				err("ObserveDataFile: no more records in " + filename_ + "\n");
+			cursor_++;
+		}
+
+		const PsimagLite::String& filename() const { return filename_; }
+
+	private:
+
+		In(const In&);
+
+		In& operator=(const In&);
+
+		bool loadIndex(BinarySizeType fileSize)
+		{
+			if (fileSize < 2*sizeof(BinarySizeType)) return false;
+			fin_.seekg(fileSize - 2*sizeof(BinarySizeType));
+			BinarySizeType indexOffset = readSize(fin_);
+			if (readSize(fin_) != MAGIC_INDEX || indexOffset >= fileSize)
+				return false;
+
+			fin_.seekg(indexOffset);
+			SizeType n = readSize(fin_);
+			index_.resize(n);
+			for (SizeType i = 0; i < n; ++i) {
+				index_[i].offset = readSize(fin_);
+				index_[i].size = readSize(fin_);
+				index_[i].site = readSize(fin_);
+				index_[i].direction = direction(readSize(fin_));
+			}
+
+			if (!fin_.good())
+				err("ObserveDataFile: cannot read index from " + filename_ + "\n");
+			return true;
+		}
+
+		// for files without index; stops at the first incomplete record
+		void scan(BinarySizeType fileSize)
+		{
+			BinarySizeType offset = 0;
+			while (offset + HEADER_SIZE <= fileSize) {
+				fin_.seekg(offset);
+				if (readSize(fin_) != MAGIC_RECORD) break;
+				RecordType r;
+				r.offset = offset + HEADER_SIZE;
+				r.size = readSize(fin_);
+				r.site = readSize(fin_);
+				r.direction = direction(readSize(fin_));
+				if (!fin_.good() || r.offset + r.size > fileSize) break;
+				index_.push_back(r);
+				offset = r.offset + r.size;
+			}
+
+			fin_.clear();
+			std::cerr<<"ObserveDataFile: "<<filename_<<" has no index, ";
+			std::cerr<<index_.size()<<" complete records found\n";
+		}
+
+		void mapFile(BinarySizeType fileSize)
+		{
+			if (fileSize == 0) return;
+			int fd = open(filename_.c_str(), O_RDONLY);
+			if (fd < 0) return;
+			void* p = mmap(0, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (p == MAP_FAILED) {
+				std::cerr<<"ObserveDataFile: cannot map "<<filename_<<", reading it instead\n";
+				return;
+			}
+
+			map_ = p;
+			mapSize_ = fileSize;
+		}
+
+		static ProgramGlobals::DirectionEnum direction(BinarySizeType x)
+		{
+			if (x == ProgramGlobals::EXPAND_SYSTEM) return ProgramGlobals::EXPAND_SYSTEM;
+			if (x == ProgramGlobals::EXPAND_ENVIRON) return ProgramGlobals::EXPAND_ENVIRON;
+			return ProgramGlobals::INFINITE;
+		}
+
+		PsimagLite::String filename_;
+		std::ifstream fin_;
+		VectorRecordType index_;
+		SizeType cursor_;
+		void* map_;
+		SizeType mapSize_;
+	}; // class In
+
+	friend class Out;
+
+	friend class In;
+
+	// true if filename exists and is not older than the text data file
+	// textFile, which a new run may have rewritten since it was converted
+	static bool isUpToDate(PsimagLite::String filename, PsimagLite::String textFile)
+	{
+		struct stat binaryStat;
+		if (stat(filename.c_str(), &binaryStat) != 0) return false;
+
+		struct stat textStat;
+		if (stat(textFile.c_str(), &textStat) != 0) return true;
+
+		return (binaryStat.st_mtime >= textStat.st_mtime);
+	}
+
+	// Converts the serializers of a text data file, as written before this
+	// file existed; returns the number of records written
+	template<typename DmrgSerializerType, typename IoInputType>
+	static SizeType convert(IoInputType& io,
+	                        Out& out,
+	                        SizeType numberOfSites)
+	{
+		SizeType saveOption = DmrgSerializerType::BasisType::SAVE_PARTIAL;
+		SizeType counter = 0;
+		while (hasRecord(io)) {
+			DmrgSerializerType* ds = new DmrgSerializerType(io, false, true);
+			DiskStackBinaryOut ioOut;
+			ds->save(ioOut, saveOption, numberOfSites);
+			VectorCharType buffer;
+			ioOut.swap(buffer);
+			out.write(buffer, ds->site(), ds->direction());
+			delete ds;
+			counter++;
+		}
+
+		return counter;
+	}
+
+private:
+
+	// true if another serializer follows in io, which is then left at its
+	// start; records are only parsed after this, so that a malformed one
+	// throws instead of looking like the end of the file
+	template<typename IoInputType>
+	static bool hasRecord(IoInputType& io)
+	{
+		PsimagLite::String label = "#FERMIONICSIGN";
+		PsimagLite::String temp;
+		while (!io.eof()) {
+			temp = "";
+			io>>temp;
+			if (temp.substr(0, label.size()) != label) continue;
+			io.move(-static_cast<int>(temp.size()));
+			return true;
+		}
+
+		return false;
+	}
+
+	static void writeSize(std::ofstream& fout, BinarySizeType x)
+	{
+		fout.write(reinterpret_cast<const char*>(&x), sizeof(x));
+	}
+
+	static BinarySizeType readSize(std::ifstream& fin)
+	{
+		BinarySizeType x = 0;
+		fin.read(reinterpret_cast<char*>(&x), sizeof(x));
+		return x;
+	}
+}; // class ObserveDataFile
+
+} // namespace Dmrg
+
+#endif // OBSERVEDATAFILE_H
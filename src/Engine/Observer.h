@@ -131,19 +131,32 @@ public:
 	typedef ModelType_ ModelType;
 	typedef VectorWithOffsetType_ VectorWithOffsetType;
 	typedef Parallel4PointDs<ModelType,FourPointCorrelationsType> Parallel4PointDsType;
+	typedef typename TwoPointCorrelationsType::VectorSparseMatrixType VectorSparseMatrixType;
+	typedef typename TwoPointCorrelationsType::VectorIntType VectorIntType;
 
 	Observer(IoInputType& io,
 	         SizeType nf,
 	         SizeType trail,
 	         bool hasTimeEvolution,
 	         const ModelType& model,
-	         bool verbose=false)
-	    : helper_(io,nf,trail,model.params().nthreads,hasTimeEvolution,verbose),
+	         bool verbose=false,
+	         ObserveDataFile::In* dataFile = 0)
+	    : helper_(io,
+	              nf,
+	              trail,
+	              model.params().nthreads,
+	              hasTimeEvolution,
+	              verbose,
+	              dataFile,
+	              model.params().observeWindow),
 	      verbose_(verbose),
 	      onepoint_(helper_),
 	      skeleton_(helper_,model,verbose),
-	      twopoint_(helper_,skeleton_),
-	      fourpoint_(helper_,skeleton_)
+	      twopoint_(helper_,
+	                skeleton_,
+	                (model.params().options.find("observeDistributed") !=
+	                 PsimagLite::String::npos)),
+	      fourpoint_(helper_,skeleton_,model.params().fourPointCacheBudget)
 	{}
 
 	SizeType size() const { return helper_.size(); }
@@ -234,6 +247,16 @@ public:
 		twopoint_(m, O1, O2, fermionicSign);
 	}
 
+	// ms[x] gets the correlations of O1s[x] and O2s[x], all in one sweep
+	// over the sites; the ms must have the same size
+	void twoPoint(VectorMatrixType& ms,
+	              const VectorSparseMatrixType& O1s,
+	              const VectorSparseMatrixType& O2s,
+	              const VectorIntType& fermionicSigns)
+	{
+		twopoint_(ms, O1s, O2s, fermionicSigns);
+	}
+
 	void threePoint(const BraketType& braket,
 	                SizeType rows,
 	                SizeType cols)
@@ -371,21 +394,16 @@ public:
 			SizeType site1 = braket.site(1);
 			std::cout<<"#Fixed site0= "<<site0<<"\n";
 			std::cout<<"#Fixed site1= "<<site1<<"\n";
-			typename FourPointCorrelationsType::SparseMatrixType O2gt;
-			fourpoint_.firstStage(O2gt,'N',site0,'N',site1,braket,0,1,threadId);
-
 			for (SizeType site2 = site1+1; site2 < rows; ++site2) {
 				for (SizeType site3 = site2+1; site3 < cols; ++site3) {
-					typename MatrixType::value_type tmp = fourpoint_.secondStage(O2gt,
-					                                                             site1,
-					                                                             'N',
-					                                                             site2,
-					                                                             'N',
-					                                                             site3,
-					                                                             braket,
-					                                                             2,
-					                                                             3,
-					                                                             threadId);
+					typename MatrixType::value_type tmp = fourpoint_.fourPoint(site0,
+					                                                           site1,
+					                                                           'N',
+					                                                           site2,
+					                                                           'N',
+					                                                           site3,
+					                                                           braket,
+					                                                           threadId);
 					std::cout<<site2<<" "<<site3<<" "<<tmp<<"\n";
 				}
 			}
@@ -398,18 +416,14 @@ public:
 			for (SizeType site1 = site0+1; site1 < cols; ++site1) {
 				for (SizeType site2 = site1+1; site2 < rows; ++site2) {
 					for (SizeType site3 = site2+1; site3 < cols; ++site3) {
-						typename FourPointCorrelationsType::SparseMatrixType O2gt;
-						fourpoint_.firstStage(O2gt,'N',site0,'N',site1,braket,0,1,threadId);
-						typename MatrixType::value_type tmp = fourpoint_.secondStage(O2gt,
-						                                                             site1,
-						                                                             'N',
-						                                                             site2,
-						                                                             'N',
-						                                                             site3,
-						                                                             braket,
-						                                                             2,
-						                                                             3,
-						                                                             threadId);
+						typename MatrixType::value_type tmp = fourpoint_.fourPoint(site0,
+						                                                           site1,
+						                                                           'N',
+						                                                           site2,
+						                                                           'N',
+						                                                           site3,
+						                                                           braket,
+						                                                           threadId);
 						std::cout<<site0<<" "<<site1<<" ";
 						std::cout<<site2<<" "<<site3<<" "<<tmp<<"\n";
 					}
@@ -534,7 +548,7 @@ public:
 	                  SizeType rows,
 	                  SizeType cols)
 	{
-		SizeType nthreads = 1;
+		SizeType nthreads = PsimagLite::Concurrency::npthreads;
 		MultiPointCorrelationsType multi(nthreads,helper_,skeleton_);
 		multi(result,O,rows,cols);
 	}
@@ -75,6 +75,11 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
  *
  *  A class to read and serve precomputed data to the observer
  *
+ *  With a binary data file and a window > 0 only the positions of the
+ *  records are read at construction; serializers are loaded when first
+ *  used and at most window of them are kept, dropping the least recently
+ *  used one that is neither the current nor the previous position of a thread.
+ *  Measurements that walk the sites in order read each record once.
  */
 #ifndef PRECOMPUTED_H
 #define PRECOMPUTED_H
@@ -82,8 +87,12 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "ProgramGlobals.h"
 #include "TimeSerializer.h"
 #include "DmrgSerializer.h"
+#include "ObserveDataFile.h"
 #include "VectorWithOffsets.h" // to include norm
 #include "VectorWithOffset.h" // to include norm
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 
 namespace Dmrg {
 template<
@@ -109,6 +118,7 @@ public:
 	typedef typename BasisWithOperatorsType::OperatorType OperatorType;
 	typedef DmrgSerializer<LeftRightSuperType,VectorWithOffsetType> DmrgSerializerType;
 	typedef typename DmrgSerializerType::FermionSignType FermionSignType;
+	typedef typename DmrgSerializerType::TransformWorkspaceType TransformWorkspaceType;
 
 	enum {LEFT_BRAKET=0,RIGHT_BRAKET=1};
 	enum SaveEnum {SAVE_YES, SAVE_NO};
@@ -118,17 +128,41 @@ public:
 	               SizeType trail,
 	               SizeType numberOfPthreads,
 	               bool hasTimeEvolution,
-	               bool verbose)
+	               bool verbose,
+	               ObserveDataFile::In* dataFile = 0,
+	               SizeType window = 0)
 	    :	io_(io),
+	      dataFile_(dataFile),
+	      window_((dataFile) ? window : 0),
 	      dSerializerV_(),//(1,DmrgSerializerType(io_,true)),
 	      timeSerializerV_(),//(nf),
 	      currentPos_(numberOfPthreads),
+	      previousPos_(numberOfPthreads),
+	      workspace_(numberOfPthreads),
 	      verbose_(verbose),
 	      bracket_(2,0),
-	      noMoreData_(false)
+	      noMoreData_(false),
+	      resident_(0),
+	      clock_(0)
 	{
 		PsimagLite::String msg = "No more data to construct this object\n";
 
+		if (window > 0 && !dataFile)
+			std::cerr<<"WARNING: ObserveWindow needs binaryObserveData, ignored\n";
+
+		// each thread pins its current and previous serializers, which are
+		// never evicted, so that with fewer than 2*threads the window
+		// could not be kept
+		if (window_ > 0 && window_ < 2*numberOfPthreads) {
+			window_ = 2*numberOfPthreads;
+			std::cerr<<"WARNING: ObserveWindow raised to "<<window_;
+			std::cerr<<", twice the number of threads\n";
+		}
+
+#ifdef USE_PTHREADS
+		pthread_mutex_init(&mutex_, 0);
+#endif
+
 		if (nf > 0)
 			if (!init(hasTimeEvolution,nf,SAVE_YES))
 				throw PsimagLite::RuntimeError(msg);
@@ -144,6 +178,10 @@ public:
 			DmrgSerializerType* p = dSerializerV_[i];
 			delete p;
 		}
+
+#ifdef USE_PTHREADS
+		pthread_mutex_destroy(&mutex_);
+#endif
 	}
 
 	bool endOfData() const { return noMoreData_; }
@@ -151,7 +189,15 @@ public:
 	void setPointer(SizeType threadId,SizeType pos)
 	{
 		assert(threadId<currentPos_.size());
+		if (window_ == 0) {
+			currentPos_[threadId]=pos;
+			return;
+		}
+
+		lock();
+		previousPos_[threadId] = currentPos_[threadId];
 		currentPos_[threadId]=pos;
+		unlock();
 	}
 
 	SizeType getPointer(SizeType threadId) const
@@ -168,50 +214,43 @@ public:
 
 	void transform(SparseMatrixType& ret,const SparseMatrixType& O2,size_t threadId) const
 	{
-		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->transform(ret,O2);
+		assert(threadId < workspace_.size());
+		return serializer(threadId).transform(ret,O2,workspace_[threadId]);
 	}
 
 	SizeType columns(SizeType threadId) const
 	{
-		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->columns();
+		return serializer(threadId).columns();
 	}
 
 	SizeType rows(SizeType threadId) const
 	{
-		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->rows();
+		return serializer(threadId).rows();
 	}
 
 	const FermionSignType& fermionicSignLeft(SizeType threadId) const
 	{
-		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->fermionicSignLeft();
+		return serializer(threadId).fermionicSignLeft();
 	}
 
 	const FermionSignType& fermionicSignRight(SizeType threadId) const
 	{
-		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->fermionicSignRight();
+		return serializer(threadId).fermionicSignRight();
 	}
 
 	const LeftRightSuperType& leftRightSuper(SizeType threadId) const
 	{
-		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->leftRightSuper();
+		return serializer(threadId).leftRightSuper();
 	}
 
 	ProgramGlobals::DirectionEnum direction(SizeType threadId) const
 	{
-		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->direction();
+		return serializer(threadId).direction();
 	}
 
 	const VectorWithOffsetType& wavefunction(SizeType threadId) const
 	{
-		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->wavefunction();
+		return serializer(threadId).wavefunction();
 	}
 
 	RealType time(SizeType threadId) const
@@ -225,7 +264,7 @@ public:
 	{
 		assert(checkPos(threadId));
 		return  (timeSerializerV_.size()==0) ?
-		            dSerializerV_[currentPos_[threadId]]->site()
+		            serializer(threadId).site()
 		        : timeSerializerV_[currentPos_[threadId]].site();
 		}
 
@@ -291,12 +330,10 @@ private:
 			if (verbose_)
 				std::cerr<<"ObserverHelper "<<dSerializerV_.size()<<"\n";
 			try {
-				DmrgSerializerType* dSerializer = new
-				        DmrgSerializerType(io_,false,true);
-				if (saveOrNot == SAVE_YES)
-					dSerializerV_.push_back(dSerializer);
+				if (dataFile_)
+					loadRecord(saveOrNot);
 				else
-					delete dSerializer;
+					loadText(saveOrNot);
 				if (hasTimeEvolution) {
 					TimeSerializerType ts(io_);
 					if (saveOrNot == SAVE_YES)
@@ -318,6 +355,122 @@ private:
 		return true;
 	}
 
+	void loadText(SaveEnum saveOrNot)
+	{
+		DmrgSerializerType* dSerializer = new DmrgSerializerType(io_,false,true);
+		if (saveOrNot == SAVE_YES)
+			dSerializerV_.push_back(dSerializer);
+		else
+			delete dSerializer;
+	}
+
+	// records not saved are skipped without reading them, and so are
+	// the ones saved with a window until they are used
+	void loadRecord(SaveEnum saveOrNot)
+	{
+		if (saveOrNot == SAVE_NO) return dataFile_->skip();
+
+		SizeType record = dataFile_->cursor();
+		dataFile_->skip();
+		if (window_ > 0) {
+			records_.push_back(record);
+			lastUse_.push_back(0);
+			dSerializerV_.push_back(0);
+			return;
+		}
+
+		dSerializerV_.push_back(deserialize(record));
+	}
+
+	// in place if the data file is mapped
+	DmrgSerializerType* deserialize(SizeType record) const
+	{
+		const char* data = dataFile_->data(record);
+		if (data) {
+			DiskStackBinaryIn io(data, dataFile_->record(record).size);
+			return new DmrgSerializerType(io,false,true);
+		}
+
+		ObserveDataFile::VectorCharType buffer;
+		dataFile_->read(buffer, record);
+		DiskStackBinaryIn io(buffer);
+		return new DmrgSerializerType(io,false,true);
+	}
+
+	const DmrgSerializerType& serializer(SizeType threadId) const
+	{
+		assert(checkPos(threadId));
+		SizeType pos = currentPos_[threadId];
+		if (window_ == 0) return *(dSerializerV_[pos]);
+
+		lock();
+		lastUse_[pos] = ++clock_;
+		if (!dSerializerV_[pos]) {
+			try {
+				load(pos);
+			} catch (...) {
+				unlock();
+				throw;
+			}
+		}
+
+		const DmrgSerializerType& ds = *(dSerializerV_[pos]);
+		unlock();
+		return ds;
+	}
+
+	// must be called with the lock held; pos is pinned but not in memory,
+	// so fewer than 2*threads serializers in memory are pinned, and
+	// the window, at least 2*threads, is never exceeded
+	void load(SizeType pos) const
+	{
+		while (resident_ >= window_ && evictOne()) {}
+
+		dSerializerV_[pos] = deserialize(records_[pos]);
+		++resident_;
+		if (verbose_)
+			std::cerr<<"ObserverHelper: loaded "<<pos<<", "<<resident_<<" in memory\n";
+	}
+
+	// the least recently used serializer that no thread may still be using
+	bool evictOne() const
+	{
+		SizeType victim = dSerializerV_.size();
+		for (SizeType pos = 0; pos < dSerializerV_.size(); ++pos) {
+			if (!dSerializerV_[pos] || isPinned(pos)) continue;
+			if (victim == dSerializerV_.size() || lastUse_[pos] < lastUse_[victim])
+				victim = pos;
+		}
+
+		if (victim == dSerializerV_.size()) return false;
+
+		delete dSerializerV_[victim];
+		dSerializerV_[victim] = 0;
+		--resident_;
+		return true;
+	}
+
+	bool isPinned(SizeType pos) const
+	{
+		for (SizeType i = 0; i < currentPos_.size(); ++i)
+			if (currentPos_[i] == pos || previousPos_[i] == pos) return true;
+		return false;
+	}
+
+	void lock() const
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex_);
+#endif
+	}
+
+	void unlock() const
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&mutex_);
+#endif
+	}
+
 	void integrityChecks()
 	{
 		if (dSerializerV_.size()!=timeSerializerV_.size()) throw PsimagLite::RuntimeError("Error 1\n");
@@ -402,13 +555,28 @@ private:
 		return false;
 	}
 
+	ObserverHelper(const ObserverHelper&);
+
+	ObserverHelper& operator=(const ObserverHelper&);
+
 	IoInputType& io_;
-	typename PsimagLite::Vector<DmrgSerializerType*>::Type dSerializerV_;
+	ObserveDataFile::In* dataFile_;
+	SizeType window_;
+	mutable typename PsimagLite::Vector<DmrgSerializerType*>::Type dSerializerV_;
 	typename PsimagLite::Vector<TimeSerializerType>::Type timeSerializerV_;
 	typename PsimagLite::Vector<SizeType>::Type currentPos_; // it's a vector: one per pthread
+	typename PsimagLite::Vector<SizeType>::Type previousPos_;
+	mutable typename PsimagLite::Vector<TransformWorkspaceType>::Type workspace_;
 	bool verbose_;
 	typename PsimagLite::Vector<SizeType>::Type bracket_;
 	bool noMoreData_;
+	typename PsimagLite::Vector<SizeType>::Type records_;
+	mutable typename PsimagLite::Vector<SizeType>::Type lastUse_;
+	mutable SizeType resident_;
+	mutable SizeType clock_;
+#ifdef USE_PTHREADS
+	mutable pthread_mutex_t mutex_;
+#endif
 };  //ObserverHelper
 } // namespace Dmrg
 
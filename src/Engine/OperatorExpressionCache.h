@@ -0,0 +1,140 @@
+#ifndef OPERATOREXPRESSIONCACHE_H
+#define OPERATOREXPRESSIONCACHE_H
+#include "Vector.h"
+#include "OperatorSpec.h"
+#include "CanonicalExpression.h"
+#include <map>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+/* Operators of braket expressions, built once per expression
+
+   An expression such as c[3]?0'*c[3]?1 is parsed and its operator,
+   products included, built the first time it is asked for; later requests
+   for it copy the operator built. The site of the expression is that given
+   by its first [site], as OperatorSpec finds it. Unless the model is
+   site dependent, the operator does not depend on the site, and
+   expressions that differ only in their sites share one entry, except
+   for those with operators read from input, whose labels may contain the
+   site. Safe to call from several threads.
+*/
+namespace Dmrg {
+
+template<typename ModelType>
+class OperatorExpressionCache {
+
+	typedef typename ModelType::OperatorType OperatorType;
+	typedef OperatorSpec<ModelType> OperatorSpecType;
+	typedef std::pair<OperatorType, int> PairOperatorIntType;
+	typedef std::map<PsimagLite::String, PairOperatorIntType> MapType;
+
+public:
+
+	OperatorExpressionCache(const ModelType& model)
+	    : model_(model),
+	      siteDependent_(model.params().model == "Immm")
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_init(&mutex_, 0);
+#endif
+	}
+
+	~OperatorExpressionCache()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_destroy(&mutex_);
+#endif
+	}
+
+	// As CanonicalExpression: site, if negative, is set to that of expr;
+	// only expressions asked for with a negative site are cached
+	OperatorType operator()(const PsimagLite::String& expr, int& site)
+	{
+		if (site >= 0) return build(expr,site);
+
+		bool shared = (!siteDependent_ && expr.find(':') == PsimagLite::String::npos);
+		PsimagLite::String key = (shared) ? withoutSites(expr) : expr;
+
+		lock();
+		typename MapType::const_iterator it = entries_.find(key);
+		if (it != entries_.end()) {
+			OperatorType op = it->second.first;
+			site = (shared) ? firstSite(expr) : it->second.second;
+			unlock();
+			return op;
+		}
+
+		unlock();
+
+		OperatorType op = build(expr,site);
+
+		lock();
+		entries_[key] = PairOperatorIntType(op,site);
+		unlock();
+
+		return op;
+	}
+
+private:
+
+	OperatorExpressionCache(const OperatorExpressionCache&);
+
+	OperatorExpressionCache& operator=(const OperatorExpressionCache&);
+
+	OperatorType build(const PsimagLite::String& expr, int& site) const
+	{
+		OperatorSpecType opSpec(model_);
+		PsimagLite::CanonicalExpression<OperatorSpecType> canonicalExpression(opSpec);
+		return canonicalExpression(expr,site);
+	}
+
+	// expr without the [site] of its operators
+	static PsimagLite::String withoutSites(const PsimagLite::String& expr)
+	{
+		PsimagLite::String ret("");
+		bool inSite = false;
+		for (SizeType i = 0; i < expr.length(); ++i) {
+			if (expr[i] == '[') inSite = true;
+			if (!inSite) ret += expr[i];
+			if (expr[i] == ']') inSite = false;
+		}
+
+		return ret;
+	}
+
+	// the first [site] of expr, or -1 if there is none
+	static int firstSite(const PsimagLite::String& expr)
+	{
+		size_t first = expr.find('[');
+		if (first == PsimagLite::String::npos) return -1;
+		size_t last = expr.find(']', first);
+		if (last == PsimagLite::String::npos) return -1;
+		return atoi(expr.substr(first + 1, last - first - 1).c_str());
+	}
+
+	void lock()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex_);
+#endif
+	}
+
+	void unlock()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&mutex_);
+#endif
+	}
+
+	const ModelType& model_;
+	bool siteDependent_;
+	MapType entries_;
+#ifdef USE_PTHREADS
+	pthread_mutex_t mutex_;
+#endif
+}; // class OperatorExpressionCache
+
+} // namespace Dmrg
+
+#endif // OPERATOREXPRESSIONCACHE_H
@@ -80,6 +80,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #define OPERATORS_H
 
 #include "ReducedOperators.h"
+#include "BlockSparseOperator.h"
 #include <cassert>
 #include "ProgressIndicator.h"
 #include "Complex.h"
@@ -125,6 +126,8 @@ public:
 	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
 	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
 	typedef std::pair<SizeType,SizeType> PairSizeSizeType;
+	typedef typename PsimagLite::Vector<bool>::Type VectorBoolType;
+	typedef BlockSparseOperator<ComplexOrRealType> BlockSparseOperatorType;
 
 	class MyLoop {
 
@@ -135,14 +138,18 @@ public:
 		       typename PsimagLite::Vector<OperatorType>::Type& operators,
 		       const BlockDiagonalMatrixType& ftransform1,
 		       const BasisType* thisBasis1,
-		       const PairSizeSizeType& startEnd)
+		       const VectorBoolType& keep,
+		       bool blockSparse,
+		       RealType blockSparseThreshold)
 		    : useSu2Symmetry_(useSu2Symmetry),
 		      reducedOpImpl_(reducedOpImpl),
 		      operators_(operators),
 		      ftransform(ftransform1),
 		      thisBasis(thisBasis1),
 		      hasMpi_(ConcurrencyType::hasMpi()),
-		      startEnd_(startEnd)
+		      keep_(keep),
+		      blockSparse_(blockSparse),
+		      blockSparseThreshold_(blockSparseThreshold)
 		{
 			reducedOpImpl_.prepareTransform(ftransform,thisBasis);
 		}
@@ -155,10 +162,14 @@ public:
 				return;
 			}
 
-			if (!useSu2Symmetry_)
-				reducedOpImpl_.changeBasis(operators_[k].data);
-			else
+			if (useSu2Symmetry_)
 				reducedOpImpl_.changeBasis(k);
+			else if (blockSparse_)
+				BlockSparseOperatorType::changeBasis(operators_[k].data,
+				                                     ftransform,
+				                                     blockSparseThreshold_);
+			else
+				reducedOpImpl_.changeBasis(operators_[k].data);
 		}
 
 		SizeType tasks() const
@@ -180,17 +191,16 @@ public:
 			}
 		}
 
-	private:
-
 		bool isExcluded(SizeType k) const
 		{
 #ifdef OPERATORS_CHANGE_ALL
 			return false; // <-- this is the safest answer
 #endif
-			if (k < startEnd_.first || k >= startEnd_.second) return true;
-			return false;
+			return (k < keep_.size() && !keep_[k]);
 		}
 
+	private:
+
 		void gatherOperators()
 		{
 			if (!hasMpi_) return;
@@ -210,9 +220,224 @@ public:
 		const BlockDiagonalMatrixType& ftransform;
 		const BasisType* thisBasis;
 		bool hasMpi_;
-		const PairSizeSizeType& startEnd_;
+		const VectorBoolType& keep_;
+		bool blockSparse_;
+		RealType blockSparseThreshold_;
 	};
 
+	// Expands operator k of ops2 (or of ops3, if k is past the operators of
+	// ops2), or the Hamiltonian for the last task, into the product
+	// basis thisBasis, writing rows and columns directly in its order;
+	// operators are expanded by symmetry blocks if blockSparse.
+	// With MPI the operators are distributed and then gathered, and the
+	// Hamiltonian is not a task: every rank builds it with hamiltonian()
+	class ParallelExternalProduct {
+
+		typedef typename PsimagLite::Vector<ComplexOrRealType>::Type VectorType;
+
+	public:
+
+		ParallelExternalProduct(typename PsimagLite::Vector<OperatorType>::Type& operators,
+		                        SparseMatrixType& hamiltonian,
+		                        const Operators& ops2,
+		                        const Operators& ops3,
+		                        const BasisType& basis2,
+		                        const BasisType& basis3,
+		                        const BasisType& thisBasis,
+		                        bool blockSparse,
+		                        RealType blockSparseThreshold)
+		    : operators_(operators),
+		      hamiltonian_(hamiltonian),
+		      ops2_(ops2),
+		      ops3_(ops3),
+		      basis2_(basis2),
+		      basis3_(basis3),
+		      thisBasis_(thisBasis),
+		      blockSparse_(blockSparse),
+		      blockSparseThreshold_(blockSparseThreshold),
+		      cols_(PsimagLite::Concurrency::npthreads),
+		      values_(PsimagLite::Concurrency::npthreads),
+		      signs_(PsimagLite::Concurrency::npthreads),
+		      hasMpi_(ConcurrencyType::hasMpi() &&
+		              !ConcurrencyType::isMpiDisabled("Operators"))
+		{}
+
+		SizeType tasks() const
+		{
+			return (hasMpi_) ? operators_.size() : operators_.size() + 1;
+		}
+
+		void doTask(SizeType k, SizeType threadNum)
+		{
+			if (k == operators_.size())
+				return doHamiltonian(threadNum);
+
+			SizeType n2 = ops2_.operators_.size();
+			bool option = (k < n2);
+			if ((option) ? ops2_.isRemoved(k) : ops3_.isRemoved(k - n2)) {
+				operators_[k].data.clear();
+				return;
+			}
+
+			const OperatorType& m = (option) ? ops2_.operators_[k] : ops3_.operators_[k - n2];
+			if (blockSparse_)
+				externalProductBlocked(operators_[k].data,
+				                       m.data,
+				                       option,
+				                       m.fermionSign,
+				                       threadNum);
+			else
+				externalProduct(operators_[k].data, m.data, option, m.fermionSign);
+			// don't forget to set fermion sign and j:
+			operators_[k].fermionSign = m.fermionSign;
+			operators_[k].jm = m.jm;
+			operators_[k].angularFactor = m.angularFactor;
+		}
+
+		// Builds the Hamiltonian here if it was not a task, and
+		// makes all operators available to all ranks
+		void gather()
+		{
+			if (!hasMpi_) return;
+
+			doHamiltonian(0);
+			PsimagLite::MPI::pointByPointGather(operators_);
+			for (SizeType i = 0; i < operators_.size(); i++)
+				Dmrg::bcast(operators_[i]);
+		}
+
+	private:
+
+		// option == true is A otimes 1, else 1 otimes A with signs of basis2
+		void externalProduct(SparseMatrixType& c,
+		                     const SparseMatrixType& a,
+		                     bool option,
+		                     int fermionSign) const
+		{
+			if (a.rows() == 0) {
+				c.clear();
+				return;
+			}
+
+			SizeType ns = basis2_.size();
+			SizeType n = thisBasis_.size();
+			c.resize(n, n);
+			SizeType counter = 0;
+			for (SizeType p = 0; p < n; ++p) {
+				c.setRow(p, counter);
+				SizeType k = thisBasis_.permutation(p);
+				SizeType i = k % ns;
+				SizeType j = k/ns;
+				if (option) {
+					for (int kk = a.getRowPtr(i); kk < a.getRowPtr(i + 1); ++kk) {
+						c.pushCol(thisBasis_.permutationInverse(a.getCol(kk) + j*ns));
+						c.pushValue(a.getValue(kk));
+						++counter;
+					}
+
+					continue;
+				}
+
+				RealType sign = basis2_.fermionicSign(i, fermionSign);
+				for (int kk = a.getRowPtr(j); kk < a.getRowPtr(j + 1); ++kk) {
+					c.pushCol(thisBasis_.permutationInverse(i + a.getCol(kk)*ns));
+					c.pushValue(a.getValue(kk)*sign);
+					++counter;
+				}
+			}
+
+			c.setRow(n, counter);
+			c.checkValidity();
+		}
+
+		// Same as externalProduct, but with BlockSparseOperator
+		void externalProductBlocked(SparseMatrixType& c,
+		                            const SparseMatrixType& a,
+		                            bool option,
+		                            int fermionSign,
+		                            SizeType threadNum)
+		{
+			VectorRealType& signs = signs_[threadNum];
+			if (!option) {
+				signs.resize(basis2_.size());
+				for (SizeType i = 0; i < signs.size(); ++i)
+					signs[i] = basis2_.fermionicSign(i, fermionSign);
+			}
+
+			VectorSizeType partition;
+			BlockSparseOperatorType::partitionFromBasis(partition,
+			                                            (option) ? basis2_ : basis3_);
+			BlockSparseOperatorType blockA(a, partition, partition, blockSparseThreshold_);
+			BlockSparseOperatorType blockC(blockSparseThreshold_);
+			blockC.externalProduct(blockA, basis2_, basis3_, thisBasis_, signs, option);
+			blockC.toSparse(c);
+		}
+
+		// H2 otimes 1 + 1 otimes H3, adding up the diagonal of both terms
+		void doHamiltonian(SizeType threadNum)
+		{
+			const SparseMatrixType& h2 = ops2_.hamiltonian_;
+			const SparseMatrixType& h3 = ops3_.hamiltonian_;
+			VectorSizeType& cols = cols_[threadNum];
+			VectorType& values = values_[threadNum];
+			SizeType ns = basis2_.size();
+			SizeType n = thisBasis_.size();
+			assert(h2.rows() == ns && h2.rows()*h3.rows() == n);
+			hamiltonian_.resize(n, n);
+			SizeType counter = 0;
+			for (SizeType p = 0; p < n; ++p) {
+				hamiltonian_.setRow(p, counter);
+				SizeType k = thisBasis_.permutation(p);
+				SizeType i = k % ns;
+				SizeType j = k/ns;
+				cols.clear();
+				values.clear();
+				int diagonal = -1;
+				for (int kk = h2.getRowPtr(i); kk < h2.getRowPtr(i + 1); ++kk) {
+					SizeType col = h2.getCol(kk);
+					if (col == i) diagonal = cols.size();
+					cols.push_back(thisBasis_.permutationInverse(col + j*ns));
+					values.push_back(h2.getValue(kk));
+				}
+
+				for (int kk = h3.getRowPtr(j); kk < h3.getRowPtr(j + 1); ++kk) {
+					SizeType col = h3.getCol(kk);
+					if (col == j && diagonal >= 0) {
+						values[diagonal] += h3.getValue(kk);
+						continue;
+					}
+
+					cols.push_back(thisBasis_.permutationInverse(i + col*ns));
+					values.push_back(h3.getValue(kk));
+				}
+
+				for (SizeType x = 0; x < cols.size(); ++x) {
+					hamiltonian_.pushCol(cols[x]);
+					hamiltonian_.pushValue(values[x]);
+				}
+
+				counter += cols.size();
+			}
+
+			hamiltonian_.setRow(n, counter);
+			hamiltonian_.checkValidity();
+		}
+
+		typename PsimagLite::Vector<OperatorType>::Type& operators_;
+		SparseMatrixType& hamiltonian_;
+		const Operators& ops2_;
+		const Operators& ops3_;
+		const BasisType& basis2_;
+		const BasisType& basis3_;
+		const BasisType& thisBasis_;
+		bool blockSparse_;
+		RealType blockSparseThreshold_;
+		typename PsimagLite::Vector<VectorSizeType>::Type cols_;
+		typename PsimagLite::Vector<VectorType>::Type values_;
+		typename PsimagLite::Vector<VectorRealType>::Type signs_;
+		bool hasMpi_;
+	}; // class ParallelExternalProduct
+
 	Operators(const BasisType* thisBasis)
 	    : useSu2Symmetry_(BasisType::useSu2Symmetry()),
 	      reducedOpImpl_(thisBasis),
@@ -234,7 +459,10 @@ public:
 
 		announceChangeAll();
 
-		if (!useSu2Symmetry_) io.read(operators_,"#OPERATORS");
+		if (!useSu2Symmetry_) {
+			io.read(operators_,"#OPERATORS");
+			readRemoved(io);
+		}
 
 		io.readMatrix(hamiltonian_,"#HAMILTONIAN");
 		reducedOpImpl_.setHamiltonian(hamiltonian_);
@@ -245,9 +473,12 @@ public:
 	          typename PsimagLite::EnableIf<
 	          PsimagLite::IsInputLike<IoInputter>::True, int>::Type = 0)
 	{
-		if (!useSu2Symmetry_)
+		if (!useSu2Symmetry_) {
 			io.read(operators_,"#OPERATORS");
-		else reducedOpImpl_.load(io);
+			readRemoved(io);
+		} else {
+			reducedOpImpl_.load(io);
+		}
 
 		io.readMatrix(hamiltonian_,"#HAMILTONIAN");
 		reducedOpImpl_.setHamiltonian(hamiltonian_);
@@ -255,8 +486,12 @@ public:
 
 	void setOperators(const typename PsimagLite::Vector<OperatorType>::Type& ops)
 	{
-		if (!useSu2Symmetry_) operators_=ops;
-		else reducedOpImpl_.setOperators(ops);
+		if (!useSu2Symmetry_) {
+			operators_=ops;
+			removed_.assign(ops.size(), false);
+		} else {
+			reducedOpImpl_.setOperators(ops);
+		}
 	}
 
 	const OperatorType& getReducedOperatorByIndex(char modifier,const PairType& p) const
@@ -269,9 +504,32 @@ public:
 	{
 		assert(!useSu2Symmetry_);
 		assert(i>=0 && SizeType(i)<operators_.size());
+		if (isRemoved(i)) {
+			PsimagLite::String msg("Operators::getOperatorByIndex(): operator ");
+			msg += ttos(i) + " was removed, because no site out of this block ";
+			msg += "connects to it (or it is not among the most recent ones)\n";
+			throw PsimagLite::RuntimeError(msg);
+		}
+
 		return operators_[i];
 	}
 
+	// True if operator i was dropped on a change of basis, or comes
+	// from a dropped operator; its data is then a 0x0 matrix
+	bool isRemoved(SizeType i) const
+	{
+		assert(i < removed_.size() || useSu2Symmetry_);
+		if (useSu2Symmetry_) return false;
+		return removed_[i];
+	}
+
+	void remove(SizeType i)
+	{
+		assert(i < operators_.size() && i < removed_.size());
+		operators_[i].data.clear();
+		removed_[i] = true;
+	}
+
 	const OperatorType& getReducedOperatorByIndex(int i) const
 	{
 		assert(useSu2Symmetry_);
@@ -284,21 +542,40 @@ public:
 		return operators_.size();
 	}
 
+	template<typename SomeParametersType>
 	void changeBasis(const BlockDiagonalMatrixType& ftransform,
 	                 const BasisType* thisBasis,
-	                 const PairSizeSizeType& startEnd)
+	                 const VectorBoolType& keep,
+	                 const SomeParametersType& params)
 	{
 		typedef PsimagLite::Parallelizer<MyLoop> ParallelizerType;
 		ParallelizerType threadObject(PsimagLite::Concurrency::npthreads,
 		                              PsimagLite::MPI::COMM_WORLD);
 
-		MyLoop helper(useSu2Symmetry_,reducedOpImpl_,operators_,ftransform,thisBasis,startEnd);
+		bool blockSparse = (useBlockSparse(params) && !useSu2Symmetry_);
+		MyLoop helper(useSu2Symmetry_,
+		              reducedOpImpl_,
+		              operators_,
+		              ftransform,
+		              thisBasis,
+		              keep,
+		              blockSparse,
+		              params.denseSparseThreshold);
 
 		threadObject.loopCreate(helper); // FIXME: needs weights
 
 		helper.gather();
 
-		reducedOpImpl_.changeBasisHamiltonian(hamiltonian_,ftransform);
+		if (!useSu2Symmetry_)
+			for (SizeType k = 0; k < operators_.size(); ++k)
+				if (helper.isExcluded(k)) removed_[k] = true;
+
+		if (blockSparse)
+			BlockSparseOperatorType::changeBasis(hamiltonian_,
+			                                     ftransform,
+			                                     params.denseSparseThreshold);
+		else
+			reducedOpImpl_.changeBasisHamiltonian(hamiltonian_,ftransform);
 	}
 
 	void reorder(const   VectorSizeType& permutation)
@@ -321,7 +598,11 @@ public:
 	                  SizeType x,
 	                  const BasisType* thisBasis)
 	{
-		if (!useSu2Symmetry_) operators_.resize(x);
+		if (!useSu2Symmetry_) {
+			operators_.resize(x);
+			removed_.assign(x, false);
+		}
+
 		reducedOpImpl_.setToProduct(basis2,basis3,x,thisBasis);
 	}
 
@@ -366,6 +647,49 @@ public:
 		apply(operators_[i].data);
 	}
 
+	// Sets all operators and the Hamiltonian to the outer product of
+	// those of ops2 and ops3 (see PSIDOC OperatorsExternalProduct), in one
+	// pass and already in the order of thisBasis, so that no reorder is
+	// needed afterwards. Each operator is one task, and the Hamiltonian is
+	// one more, done serially by a single thread, so no more than
+	// operators_.size() + 1 threads have work, and the Hamiltonian bounds
+	// the time taken when there are few operators.
+	// Factors are trivial without SU(2), so nothing is applied
+	template<typename SomeParametersType>
+	void externalProductPermuted(const Operators& ops2,
+	                             const Operators& ops3,
+	                             const BasisType& basis2,
+	                             const BasisType& basis3,
+	                             const BasisType& thisBasis,
+	                             const SomeParametersType& params)
+	{
+		assert(!useSu2Symmetry_);
+		assert(operators_.size() == ops2.operators_.size() + ops3.operators_.size());
+
+		SizeType threads = std::min(operators_.size() + 1,
+		                            PsimagLite::Concurrency::npthreads);
+		typedef PsimagLite::Parallelizer<ParallelExternalProduct> ParallelizerType;
+		ParallelizerType threadObject(threads, PsimagLite::MPI::COMM_WORLD);
+
+		ParallelExternalProduct helper(operators_,
+		                               hamiltonian_,
+		                               ops2,
+		                               ops3,
+		                               basis2,
+		                               basis3,
+		                               thisBasis,
+		                               useBlockSparse(params),
+		                               params.denseSparseThreshold);
+
+		threadObject.loopCreate(helper);
+
+		helper.gather();
+
+		SizeType n2 = ops2.operators_.size();
+		for (SizeType k = 0; k < operators_.size(); ++k)
+			removed_[k] = (k < n2) ? ops2.isRemoved(k) : ops3.isRemoved(k - n2);
+	}
+
 	void externalProductReduced(SizeType i,
 	                            const BasisType& basis2,
 	                            const BasisType& basis3,
@@ -432,8 +756,15 @@ public:
 	          typename PsimagLite::EnableIf<
 	          PsimagLite::IsOutputLike<IoOutputter>::True, int>::Type = 0) const
 	{
-		if (!useSu2Symmetry_) io.printVector(operators_,"#OPERATORS");
-		else reducedOpImpl_.save(io,s);
+		if (!useSu2Symmetry_) {
+			io.printVector(operators_,"#OPERATORS");
+			VectorSizeType removed(removed_.size(), 0);
+			for (SizeType i = 0; i < removed.size(); ++i)
+				if (removed_[i]) removed[i] = 1;
+			io.printVector(removed,"#OPERATORS_REMOVED");
+		} else {
+			reducedOpImpl_.save(io,s);
+		}
 		io.printMatrix(hamiltonian_,"#HAMILTONIAN");
 	}
 
@@ -441,16 +772,59 @@ public:
 	void saveEmpty(IoOutputter& io,const PsimagLite::String& s) const
 	{
 		PsimagLite::Vector<SizeType>::Type tmp;
-		if (!useSu2Symmetry_) io.printVector(tmp,"#OPERATORS");
-		else reducedOpImpl_.saveEmpty(io,s);
+		if (!useSu2Symmetry_) {
+			io.printVector(tmp,"#OPERATORS");
+			io.printVector(tmp,"#OPERATORS_REMOVED");
+		} else {
+			reducedOpImpl_.saveEmpty(io,s);
+		}
 		PsimagLite::Matrix<SizeType> tmp2(0,0);
 		io.printMatrix(tmp2,"#HAMILTONIAN");
 	}
 
 	SizeType size() const { return operators_.size(); }
 
+	// blockSparseOperators in SolverOptions=, see BlockSparseOperator;
+	// its blocks are dense above DenseSparseThreshold=
+	template<typename SomeParametersType>
+	static bool useBlockSparse(const SomeParametersType& params)
+	{
+		return (params.options.find("blockSparseOperators") != PsimagLite::String::npos);
+	}
+
 private:
 
+	// Files written before #OPERATORS_REMOVED was added don't have it, and
+	// then no operator is removed. Looking for it with read() would go on
+	// to later records, so the labels are read one by one up to
+	// #HAMILTONIAN, which always follows, and the stream is put back at
+	// the label found
+	template<typename IoInputter>
+	void readRemoved(IoInputter& io)
+	{
+		removed_.assign(operators_.size(), false);
+
+		PsimagLite::String label = "#OPERATORS_REMOVED";
+		PsimagLite::String next = "#HAMILTONIAN";
+		PsimagLite::String temp;
+		while (!io.eof()) {
+			io>>temp;
+			if (temp == label || temp == next) break;
+		}
+
+		if (temp != label && temp != next) return;
+		io.move(-static_cast<int>(temp.size()));
+		if (temp == next) return;
+
+		VectorSizeType removed;
+		io.read(removed,label);
+		if (removed.size() != operators_.size())
+			throw PsimagLite::RuntimeError("Operators: #OPERATORS_REMOVED and "
+			                               "#OPERATORS differ in size\n");
+		for (SizeType i = 0; i < removed.size(); ++i)
+			removed_[i] = (removed[i] != 0);
+	}
+
 	void reorder(SparseMatrixType &v,const   VectorSizeType& permutation)
 	{
 		if (v.rows() == 0 || v.cols() == 0) {
@@ -480,6 +854,7 @@ private:
 	bool useSu2Symmetry_;
 	ReducedOperatorsType reducedOpImpl_;
 	typename PsimagLite::Vector<OperatorType>::Type operators_;
+	VectorBoolType removed_;
 	SparseMatrixType hamiltonian_;
 	PsimagLite::ProgressIndicator progress_;
 }; //class Operators
@@ -88,45 +88,47 @@ class Parallel2PointCorrelations {
 
 	typedef typename TwoPointCorrelationsType::MatrixType MatrixType;
 	typedef typename TwoPointCorrelationsType::SparseMatrixType SparseMatrixType;
+	typedef typename TwoPointCorrelationsType::VectorMatrixType VectorMatrixType;
+	typedef typename TwoPointCorrelationsType::VectorSparseMatrixType VectorSparseMatrixType;
+	typedef typename TwoPointCorrelationsType::VectorIntType VectorIntType;
 	typedef typename MatrixType::value_type FieldType;
 	typedef PsimagLite::Concurrency ConcurrencyType;
 
 public:
 
-	typedef std::pair<SizeType,SizeType> PairType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
 	typedef typename PsimagLite::Real<FieldType>::Type RealType;
 
-	Parallel2PointCorrelations(MatrixType& w,
+	// one task per row, so that the O1s are grown once per row
+	Parallel2PointCorrelations(VectorMatrixType& ws,
 	                           TwoPointCorrelationsType& twopoint,
-	                           const typename PsimagLite::Vector<PairType>::Type& pairs,
-	                           const SparseMatrixType& O1,
-	                           const SparseMatrixType& O2,
-	                           int fermionicSign)
-	    : w_(w),
+	                           const VectorSizeType& rows,
+	                           const VectorSparseMatrixType& O1s,
+	                           const VectorSparseMatrixType& O2s,
+	                           const VectorIntType& fermionicSigns)
+	    : ws_(ws),
 	      twopoint_(twopoint),
-	      pairs_(pairs),
-	      O1_(O1),
-	      O2_(O2),
-	      fermionicSign_(fermionicSign)
+	      rows_(rows),
+	      O1s_(O1s),
+	      O2s_(O2s),
+	      fermionicSigns_(fermionicSigns)
 	{}
 
 	void doTask(SizeType taskNumber ,SizeType threadNum)
 	{
-		SizeType i = pairs_[taskNumber].first;
-		SizeType j = pairs_[taskNumber].second;
-		w_(i,j) = twopoint_.calcCorrelation(i,j,O1_,O2_,fermionicSign_,threadNum);
+		twopoint_.calcRows(ws_,rows_[taskNumber],O1s_,O2s_,fermionicSigns_,threadNum);
 	}
 
-	SizeType tasks() const { return pairs_.size(); }
+	SizeType tasks() const { return rows_.size(); }
 
 private:
 
-	MatrixType& w_;
+	VectorMatrixType& ws_;
 	TwoPointCorrelationsType& twopoint_;
-	const typename PsimagLite::Vector<PairType>::Type& pairs_;
-	const SparseMatrixType& O1_;
-	const SparseMatrixType& O2_;
-	int fermionicSign_;
+	const VectorSizeType& rows_;
+	const VectorSparseMatrixType& O1s_;
+	const VectorSparseMatrixType& O2s_;
+	const VectorIntType& fermionicSigns_;
 }; // class Parallel2PointCorrelations
 } // namespace Dmrg 
 
@@ -79,6 +79,8 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Matrix.h"
 #include "Mpi.h"
 #include "Concurrency.h"
+#include <map>
+#include <algorithm>
 
 namespace Dmrg {
 
@@ -91,6 +93,8 @@ class Parallel4PointDs {
 	typedef typename MatrixType::value_type FieldType;
 	typedef typename FourPointCorrelationsType::SparseMatrixType SparseMatrixType;
 	typedef PsimagLite::Concurrency ConcurrencyType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef typename PsimagLite::Vector<VectorSizeType>::Type VectorVectorSizeType;
 
 public:
 
@@ -110,21 +114,68 @@ public:
 	      gammas_(gammas),
 	      pairs_(pairs),
 	      mode_(mode)
-	{}
+	{
+		groupPairs();
+	}
 
+	// one task per first index, so that the operators grown for
+	// its first two sites are grown further for each pair in turn
 	void doTask(SizeType taskNumber, SizeType threadNum)
 	{
-		SizeType i = pairs_[taskNumber].first;
-		SizeType j = pairs_[taskNumber].second;
+		const VectorSizeType& group = groups_[taskNumber];
+		for (SizeType x = 0; x < group.size(); ++x) {
+			SizeType i = pairs_[group[x]].first;
+			SizeType j = pairs_[group[x]].second;
 
-		fpd_(i,j) = (mode_ == MODE_NORMAL) ? fourPointDelta(2*i,2*j,gammas_,model_,threadNum)
-		                                   : fourPointThin(i,j,gammas_,model_,threadNum);
+			fpd_(i,j) = (mode_ == MODE_NORMAL) ? fourPointDelta(2*i,2*j,gammas_,model_,threadNum)
+			                                   : fourPointThin(i,j,gammas_,model_,threadNum);
+		}
 	}
 
-	SizeType tasks() const { return pairs_.size(); }
+	SizeType tasks() const { return groups_.size(); }
 
 private:
 
+	// groups_ has the pairs of each first index by increasing third site;
+	// long and short groups alternate, so that threads get similar work
+	void groupPairs()
+	{
+		typedef std::pair<SizeType,SizeType> PairSizeType;
+		typedef typename PsimagLite::Vector<PairSizeType>::Type VectorPairSizeType;
+		typedef std::map<SizeType, VectorPairSizeType> MapType;
+
+		MapType byFirst;
+		for (SizeType t = 0; t < pairs_.size(); ++t)
+			byFirst[pairs_[t].first].push_back(PairSizeType(thirdSite(pairs_[t].second), t));
+
+		VectorVectorSizeType groups;
+		typename MapType::iterator it = byFirst.begin();
+		for (; it != byFirst.end(); ++it) {
+			VectorPairSizeType& tasks = it->second;
+			std::stable_sort(tasks.begin(), tasks.end());
+			VectorSizeType group(tasks.size());
+			for (SizeType x = 0; x < tasks.size(); ++x)
+				group[x] = tasks[x].second;
+			groups.push_back(group);
+		}
+
+		SizeType total = groups.size();
+		groups_.resize(total);
+		for (SizeType k = 0; k < total; ++k) {
+			SizeType index = (k & 1) ? total - 1 - k/2 : k/2;
+			groups_[k].swap(groups[index]);
+		}
+	}
+
+	SizeType thirdSite(SizeType j) const
+	{
+		if (mode_ == MODE_NORMAL) return 2*j;
+
+		SizeType number1 = fpd_.n_row()/2;
+		SizeType number2 = sqrt(number1);
+		return (j % number1) % number2;
+	}
+
 	template<typename SomeModelType>
 	FieldType fourPointDelta(SizeType i,
 	                         SizeType j,
@@ -214,6 +265,7 @@ private:
 	const typename PsimagLite::Vector<SizeType>::Type& gammas_;
 	const typename PsimagLite::Vector<PairType>::Type& pairs_;
 	FourPointModeEnum mode_;
+	VectorVectorSizeType groups_;
 }; // class Parallel4PointDs
 } // namespace Dmrg
 
@@ -1,8 +1,8 @@
 /*
-Copyright (c) 2009-2015, UT-Battelle, LLC
+Copyright (c) 2009,-2012 UT-Battelle, LLC
 All rights reserved
 
-[DMRG++, Version 3.0]
+[DMRG++, Version 2.0.0]
 [by G.A., Oak Ridge National Laboratory]
 
 UT Battelle Open Source Software License 11242008
@@ -67,73 +67,65 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 *********************************************************
 
+
 */
 /** \ingroup DMRG */
 /*@{*/
-/** \file ParallelWftMany.h
+/** \file ParallelMultiPointCorrelations.h
 */
 
-#ifndef DMRG_PARALLEL_WFT_MANY_H
-#define DMRG_PARALLEL_WFT_MANY_H
+#ifndef PARALLEL_MULTIPOINT_CORRELATIONS_H
+#define PARALLEL_MULTIPOINT_CORRELATIONS_H
 
 #include "Vector.h"
+#include "Mpi.h"
 #include "Concurrency.h"
 
 namespace Dmrg {
 
-template<typename VectorWithOffsetType,
-         typename WaveFunctionTransfType,
-         typename LeftRightSuperType>
-class ParallelWftMany {
+// Brackets of operators already grown, one task per operator
+template<typename MultiPointCorrelationsType, typename VectorLikeType>
+class ParallelMultiPointCorrelations {
 
-	typedef PsimagLite::Concurrency ConcurrencyType;
-	typedef typename PsimagLite::Vector<VectorWithOffsetType>::Type
-	VectorVectorWithOffsetType;
+	typedef typename MultiPointCorrelationsType::SparseMatrixType SparseMatrixType;
+	typedef typename MultiPointCorrelationsType::VectorSparseMatrixType
+	VectorSparseMatrixType;
 
 public:
 
-	typedef typename VectorWithOffsetType::value_type VectorElementType;
-	typedef typename PsimagLite::Real<VectorElementType>::Type RealType;
-
-	ParallelWftMany(VectorVectorWithOffsetType& targetVectors,
-	            SizeType nk,
-	            const WaveFunctionTransfType& wft,
-	            const LeftRightSuperType& lrs)
-	    : targetVectors_(targetVectors),
-	      nk_(nk),
-	      wft_(wft),
-	      lrs_(lrs)
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+
+	// Og[x], grown at pointers[x], gives result[offset + x]
+	ParallelMultiPointCorrelations(VectorLikeType& result,
+	                               MultiPointCorrelationsType& multi,
+	                               const VectorSparseMatrixType& Og,
+	                               const VectorSizeType& pointers,
+	                               SizeType offset)
+	    : result_(result),
+	      multi_(multi),
+	      Og_(Og),
+	      pointers_(pointers),
+	      offset_(offset)
 	{}
 
-	void thread_function_(SizeType threadNum,
-	                      SizeType blockSize,
-	                      SizeType total,
-	                      ConcurrencyType::MutexType*)
+	void doTask(SizeType taskNumber ,SizeType threadNum)
 	{
-		SizeType nk = nk_;
-		SizeType mpiRank = PsimagLite::MPI::commRank(PsimagLite::MPI::COMM_WORLD);
-		SizeType npthreads = PsimagLite::Concurrency::npthreads;
-
-		ConcurrencyType::mpiDisableIfNeeded(mpiRank,blockSize,"ParallelWftMany",total);
-
-		for (SizeType p=0;p<blockSize;p++) {
-			SizeType ix = (threadNum+npthreads*mpiRank)*blockSize + p + 1;
-			if (ix>=targetVectors_.size()) break;
-			VectorWithOffsetType phiNew = targetVectors_[0];
-			wft_.setInitialVector(phiNew,targetVectors_[ix],lrs_,nk);
-			targetVectors_[ix] = phiNew;
-		}
+		result_[offset_ + taskNumber] = multi_.bracket(Og_[taskNumber],
+		                                               pointers_[taskNumber],
+		                                               threadNum);
 	}
 
+	SizeType tasks() const { return pointers_.size(); }
+
 private:
 
-	VectorVectorWithOffsetType& targetVectors_;
-	SizeType nk_;
-	const WaveFunctionTransfType& wft_;
-	const LeftRightSuperType& lrs_;
-}; // class ParallelWftMany
+	VectorLikeType& result_;
+	MultiPointCorrelationsType& multi_;
+	const VectorSparseMatrixType& Og_;
+	const VectorSizeType& pointers_;
+	SizeType offset_;
+}; // class ParallelMultiPointCorrelations
 } // namespace Dmrg
 
 /*@}*/
-#endif // DMRG_PARALLEL_WFT_MANY_H
-
+#endif // PARALLEL_MULTIPOINT_CORRELATIONS_H
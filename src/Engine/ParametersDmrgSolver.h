@@ -122,6 +122,35 @@ The first movement starts from where the infinite loop left off, at the middle o
  lattice.
 See the below for more information and examples on Finite Loops.
 
+\item[DiskStackPrefetch=integer] Optional. With binaryStacks, the number of
+stack entries that a background thread loads ahead of the sweep. Default 0, no prefetch.
+
+\item[DiskStackWriteBudget=integer] Optional. With binaryStacks, stack entries
+are written by a background thread queueing at most this many megabytes.
+Default 0, entries are written when pushed.
+
+\item[ObserveDataWriteBudget=integer] Optional. With binaryObserveData, the data
+for observe is written by a background thread queueing at most this many megabytes,
+and the sweep waits only when the queue is full. Default 0, data is written
+when serialized.
+
+\item[ObserveWindow=integer] Optional. With binaryObserveData, observe keeps at most
+this many serialized steps in memory, reading them from the binary file when
+first needed and dropping the least recently used ones. Default 0, all steps of
+a chunk are read when the chunk starts. Each thread needs two steps in memory,
+so values below twice the number of threads are raised to it.
+
+\item[FourPointCacheBudget=integer] Optional. Megabytes that observe may use
+to keep the operators grown for three- and four-point correlations, so that
+correlations sharing their first two sites do not grow them again. Default 0,
+no cache; a few hundred megabytes help inputs with many such correlations.
+
+\item[InSituTwoPoint=string] Optional. Comma-separated brakets
+<gs|A[r];B|gs>, each measured during the last finite loop that moves to the
+right as <A_r B_j> for j from r to the last site, without saving data for
+observe. The results go to the file named as the output file with the
+prefix InSitu. Needs SitesPerBlock=1 and no SU(2).
+
 \end{itemize}
 */
 template<typename FieldType,typename InputValidatorType>
@@ -143,6 +172,11 @@ struct ParametersDmrgSolver {
 	SizeType dumperBegin;
 	SizeType dumperEnd;
 	SizeType precision;
+	SizeType diskStackPrefetch;
+	SizeType diskStackWriteBudget;
+	SizeType observeDataWriteBudget;
+	SizeType observeWindow;
+	SizeType fourPointCacheBudget;
 	int useReflectionSymmetry;
 	PairRealSizeType truncationControl;
 	PsimagLite::String filename;
@@ -150,6 +184,7 @@ struct ParametersDmrgSolver {
 	PsimagLite::String options;
 	PsimagLite::String model;
 	PsimagLite::String insitu;
+	PsimagLite::String inSituTwoPoint;
 	PsimagLite::String fileForDensityMatrixEigs;
 	PsimagLite::String recoverySave;
 	RestartStruct checkpoint;
@@ -188,6 +223,11 @@ struct ParametersDmrgSolver {
 	      dumperBegin(0),
 	      dumperEnd(0),
 	      precision(6),
+	      diskStackPrefetch(0),
+	      diskStackWriteBudget(0),
+	      observeDataWriteBudget(0),
+	      observeWindow(0),
+	      fourPointCacheBudget(0),
 	      recoverySave("0"),
 	      degeneracyMax(1e-12),
 	      denseSparseThreshold(0.1)
@@ -260,6 +300,11 @@ struct ParametersDmrgSolver {
 			io.readline(insitu,"insitu=");
 		} catch (std::exception&) {}
 
+		inSituTwoPoint = "";
+		try {
+			io.readline(inSituTwoPoint,"InSituTwoPoint=");
+		} catch (std::exception&) {}
+
 		try {
 			io.readline(sitesPerBlock,"SitesPerBlock=");
 		} catch (std::exception&) {}
@@ -308,6 +353,26 @@ struct ParametersDmrgSolver {
 			io.readline(denseSparseThreshold, "DenseSparseThreshold=");
 		} catch (std::exception&) {}
 
+		try {
+			io.readline(diskStackPrefetch, "DiskStackPrefetch=");
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(diskStackWriteBudget, "DiskStackWriteBudget=");
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(observeDataWriteBudget, "ObserveDataWriteBudget=");
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(observeWindow, "ObserveWindow=");
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(fourPointCacheBudget, "FourPointCacheBudget=");
+		} catch (std::exception&) {}
+
 		if (isObserveCode) return;
 		bool hasRestart = false;
 		if (options.find("restart")!=PsimagLite::String::npos) {
@@ -530,6 +595,20 @@ std::ostream &operator<<(std::ostream &os,
 
 	os<<"parameters.degeneracyMax="<<p.degeneracyMax<<"\n";
 	os<<"parameters.denseSparseThreshold="<<p.denseSparseThreshold<<"\n";
+	if (p.diskStackPrefetch > 0 || p.diskStackWriteBudget > 0) {
+		os<<"parameters.diskStackPrefetch="<<p.diskStackPrefetch<<"\n";
+		os<<"parameters.diskStackWriteBudget="<<p.diskStackWriteBudget<<"\n";
+	}
+
+	if (p.observeDataWriteBudget > 0)
+		os<<"parameters.observeDataWriteBudget="<<p.observeDataWriteBudget<<"\n";
+
+	if (p.observeWindow > 0)
+		os<<"parameters.observeWindow="<<p.observeWindow<<"\n";
+
+	if (p.fourPointCacheBudget > 0)
+		os<<"parameters.fourPointCacheBudget="<<p.fourPointCacheBudget<<"\n";
+
 	os<<"parameters.nthreads="<<p.nthreads<<"\n";
 	os<<"parameters.useReflectionSymmetry="<<p.useReflectionSymmetry<<"\n";
 	os<<p.checkpoint;
@@ -537,6 +616,9 @@ std::ostream &operator<<(std::ostream &os,
 	if (p.fileForDensityMatrixEigs!="")
 		os<<"parameters.fileForDensityMatrixEigs="<<p.fileForDensityMatrixEigs<<"\n";
 
+	if (p.inSituTwoPoint!="")
+		os<<"parameters.inSituTwoPoint="<<p.inSituTwoPoint<<"\n";
+
 	if (p.options.find("MatrixVectorStored")==PsimagLite::String::npos)
 		os<<"MaxMatrixRankStored="<<p.maxMatrixRankStored<<"\n";
 
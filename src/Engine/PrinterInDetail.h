@@ -59,6 +59,11 @@ private:
 		os<<"#Operators at site "<<site<<" ("<<siteC<<")\n";
 		for (SizeType sigma = 0; sigma < end; ++sigma) {
 			typename BasisWithOperatorsType::PairType p = basis.getOperatorIndices(siteC, sigma);
+			if (basis.isOperatorRemoved(p.first)) {
+				os<<sigma<<" removed\n";
+				continue;
+			}
+
 			os<<sigma<<" non-zeroes="<<basis.getOperatorByIndex(p.first).data.nonZero();
 			os<<" rows="<<basis.getOperatorByIndex(p.first).data.rows()<<"\n";
 		}
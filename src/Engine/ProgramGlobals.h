@@ -138,6 +138,9 @@ struct ProgramGlobals {
 	static PsimagLite::String WFT_STRING;
 	static PsimagLite::String SYSTEM_STACK_STRING;
 	static PsimagLite::String ENVIRON_STACK_STRING;
+	static PsimagLite::String OBSERVE_DATA_STRING;
+	static PsimagLite::String IN_SITU_STRING;
+	static PsimagLite::String STRUCTURE_FACTOR_STRING;
 }; // ProgramGlobals
 
 } // namespace Dmrg
@@ -83,6 +83,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Vector.h"
 #include "ProgramGlobals.h"
 #include "ProgressIndicator.h"
+#include <cstdio>
 
 namespace Dmrg {
 
@@ -116,6 +117,8 @@ public:
 
 	~Recovery()
 	{
+		checkpoint_.flushRecovery();
+
 		if (checkpoint_.parameters().options.find("recoveryNoDelete") !=
 		        PsimagLite::String::npos) return;
 
@@ -134,24 +137,54 @@ public:
 		PsimagLite::String prefix("Recovery");
 		prefix += (flag_m_) ? "1" : "0";
 		PsimagLite::String rootName(prefix + checkpoint_.parameters().filename);
-		typename IoType::Out ioOut(rootName);
-		ioOut<<checkpoint_.parameters();
-		checkpoint_.save(pS_,pE_,ioOut);
-		psi.save(vsites,ioOut);
-		PsimagLite::OstringStream msg;
-		msg<<"#LastLoopSign="<<lastSign<<"\n";
-		ioOut<<msg.str();
-		files_.push_back(rootName);
 
-		saveStacksForRecovery(rootName,isObserveCode);
+		// the Recovery file is written last, so that it never names stacks
+		// or index files that are not yet on disk; until then, the previous
+		// Recovery file with the other prefix is the one to restart from
+		unlink(rootName.c_str());
 
-		wft_.save(rootName);
+		if (checkpoint_.hasRecoveryJournal())
+			saveStacksIndex(rootName);
+		else
+			saveStacksForRecovery(rootName,isObserveCode);
+
+		wft_.saveForRecovery(rootName);
 		wft_.appendFileList(files_,rootName);
+		checkpoint_.flushRecovery();
+
+		PsimagLite::String tmpName = rootName + ".tmp";
+		{
+			typename IoType::Out ioOut(tmpName);
+			ioOut<<checkpoint_.parameters();
+			checkpoint_.save(pS_,pE_,ioOut);
+			psi.save(vsites,ioOut);
+			PsimagLite::OstringStream msg;
+			msg<<"#LastLoopSign="<<lastSign<<"\n";
+			ioOut<<msg.str();
+		}
+
+		if (rename(tmpName.c_str(), rootName.c_str()) != 0)
+			err("Recovery: cannot rename " + tmpName + " to " + rootName + "\n");
+
+		files_.push_back(rootName);
 		flag_m_ = !flag_m_;
 	}
 
 private:
 
+	// Only the entries pushed since the last save are pending, and they
+	// and the index files are written in the background
+	void saveStacksIndex(PsimagLite::String rootWriteFile) const
+	{
+		PsimagLite::String sysWriteFile = utils::pathPrepend(checkpoint_.SYSTEM_STACK_STRING,
+		                                                     rootWriteFile);
+		PsimagLite::String envWriteFile = utils::pathPrepend(checkpoint_.ENVIRON_STACK_STRING,
+		                                                     rootWriteFile);
+		checkpoint_.saveRecoveryIndex(sysWriteFile,envWriteFile);
+		files_.push_back(sysWriteFile);
+		files_.push_back(envWriteFile);
+	}
+
 	void saveStacksForRecovery(PsimagLite::String rootWriteFile,
 	                           bool isObserveCode) const
 	{
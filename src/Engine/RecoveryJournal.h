@@ -0,0 +1,215 @@
+#ifndef RECOVERYJOURNAL_H
+#define RECOVERYJOURNAL_H
+#include "Vector.h"
+#include "ProgressIndicator.h"
+#include "DiskStackBinaryFile.h"
+#include "Utils.h"
+#include <unistd.h>
+
+/* Append-only binary copy of a stack of Checkpoint, for Recovery
+
+   Every push serializes the entry once and appends it to the journal file,
+   in the background if startThread() was called; pops only forget the id
+   of the top entry. A recovery point is then a small index file, written by
+   saveIndex() after the entries pushed before it, with the ids of the
+   entries of the stack from bottom to top; see DiskStackBinaryFile.h.
+   load() rebuilds a stack from such an index file, and continues the
+   journal that it names if it is this one.
+
+   Popped entries stay in the journal, so when saveIndex() finds that more
+   than COMPACT_FACTOR times the bytes of the stack have been written, it
+   first writes the entries of the stack, and only them, to a new journal
+   file. The old file is still named by the index files of the previous
+   recovery point, and is deleted at the second saveIndex() after that,
+   once both recovery points name the new one.
+*/
+namespace Dmrg {
+
+template<typename DataType>
+class RecoveryJournal {
+
+	typedef DiskStackBinaryFile<DataType> DiskStackBinaryFileType;
+	typedef typename DiskStackBinaryFileType::VectorSizeType VectorSizeType;
+	typedef DiskStackBinaryOut::VectorCharType VectorCharType;
+	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
+
+	enum {COMPACT_FACTOR = 2, COMPACT_MIN_BYTES = 1048576};
+
+public:
+
+	RecoveryJournal(PsimagLite::String file, bool compressed)
+	    : root_(file),
+	      compressed_(compressed),
+	      budget_(0),
+	      file_(new DiskStackBinaryFileType(file, file, false, compressed)),
+	      generation_(0),
+	      writtenBytes_(0),
+	      savesSinceCompaction_(0)
+	{}
+
+	~RecoveryJournal()
+	{
+		delete file_;
+		file_ = 0;
+	}
+
+	void startThread(SizeType budget)
+	{
+		budget_ = budget;
+		file_->startThread(0, budget);
+	}
+
+	const PsimagLite::String& filename() const { return file_->fileOut(); }
+
+	// The journal files on disk, the current one and the one being retired
+	void appendFiles(VectorStringType& files) const
+	{
+		files.push_back(file_->fileOut());
+		if (stale_ != "") files.push_back(stale_);
+	}
+
+	void push(const DataType& d)
+	{
+		VectorCharType buffer;
+		serialize(buffer, d);
+		sizes_.push_back(buffer.size());
+		writtenBytes_ += buffer.size();
+		ids_.push_back(file_->write(buffer));
+	}
+
+	void pop()
+	{
+		assert(ids_.size() > 0 && sizes_.size() == ids_.size());
+		ids_.pop_back();
+		sizes_.pop_back();
+	}
+
+	void saveIndex(PsimagLite::String indexFile)
+	{
+		if (mustCompact()) compact();
+
+		file_->saveIndexFile(indexFile, ids_);
+
+		if (stale_ == "" || ++savesSinceCompaction_ < 2) return;
+
+		file_->flush();
+		unlink(stale_.c_str());
+		stale_ = "";
+	}
+
+	void flush()
+	{
+		file_->flush();
+	}
+
+	// Pushes the entries of the stack of indexFile into stack and, unless
+	// 0, into journal, which continues instead if the index file names it
+	template<typename StackType>
+	static void load(StackType& stack,
+	                 PsimagLite::String indexFile,
+	                 RecoveryJournal* journal,
+	                 bool isObserveCode)
+	{
+		DiskStackBinaryFileType loader("", "", isObserveCode, false);
+		VectorSizeType ids;
+		loader.loadIndexFile(indexFile, ids);
+
+		bool resume = (journal && journal->ids_.size() == 0 &&
+		               loader.fileIn() == journal->filename());
+		for (SizeType i = 0; i < ids.size(); ++i) {
+			DataType* dt = loader.take(ids[i]);
+			stack.push(*dt);
+			if (journal && !resume) journal->push(*dt);
+			delete dt;
+		}
+
+		if (resume) {
+			// sizes of the resumed entries are unknown and count as 0
+			journal->file_->resumeFrom(loader);
+			journal->ids_ = ids;
+			journal->sizes_.assign(ids.size(), 0);
+		}
+
+		PsimagLite::OstringStream msg;
+		msg<<"Read "<<ids.size()<<" entries of "<<loader.fileIn()<<" from "<<indexFile;
+		PsimagLite::ProgressIndicator progress("RecoveryJournal");
+		progress.printline(msg,std::cout);
+	}
+
+private:
+
+	RecoveryJournal(const RecoveryJournal&);
+
+	RecoveryJournal& operator=(const RecoveryJournal&);
+
+	static void serialize(VectorCharType& buffer, const DataType& d)
+	{
+		DiskStackBinaryOut io;
+		d.save(io,DataType::SAVE_ALL);
+		io.swap(buffer);
+	}
+
+	SizeType liveBytes() const
+	{
+		SizeType sum = 0;
+		for (SizeType i = 0; i < sizes_.size(); ++i)
+			sum += sizes_[i];
+		return sum;
+	}
+
+	bool mustCompact() const
+	{
+		if (stale_ != "") return false;
+		if (writtenBytes_ < COMPACT_MIN_BYTES) return false;
+		return (writtenBytes_ > COMPACT_FACTOR*liveBytes());
+	}
+
+	void compact()
+	{
+		PsimagLite::String name = utils::pathPrepend("Gen" + ttos(++generation_), root_);
+		DiskStackBinaryFileType* fresh = new DiskStackBinaryFileType(name,
+		                                                             name,
+		                                                             false,
+		                                                             compressed_);
+		fresh->startThread(0, budget_);
+
+		SizeType before = writtenBytes_;
+		writtenBytes_ = 0;
+		for (SizeType i = 0; i < ids_.size(); ++i) {
+			DataType* dt = file_->take(ids_[i]);
+			VectorCharType buffer;
+			serialize(buffer, *dt);
+			delete dt;
+			sizes_[i] = buffer.size();
+			writtenBytes_ += buffer.size();
+			ids_[i] = fresh->write(buffer);
+		}
+
+		file_->flush();
+		stale_ = file_->fileOut();
+		delete file_;
+		file_ = fresh;
+		savesSinceCompaction_ = 0;
+
+		PsimagLite::OstringStream msg;
+		msg<<"Compacted "<<stale_<<" ("<<before<<" bytes) into "<<name;
+		msg<<" ("<<writtenBytes_<<" bytes)";
+		PsimagLite::ProgressIndicator progress("RecoveryJournal");
+		progress.printline(msg,std::cout);
+	}
+
+	PsimagLite::String root_;
+	bool compressed_;
+	SizeType budget_;
+	DiskStackBinaryFileType* file_;
+	SizeType generation_;
+	SizeType writtenBytes_;
+	SizeType savesSinceCompaction_;
+	PsimagLite::String stale_;
+	VectorSizeType ids_;
+	VectorSizeType sizes_;
+}; // class RecoveryJournal
+
+} // namespace Dmrg
+
+#endif // RECOVERYJOURNAL_H
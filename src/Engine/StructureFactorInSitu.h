@@ -0,0 +1,108 @@
+#ifndef STRUCTUREFACTORINSITU_H
+#define STRUCTUREFACTORINSITU_H
+#include "Vector.h"
+#include "ProgressIndicator.h"
+#include <fstream>
+#include <cmath>
+
+/* S(q,omega) of a chain from the correction vectors, as they are obtained
+
+   For each site j the sweep gives <gs|A_j|P2> and <gs|A_j|P3>, the
+   in-situ measurements of the correction vector at omega; the values of
+   the latest step that measured j are kept. write() Fourier transforms
+   them with respect to the central site c, as procOmegas.pl does for a
+   chain, S(q_m) = sum_j cos(q_m (j - c)) v_j, with q_m = 2 pi m/M if
+   periodic and q_m = pi m/(M + 1) otherwise, for m = 0, ..., M - 1.
+   Each line of the table has q, the sum for P3 and that for P2, in the
+   order of the .sq files of procOmegas.pl.
+*/
+namespace Dmrg {
+
+template<typename ComplexOrRealType>
+class StructureFactorInSitu {
+
+	typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
+	typedef typename PsimagLite::Vector<ComplexOrRealType>::Type VectorType;
+	typedef PsimagLite::Vector<bool>::Type VectorBoolType;
+
+public:
+
+	enum {P2, P3};
+
+	// qPoints = 0 disables it
+	StructureFactorInSitu(SizeType sites,
+	                      SizeType centralSite,
+	                      SizeType qPoints,
+	                      bool periodic,
+	                      RealType omega)
+	    : centralSite_(centralSite),
+	      qPoints_(qPoints),
+	      periodic_(periodic),
+	      omega_(omega),
+	      values_(2, VectorType(sites, 0.0)),
+	      measured_(sites, false)
+	{}
+
+	bool enabled() const { return (qPoints_ > 0); }
+
+	// which is P2 or P3
+	void set(SizeType site, SizeType which, const ComplexOrRealType& value)
+	{
+		if (!enabled()) return;
+		assert(which < values_.size() && site < measured_.size());
+		values_[which][site] = value;
+		measured_[site] = true;
+	}
+
+	void write(PsimagLite::String file, SizeType precision) const
+	{
+		if (!enabled()) return;
+
+		std::ofstream fout(file.c_str());
+		if (!fout || !fout.good())
+			err("StructureFactorInSitu: cannot write to " + file + "\n");
+
+		fout.precision(precision);
+		fout<<"#omega="<<omega_<<"\n";
+		SizeType sites = measured_.size();
+		SizeType missing = 0;
+		for (SizeType j = 0; j < sites; ++j)
+			if (!measured_[j]) missing++;
+
+		for (SizeType m = 0; m < qPoints_; ++m) {
+			RealType q = (periodic_) ? 2.0*M_PI*m/qPoints_ : M_PI*m/(qPoints_ + 1.0);
+			ComplexOrRealType sum3 = 0.0;
+			ComplexOrRealType sum2 = 0.0;
+			for (SizeType j = 0; j < sites; ++j) {
+				RealType arg = q*(static_cast<RealType>(j) - centralSite_);
+				RealType carg = cos(arg);
+				sum3 += values_[P3][j]*carg;
+				sum2 += values_[P2][j]*carg;
+			}
+
+			fout<<q<<" "<<sum3<<" "<<sum2<<"\n";
+		}
+
+		fout.close();
+
+		PsimagLite::OstringStream msg;
+		msg<<"Wrote S(q,omega) for "<<qPoints_<<" q points to "<<file;
+		if (missing > 0)
+			msg<<"; "<<missing<<" sites were not measured and count as zero";
+		PsimagLite::ProgressIndicator progress("StructureFactorInSitu");
+		progress.printline(msg,std::cout);
+	}
+
+private:
+
+	SizeType centralSite_;
+	SizeType qPoints_;
+	bool periodic_;
+	RealType omega_;
+	typename PsimagLite::Vector<VectorType>::Type values_;
+	VectorBoolType measured_;
+}; // class StructureFactorInSitu
+
+} // namespace Dmrg
+
+#endif // STRUCTUREFACTORINSITU_H
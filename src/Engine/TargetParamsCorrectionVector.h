@@ -110,7 +110,9 @@ public:
 	TargetParamsCorrectionVector(IoInputter& io,const ModelType& model)
 	    : BaseType(io,model),
 	      cgSteps_(1000),
-	      cgEps_(1e-6)
+	      cgEps_(1e-6),
+	      sqPoints_(0),
+	      sqPeriodic_(false)
 	{
 		io.readline(correctionA_,"CorrectionA=");
 		io.readline(type_,"DynamicDmrgType=");
@@ -149,6 +151,19 @@ public:
 			io.readline(cgEps_,"ConjugateGradientEps=");
 		} catch (std::exception& e) {}
 
+		// CorrectionVectorSqPoints=M computes S(q,omega) for M q points
+		// during the sweep, from the first in-situ operator;
+		// CorrectionVectorSqPeriodic=1 uses the q points of a periodic chain
+		try {
+			io.readline(sqPoints_,"CorrectionVectorSqPoints=");
+		} catch (std::exception&) {}
+
+		try {
+			int x = 0;
+			io.readline(x,"CorrectionVectorSqPeriodic=");
+			sqPeriodic_ = (x > 0);
+		} catch (std::exception&) {}
+
 		try {
 			int x = 0;
 			io.readline(x,"TSPUseQns=");
@@ -201,6 +216,10 @@ public:
 		return algorithm_;
 	}
 
+	SizeType sqPoints() const { return sqPoints_; }
+
+	bool sqPeriodic() const { return sqPeriodic_; }
+
 private:
 
 	SizeType type_;
@@ -210,6 +229,8 @@ private:
 	PairFreqType omega_;
 	RealType eta_;
 	RealType cgEps_;
+	SizeType sqPoints_;
+	bool sqPeriodic_;
 }; // class TargetParamsCorrectionVector
 
 template<typename ModelType>
@@ -224,6 +245,10 @@ inline std::ostream& operator<<(std::ostream& os,
 	os<<"CorrectionVectorEta="<<t.eta()<<"\n";
 	os<<"ConjugateGradientSteps"<<t.cgSteps()<<"\n";
 	os<<"ConjugateGradientEps"<<t.cgEps()<<"\n";
+	if (t.sqPoints() > 0) {
+		os<<"CorrectionVectorSqPoints="<<t.sqPoints()<<"\n";
+		os<<"CorrectionVectorSqPeriodic="<<t.sqPeriodic()<<"\n";
+	}
 	return os;
 }
 } // namespace Dmrg
@@ -112,6 +112,7 @@ public:
 	typedef typename BasisType::BlockType BlockType;
 	typedef typename BaseType::WaveFunctionTransfType WaveFunctionTransfType;
 	typedef typename WaveFunctionTransfType::VectorWithOffsetType VectorWithOffsetType;
+	typedef typename PsimagLite::Vector<VectorWithOffsetType>::Type VectorVectorWithOffsetType;
 	typedef typename VectorWithOffsetType::VectorType VectorType;
 	typedef VectorType TargetVectorType;
 	typedef TimeSerializer<VectorWithOffsetType> TimeSerializerType;
@@ -244,25 +245,28 @@ private:
 		if (!done_) calcDynVectors(site,phiNew);
 	}
 
+	// The (at most two) dynamic vectors in one WFT pass; the other
+	// entries of result are left empty, so that the WFT skips them
 	void wftAllDynVectors(SizeType site)
-	{
-		for (SizeType i=0;i<=lastLanczosVector_;i++)
-			if (i<2) wftOneDynVector(i,site);
-	}
-
-	void wftOneDynVector(SizeType i,SizeType site)
 	{
 		typename PsimagLite::Vector<SizeType>::Type nk(1,this->model().hilbertSize(site));
+		const VectorVectorWithOffsetType& src = this->common().targetVectors();
+		SizeType n = std::min(lastLanczosVector_ + 1, SizeType(2));
 
-		VectorWithOffsetType result;
-		result.populateSectors(this->lrs().super());
-
-		// OK, now that we got the partition number right, let's wft:
+		VectorVectorWithOffsetType result(src.size());
+		for (SizeType i=0;i<n;i++) {
+			if (src[i].size() == 0) continue;
+			result[i].populateSectors(this->lrs().super());
+		}
 
 		// FIXME generalize for su(2)
-		wft_.setInitialVector(result,this->common().targetVectors()[i],this->lrs(),nk);
-		result.collapseSectors();
-		this->common().targetVectors(i) = result;
+		wft_.setInitialVectors(result,src,this->lrs(),nk);
+
+		for (SizeType i=0;i<n;i++) {
+			if (result[i].size() == 0) continue;
+			result[i].collapseSectors();
+			this->common().targetVectors(i) = result[i];
+		}
 	}
 
 	void calcDynVectors(SizeType site,const VectorWithOffsetType& phiNew)
@@ -193,6 +193,9 @@ public:
 
 	virtual void print(InputSimpleOutType&) const = 0;
 
+	// Writes, once the finite loops are done, what the sweeps computed
+	virtual void write(const PsimagLite::String&, SizeType) const {}
+
 	virtual void load(const PsimagLite::String&) = 0;
 
 	virtual void save(const typename PsimagLite::Vector<SizeType>::Type&,
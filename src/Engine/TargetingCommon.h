@@ -530,6 +530,26 @@ public:
 		std::cout<<"-------------&*&*&* In-situ measurements end\n";
 	}
 
+	// <v1|A|v2> for the first in-situ operator A at site, as cocoon
+	// prints it; zero if there are no in-situ operators
+	ComplexOrRealType inSituValue(ProgramGlobals::DirectionEnum direction,
+	                              SizeType site,
+	                              const VectorWithOffsetType& v1,
+	                              PsimagLite::String label1,
+	                              const VectorWithOffsetType& v2,
+	                              PsimagLite::String label2,
+	                              bool atBorder) const
+	{
+		VectorStringType vecStr = getOperatorLabels();
+		if (vecStr.size() == 0) return 0.0;
+
+		PsimagLite::String opLabel = braketIfNeeded(vecStr[0],site,label1,label2);
+		BraketType braket(targetHelper_.model(), opLabel);
+		BorderEnumType border = (atBorder) ? ApplyOperatorType::BORDER_YES :
+		                                     ApplyOperatorType::BORDER_NO;
+		return test_(v1,v2,direction,site,braket.op(0),border);
+	}
+
 	void calcBracket(ProgramGlobals::DirectionEnum direction,
 	                 SizeType site,
 	                 const BraketType& braket) const
@@ -638,9 +658,12 @@ private:
 		const WaveFunctionTransfType& wft = targetHelper_.wft();
 
 		if (noguess)
-			wft.createRandomVector(v1);
-		else
-			wft.setInitialVector(v1,v2,targetHelper_.lrs(),nk);
+			return wft.createRandomVector(v1);
+
+		VectorVectorWithOffsetType dest(1,v1);
+		VectorVectorWithOffsetType src(1,v2);
+		wft.setInitialVectors(dest,src,targetHelper_.lrs(),nk);
+		v1 = dest[0];
 	}
 
 	// prints <v1|A|v2>
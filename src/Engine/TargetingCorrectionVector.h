@@ -93,6 +93,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "FreqEnum.h"
 #include "NoPthreadsNg.h"
 #include "CorrectionVectorSkeleton.h"
+#include "StructureFactorInSitu.h"
 
 namespace Dmrg {
 
@@ -143,6 +144,7 @@ public:
 	VectorWithOffsetType,
 	BaseType,
 	TargetParamsType> CorrectionVectorSkeletonType;
+	typedef StructureFactorInSitu<ComplexOrRealType> StructureFactorInSituType;
 
 	enum {DISABLED,OPERATOR,CONVERGING};
 
@@ -161,11 +163,20 @@ public:
 	      gsWeight_(1.0),
 	      correctionEnabled_(false),
 	      paramsForSolver_(ioIn,"DynamicDmrg"),
-	      skeleton_(ioIn_,tstStruct_,model,lrs,this->common().energy())
+	      skeleton_(ioIn_,tstStruct_,model,lrs,this->common().energy()),
+	      sq_(model.geometry().numberOfSites(),
+	          tstStruct_.sites(0),
+	          tstStruct_.sqPoints(),
+	          tstStruct_.sqPeriodic(),
+	          tstStruct_.omega().second)
 	{
 		this->common().init(&tstStruct_,4);
 		if (!wft.isEnabled())
 			throw PsimagLite::RuntimeError("TargetingCorrectionVector needs wft\n");
+
+		// S(q) is computed from the first in-situ operator
+		if (tstStruct_.sqPoints() > 0 && model.params().insitu == "")
+			err("CorrectionVectorSqPoints needs an in-situ operator in insitu=\n");
 	}
 
 	RealType weight(SizeType i) const
@@ -231,6 +242,11 @@ public:
 		this->common().template load<TimeSerializerType>(f);
 	}
 
+	void write(const PsimagLite::String& file, SizeType precision) const
+	{
+		sq_.write(file,precision);
+	}
+
 private:
 
 	void evolve(RealType Eg,
@@ -265,6 +281,37 @@ private:
 			                      this->common().targetVectors(i),
 			                      label);
 		}
+
+		if (sq_.enabled()) measureSq(direction,site);
+	}
+
+	// <gs|A|P2> and <gs|A|P3> at site, and at the border site next to it
+	void measureSq(ProgramGlobals::DirectionEnum direction, SizeType site)
+	{
+		SizeType numberOfSites = this->lrs().super().block().size();
+		int site2 = ProgramGlobals::findBorderSiteFrom(site, direction, numberOfSites);
+		const VectorWithOffsetType& psi = this->common().psi();
+		for (SizeType i = 2; i < 4; ++i) {
+			SizeType which = (i == 2) ? StructureFactorInSituType::P2 :
+			                            StructureFactorInSituType::P3;
+			const VectorWithOffsetType& v = this->common().targetVectors(i);
+			PsimagLite::String label = "P" + ttos(i);
+			sq_.set(site,which,this->common().inSituValue(direction,
+			                                              site,
+			                                              psi,
+			                                              "PSI",
+			                                              v,
+			                                              label,
+			                                              false));
+			if (site2 < 0) continue;
+			sq_.set(site2,which,this->common().inSituValue(direction,
+			                                               site2,
+			                                               psi,
+			                                               "PSI",
+			                                               v,
+			                                               label,
+			                                               true));
+		}
 	}
 
 	void setWeights()
@@ -308,6 +355,7 @@ private:
 	typename PsimagLite::Vector<RealType>::Type weight_;
 	typename LanczosSolverType::ParametersSolverType paramsForSolver_;
 	CorrectionVectorSkeletonType skeleton_;
+	StructureFactorInSituType sq_;
 }; // class TargetingCorrectionVector
 
 template<typename LanczosSolverType, typename VectorWithOffsetType>
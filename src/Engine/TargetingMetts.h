@@ -247,21 +247,22 @@ public:
 		}
 
 		// Advance or wft each target vector for beta/2
-		for (SizeType i=0;i<max;i++) {
-			evolve(i,0,n1-1,Eg,direction,sites,loopNumber);
-		}
+		VectorSizeType indices(max);
+		for (SizeType i=0;i<max;i++)
+			indices[i] = i;
+		evolve(indices,0,n1-1,Eg,direction,sites,loopNumber);
 
 		// compute imag. time evolution:
 		calcTimeVectors(PairType(0,n1),Eg,direction,block1);
 
 		// Advance or wft  collapsed vector
 		if (this->common().targetVectors()[n1].size()>0)
-			evolve(n1,n1,n1-1,Eg,direction,sites,loopNumber);
+			evolve(VectorSizeType(1,n1),n1,n1-1,Eg,direction,sites,loopNumber);
 
 		for (SizeType i=0;i<this->common().targetVectors().size();i++)
 			assert(this->common().targetVectors()[i].size()==0 ||
 			       this->common().targetVectors()[i].size()==
-			       lrs_.super().permutationVector().size());
+			       lrs_.super().size());
 
 		cocoon(direction,block1); // in-situ
 
@@ -351,7 +352,7 @@ public:
 
 private:
 
-	void evolve(SizeType index,
+	void evolve(const VectorSizeType& indices,
 	            SizeType start,
 	            SizeType indexAdvance,
 	            RealType Eg,
@@ -359,14 +360,15 @@ private:
 	            const VectorSizeType& block,
 	            SizeType loopNumber)
 	{
-		if (index==0 && start==0)
+		assert(indices.size() > 0);
+		if (indices[0]==0 && start==0)
 			advanceCounterAndComputeStage(block);
 
 		PsimagLite::OstringStream msg;
 		msg<<"Evolving, stage="<<getStage()<<" loopNumber="<<loopNumber;
 		msg<<" Eg="<<Eg;
 		progress_.printline(msg,std::cout);
-		advanceOrWft(index,indexAdvance,direction,block);
+		advanceOrWft(indices,indexAdvance,direction,block);
 	}
 
 	void calcTimeVectors(const PairType& startEnd,
@@ -465,19 +467,30 @@ private:
 			progress_.printline(msg2,std::cout);
 	}
 
-	void advanceOrWft(SizeType index,
+	// The target vectors in indices in one WFT pass; each one reads its
+	// source before any is written, as when they were done in order,
+	// because the sources are indexAdvance or the vector itself
+	void advanceOrWft(const VectorSizeType& indices,
 	                  SizeType indexAdvance,
 	                  SizeType,
 	                  const VectorSizeType& block)
 	{
-		if (this->common().targetVectors()[index].size()==0) return;
-		assert(norm(this->common().targetVectors()[index])>1e-6);
 		VectorSizeType nk;
 		mettsCollapse_.setNk(nk,block);
 
-		if (this->common().allStages(WFT_NOADVANCE) ||
-		    this->common().allStages(WFT_ADVANCE) ||
-		    this->common().allStages(COLLAPSE)) {
+		if (!this->common().allStages(WFT_NOADVANCE) &&
+		    !this->common().allStages(WFT_ADVANCE) &&
+		    !this->common().allStages(COLLAPSE)) {
+			assert(false);
+			return;
+		}
+
+		VectorVectorWithOffsetType phiNew(indices.size()); // same sectors as g.s.
+		VectorVectorWithOffsetType src(indices.size());
+		for (SizeType i=0;i<indices.size();i++) {
+			SizeType index = indices[i];
+			if (this->common().targetVectors()[index].size()==0) continue;
+			assert(norm(this->common().targetVectors()[index])>1e-6);
 			SizeType advance = index;
 			if (this->common().allStages(WFT_ADVANCE)) {
 				advance = indexAdvance;
@@ -485,22 +498,23 @@ private:
 			}
 			// don't advance the collapsed vector because we'll recompute
 			if (index==weight_.size()-1) advance=index;
-			PsimagLite::OstringStream msg;
-			msg<<"I'm calling the WFT now";
-			progress_.printline(msg,std::cout);
-
-			VectorWithOffsetType phiNew; // same sectors as g.s.
-			//phiNew.populateSectors(lrs_.super());
 			assert(norm(this->common().targetVectors()[advance])>1e-6);
 
-			phiNew.populateSectors(lrs_.super());
-			// OK, now that we got the partition number right, let's wft:
-			wft_.setInitialVector(phiNew,this->common().targetVectors()[advance],lrs_,nk);
-			phiNew.collapseSectors();
-			assert(norm(phiNew)>1e-6);
-			this->common().targetVectors(index) = phiNew;
-		} else {
-			assert(false);
+			src[i] = this->common().targetVectors()[advance];
+			phiNew[i].populateSectors(lrs_.super());
+		}
+
+		PsimagLite::OstringStream msg;
+		msg<<"I'm calling the WFT now";
+		progress_.printline(msg,std::cout);
+
+		// OK, now that we got the partition number right, let's wft:
+		wft_.setInitialVectors(phiNew,src,lrs_,nk);
+		for (SizeType i=0;i<indices.size();i++) {
+			if (phiNew[i].size()==0) continue;
+			phiNew[i].collapseSectors();
+			assert(norm(phiNew[i])>1e-6);
+			this->common().targetVectors(indices[i]) = phiNew[i];
 		}
 	}
 
@@ -272,22 +272,25 @@ private:
 
 	void wftAll(const VectorSizeType& block)
 	{
-		for (SizeType i=1;i<times_.size();i++)
-			wftOne(i,block);
-	}
-
-	void wftOne(SizeType i,const VectorSizeType& block)
-	{
-		VectorWithOffsetType phiNew = targetVectors_[0];
+		SizeType n = times_.size();
+		VectorVectorWithOffsetType phiNew(n);
+		for (SizeType i=1;i<n;i++) {
+			if (targetVectors_[i].size() == 0) continue;
+			phiNew[i] = targetVectors_[0];
+		}
 
 		// OK, now that we got the partition number right, let's wft:
 		VectorSizeType nk;
 		setNk(nk,block);
 		// generalize for su(2)
-		wft_.setInitialVector(phiNew,targetVectors_[i],lrs_,nk);
-		phiNew.collapseSectors();
-		assert(norm(phiNew)>1e-6);
-		targetVectors_[i]=phiNew;
+		wft_.setInitialVectors(phiNew,targetVectors_,lrs_,nk);
+
+		for (SizeType i=1;i<n;i++) {
+			if (phiNew[i].size() == 0) continue;
+			phiNew[i].collapseSectors();
+			assert(norm(phiNew[i])>1e-6);
+			targetVectors_[i]=phiNew[i];
+		}
 	}
 
 	void calcTargetVector(VectorWithOffsetType& target,
@@ -383,7 +386,7 @@ private:
 	                      const TargetVectorType& phi0,
 	                      SizeType xp,
 	                      SizeType yp,
-	                      const PackIndicesType& packSuper,
+	                      const PackIndicesType&,
 	                      const BlockType& block,
 	                      const MatrixComplexOrRealType& m,
 	                      SizeType i,
@@ -426,9 +429,7 @@ private:
 						SizeType x = packLeft.pack(x1,
 						                           x2,
 						                           lrs_.left().permutationInverse());
-						SizeType j = packSuper.pack(x,
-						                            y,
-						                            lrs_.super().permutationInverse());
+						SizeType j = lrs_.super().permutationInverse(x + y*ns);
 						ComplexOrRealType tmp = m(iperm[x2+y1*hilbertSize],
 						        iperm[x2p+y1p*hilbertSize]);
 						if (PsimagLite::norm(tmp)<1e-12) continue;
@@ -446,7 +447,7 @@ private:
 	                       const TargetVectorType& phi0,
 	                       SizeType xp,
 	                       SizeType yp,
-	                       const PackIndicesType& packSuper,
+	                       const PackIndicesType&,
 	                       const BlockType& block,
 	                       const MatrixComplexOrRealType& m,
 	                       SizeType i,
@@ -491,9 +492,7 @@ private:
 						SizeType y = packRight.pack(y1,
 						                            y2,
 						                            lrs_.right().permutationInverse());
-						SizeType j = packSuper.pack(x,
-						                            y,
-						                            lrs_.super().permutationInverse());
+						SizeType j = lrs_.super().permutationInverse(x + y*ns);
 
 						ComplexOrRealType tmp = m(iperm[x2+y1*hilbertSize],
 						        iperm[x2p+y1p*hilbertSize]);
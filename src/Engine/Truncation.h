@@ -106,6 +106,9 @@ class Truncation  {
 	typedef typename DensityMatrixBaseType::BlockDiagonalMatrixType BlockDiagonalMatrixType;
 	typedef typename TargettingType::ModelType ModelType;
 	typedef typename ModelType::ReflectionSymmetryType ReflectionSymmetryType;
+	typedef typename ModelType::GeometryType GeometryType;
+	typedef typename BasisWithOperatorsType::VectorBoolType VectorBoolType;
+	typedef typename BasisType::BlockType BlockType;
 
 public:
 
@@ -121,13 +124,16 @@ public:
 	Truncation(ReflectionSymmetryType& reflectionOperator,
 	           WaveFunctionTransfType& waveFunctionTransformation,
 	           const ParametersType& parameters,
-	           SizeType maxConnections,
+	           const GeometryType& geometry,
 	           bool verbose)
 	    : reflectionOperator_(reflectionOperator),
 	      lrs_(reflectionOperator_.leftRightSuper()),
 	      waveFunctionTransformation_(waveFunctionTransformation),
 	      parameters_(parameters),
-	      maxConnections_(maxConnections),
+	      geometry_(geometry),
+	      maxConnections_(geometry.maxConnections()),
+	      connectedOperatorsOnly_(parameters.options.find("connectedOperatorsOnly") !=
+	        PsimagLite::String::npos),
 	      verbose_(verbose),
 	      progress_("Truncation"),
 	      error_(0.0)
@@ -259,6 +265,9 @@ private:
 		if (startEnd.second > mostRecent)
 			startEnd.first = startEnd.second - mostRecent;
 
+		VectorBoolType keep;
+		findOperatorsToKeep(keep, rSprime, startEnd);
+
 		PsimagLite::OstringStream msg;
 		TruncationCache& cache = leftCache_;
 
@@ -269,7 +278,8 @@ private:
 		rSprime.truncateBasis(cache.transform,
 		                      cache.eigs,
 		                      cache.removedIndices,
-		                      startEnd);
+		                      keep,
+		                      parameters_);
 		LeftRightSuperType lrs(rSprime,(BasisWithOperatorsType&) eBasis,
 		                       (BasisType&)lrs_.super());
 		bool twoSiteDmrg = waveFunctionTransformation_.options().twoSiteDmrg;
@@ -296,6 +306,9 @@ private:
 		if (startEnd.second > mostRecent)
 			startEnd.second = mostRecent;
 
+		VectorBoolType keep;
+		findOperatorsToKeep(keep, rEprime, startEnd);
+
 		PsimagLite::OstringStream msg;
 		TruncationCache& cache = rightCache_;
 
@@ -307,7 +320,8 @@ private:
 		rEprime.truncateBasis(cache.transform,
 		                      cache.eigs,
 		                      cache.removedIndices,
-		                      startEnd);
+		                      keep,
+		                      parameters_);
 		LeftRightSuperType lrs((BasisWithOperatorsType&) sBasis,
 		                       rEprime,(BasisType&)lrs_.super());
 		bool twoSiteDmrg = waveFunctionTransformation_.options().twoSiteDmrg;
@@ -323,6 +337,63 @@ private:
 		progress_.printline(msg,std::cout);
 	}
 
+	/* PSIDOC TruncationOperatorsToKeep
+		Only some local operators of a block are rotated at each truncation,
+		the others are removed and any later use of them throws.
+		By default these are the operators of the most recent
+		GeometryMaxConnections sites of the block. With SolverOptions
+		connectedOperatorsOnly they are instead the operators of the sites
+		of the block that the geometry connects to at least one site out of it.
+		Blocks only grow away from their other sites, so the operators of
+		a site with no such connection are never needed again.
+		*/
+	void findOperatorsToKeep(VectorBoolType& keep,
+	                         const BasisWithOperatorsType& basis,
+	                         const PairSizeSizeType& startEnd)
+	{
+		SizeType numOfOp = basis.numberOfOperators();
+		keep.resize(numOfOp);
+		if (!connectedOperatorsOnly_) {
+			for (SizeType k = 0; k < numOfOp; ++k)
+				keep[k] = (k >= startEnd.first && k < startEnd.second);
+			return;
+		}
+
+		const BlockType& block = basis.block();
+		SizeType kept = 0;
+		for (SizeType i = 0; i < block.size(); ++i) {
+			bool b = isConnectedOutside(block[i], block);
+			typename BasisWithOperatorsType::PairType ii = basis.getOperatorIndices(i, 0);
+			for (SizeType sigma = 0; sigma < ii.second; ++sigma) {
+				assert(ii.first + sigma < numOfOp);
+				keep[ii.first + sigma] = b;
+			}
+
+			if (b) kept += ii.second;
+		}
+
+		PsimagLite::OstringStream msg;
+		msg<<"connectedOperatorsOnly: keeping "<<kept<<" of "<<numOfOp<<" operators";
+		progress_.printline(msg,std::cout);
+	}
+
+	// true if the geometry connects site, which is in block, with any site
+	// out of block; block is a contiguous range of sites
+	bool isConnectedOutside(SizeType site, const BlockType& block) const
+	{
+		assert(block.size() > 0);
+		SizeType first = block[0];
+		SizeType last = block[block.size() - 1];
+		SizeType n = geometry_.numberOfSites();
+		for (SizeType j = 0; j < n; ++j) {
+			if (j >= first && j <= last) continue;
+			SizeType boundary = (j > last) ? last + 1 : first;
+			if (geometry_.connected(boundary - 1, boundary, site, j)) return true;
+		}
+
+		return false;
+	}
+
 	void updateKeptStates(SizeType& keptStates,
 	                      const typename PsimagLite::Vector<RealType>::Type& eigs2)
 	{
@@ -426,7 +497,9 @@ private:
 	const LeftRightSuperType& lrs_;
 	WaveFunctionTransfType& waveFunctionTransformation_;
 	const ParametersType& parameters_;
+	const GeometryType& geometry_;
 	SizeType maxConnections_;
+	bool connectedOperatorsOnly_;
 	bool verbose_;
 	ProgressIndicatorType progress_;
 	RealType error_;
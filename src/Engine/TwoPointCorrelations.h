@@ -87,6 +87,12 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Parallel2PointCorrelations.h"
 #include "Concurrency.h"
 #include "Parallelizer.h"
+#ifdef USE_PTHREADS
+#include "PthreadsNg.h"
+#else
+#include "NoPthreadsNg.h"
+#endif
+#include "Mpi.h"
 
 namespace Dmrg {
 
@@ -116,13 +122,20 @@ public:
 	typedef typename CorrelationsSkeletonType::SparseMatrixType SparseMatrixType;
 	typedef typename ObserverHelperType::MatrixType MatrixType;
 	typedef Parallel2PointCorrelations<ThisType> Parallel2PointCorrelationsType;
-	typedef typename Parallel2PointCorrelationsType::PairType PairType;
+	typedef typename Parallel2PointCorrelationsType::VectorSizeType VectorSizeType;
+	typedef typename CorrelationsSkeletonType::VectorSparseMatrixType VectorSparseMatrixType;
+	typedef typename CorrelationsSkeletonType::VectorIntType VectorIntType;
+	typedef typename PsimagLite::Vector<PsimagLite::Matrix<FieldType> >::Type VectorMatrixType;
 
+	// With distributed, and MPI, each rank computes some of the rows and
+	// all ranks get all rows at the end
 	TwoPointCorrelations(ObserverHelperType& helper,
 	                     CorrelationsSkeletonType& skeleton,
+	                     bool distributed = false,
 	                     bool verbose=false)
 	    : helper_(helper),
 	      skeleton_(skeleton),
+	      distributed_(distributed && PsimagLite::Concurrency::hasMpi()),
 	      verbose_(verbose)
 	{}
 
@@ -131,24 +144,61 @@ public:
 	                const SparseMatrixType& O2,
 	                int fermionicSign)
 	{
-		SizeType rows = w.n_row();
-		SizeType cols = w.n_col();
-
-		typename PsimagLite::Vector<PairType>::Type pairs;
-		for (SizeType i=0;i<rows;i++) {
-			for (SizeType j=i;j<cols;j++) {
-				if (i>j) continue;
-				pairs.push_back(PairType(i,j));
-			}
+		VectorMatrixType ws(1,w);
+		operator()(ws,
+		           VectorSparseMatrixType(1,O1),
+		           VectorSparseMatrixType(1,O2),
+		           VectorIntType(1,fermionicSign));
+		w = ws[0];
+	}
+
+	// Several correlations, all of the size of ws[0], in one traversal of the sites;
+	// ws[x] gets the correlations of O1s[x] and O2s[x]
+	void operator()(VectorMatrixType& ws,
+	                const VectorSparseMatrixType& O1s,
+	                const VectorSparseMatrixType& O2s,
+	                const VectorIntType& fermionicSigns)
+	{
+		if (ws.size() == 0) return;
+		assert(O1s.size() == ws.size() && O2s.size() == ws.size());
+		assert(fermionicSigns.size() == ws.size());
+		SizeType rows = ws[0].n_row();
+
+		SizeType ranks = 1;
+		SizeType rank = 0;
+		if (distributed_) {
+			ranks = PsimagLite::MPI::commSize(PsimagLite::MPI::COMM_WORLD);
+			rank = PsimagLite::MPI::commRank(PsimagLite::MPI::COMM_WORLD);
 		}
 
-		typedef PsimagLite::Parallelizer<Parallel2PointCorrelationsType> ParallelizerType;
-		ParallelizerType threaded2Points(PsimagLite::Concurrency::npthreads,
-		                                 PsimagLite::MPI::COMM_WORLD);
+		// long and short rows alternate, so that threads, and ranks,
+		// get similar work
+		VectorSizeType rowList;
+		for (SizeType k=0;k<rows;k++) {
+			if (k % ranks != rank) continue;
+			rowList.push_back((k & 1) ? rows-1-k/2 : k/2);
+		}
 
-		Parallel2PointCorrelationsType helper2Points(w,*this,pairs,O1,O2,fermionicSign);
+		Parallel2PointCorrelationsType helper2Points(ws,*this,rowList,O1s,O2s,fermionicSigns);
+
+		if (distributed_) {
+			// rows are already split over ranks, so only threads, and
+			// no communicator, share them here
+#ifdef USE_PTHREADS
+			typedef PsimagLite::PthreadsNg<Parallel2PointCorrelationsType> ThreadsOnlyType;
+#else
+			typedef PsimagLite::NoPthreadsNg<Parallel2PointCorrelationsType> ThreadsOnlyType;
+#endif
+			ThreadsOnlyType threaded2Points(PsimagLite::Concurrency::npthreads,0,false);
+			threaded2Points.loopCreate(helper2Points);
+		} else {
+			typedef PsimagLite::Parallelizer<Parallel2PointCorrelationsType> ParallelizerType;
+			ParallelizerType threaded2Points(PsimagLite::Concurrency::npthreads,
+			                                 PsimagLite::MPI::COMM_WORLD);
+			threaded2Points.loopCreate(helper2Points);
+		}
 
-		threaded2Points.loopCreate(helper2Points);
+		if (ranks > 1) gatherRows(ws,rowList);
 	}
 
 	// Return the vector: O1 * O2 |psi>
@@ -174,8 +224,100 @@ public:
 		return c;
 	}
 
+	// Row i of each ws[x], from the diagonal on: the O1s grown up to site
+	// j-1 are grown one more site for column j+1 instead of from i again
+	void calcRows(VectorMatrixType& ws,
+	              SizeType i,
+	              const VectorSparseMatrixType& O1s,
+	              const VectorSparseMatrixType& O2s,
+	              const VectorIntType& fermionicSigns,
+	              SizeType threadId)
+	{
+		SizeType ops = ws.size();
+		SizeType cols = ws[0].n_col();
+		if (i >= cols) return;
+
+		for (SizeType x=0;x<ops;x++)
+			ws[x](i,i) = calcDiagonalCorrelation(i,O1s[x],O2s[x],fermionicSigns[x],threadId);
+		if (i+1 >= cols) return;
+
+		SizeType lastSite = skeleton_.numberOfSites(threadId)-1;
+		SizeType nt = (i > 0) ? i-1 : 0;
+		VectorSparseMatrixType O1g = O1s;
+		VectorSparseMatrixType O1new;
+		SparseMatrixType O2g;
+		SizeType grown = nt; // the O1g are grown through the sites before this one
+
+		for (SizeType j=i+1;j<cols;j++) {
+			if (j==lastSite && i==j-1) {
+				helper_.setPointer(threadId,j-2);
+				SizeType ni = helper_.leftRightSuper(threadId).left().size()/
+				        helper_.leftRightSuper(threadId).right().size();
+
+				SparseMatrixType O1ident;
+				O1ident.makeDiagonal(ni,1.0);
+				for (SizeType x=0;x<ops;x++)
+					ws[x](i,j) = skeleton_.bracketRightCorner(O1ident,
+					                                          O1s[x],
+					                                          O2s[x],
+					                                          fermionicSigns[x],
+					                                          threadId);
+				continue;
+			}
+
+			SizeType ns = (j==lastSite) ? j-2 : j-1;
+			for (;grown<ns;grown++) {
+				helper_.setPointer(threadId,grown);
+				SizeType growOption = skeleton_.growthDirection(grown,nt,i,threadId);
+				skeleton_.fluffUp(O1new,O1g,fermionicSigns,growOption,threadId);
+				for (SizeType x=0;x<ops;x++)
+					helper_.transform(O1g[x],O1new[x],threadId);
+			}
+
+			if (j==lastSite) {
+				helper_.setPointer(threadId,j-2);
+				for (SizeType x=0;x<ops;x++)
+					ws[x](i,j) = skeleton_.bracketRightCorner(O1g[x],
+					                                          O2s[x],
+					                                          fermionicSigns[x],
+					                                          threadId);
+				continue;
+			}
+
+			for (SizeType x=0;x<ops;x++) {
+				skeleton_.dmrgMultiply(O2g,O1g[x],O2s[x],fermionicSigns[x],ns,threadId);
+				ws[x](i,j) = skeleton_.bracket(O2g,fermionicSigns[x],threadId);
+			}
+		}
+	}
+
 private:
 
+	// Sums over the ranks the rows that each computed
+	void gatherRows(VectorMatrixType& ws, const VectorSizeType& rowList) const
+	{
+		// all matrices have the size of ws[0]; one reduction for all of them
+		SizeType rows = ws[0].n_row();
+		SizeType cols = ws[0].n_col();
+		SizeType area = rows*cols;
+		typename PsimagLite::Vector<FieldType>::Type v(ws.size()*area,0.0);
+		for (SizeType x=0;x<ws.size();x++) {
+			assert(ws[x].n_row() == rows && ws[x].n_col() == cols);
+			for (SizeType k=0;k<rowList.size();k++) {
+				SizeType i = rowList[k];
+				for (SizeType j=0;j<cols;j++)
+					v[i + j*rows + x*area] = ws[x](i,j);
+			}
+		}
+
+		PsimagLite::MPI::allReduce(v);
+
+		for (SizeType x=0;x<ws.size();x++)
+			for (SizeType i=0;i<rows;i++)
+				for (SizeType j=0;j<cols;j++)
+					ws[x](i,j) = v[i + j*rows + x*area];
+	}
+
 	SparseMatrixType add(const SparseMatrixType& O1,const SparseMatrixType& O2)
 	{
 		SizeType n=O1.n_row();
@@ -269,6 +411,7 @@ private:
 
 	ObserverHelperType& helper_;
 	CorrelationsSkeletonType& skeleton_;
+	bool distributed_;
 	bool verbose_;
 };  //class TwoPointCorrelations
 } // namespace Dmrg
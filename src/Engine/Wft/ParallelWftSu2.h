@@ -138,7 +138,7 @@ public:
 			       dmrgWaveStruct_.ws.rows());
 			assert(lrs_.right().permutationInverse().size()/volumeOf(nk)==
 			       dmrgWaveStruct_.we.cols());
-			pack1_ = new PackIndicesType(lrs.super().permutationInverse().size()/
+			pack1_ = new PackIndicesType(lrs.super().size()/
 			                             lrs.right().permutationInverse().size());
 			pack2_ = new PackIndicesType(volumeOf(nk));
 		}
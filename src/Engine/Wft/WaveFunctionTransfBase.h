@@ -81,6 +81,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #define WFT_BASE_H
 #include "ProgramGlobals.h"
 #include "PackIndices.h"
+#include <cassert>
 
 namespace Dmrg {
 
@@ -97,7 +98,7 @@ public:
 		typedef typename DmrgWaveStructType::SparseElementType ComplexOrRealType;
 		typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
 
-		enum AccelEnum {ACCEL_NONE, ACCEL_TEMP, ACCEL_PATCHES, ACCEL_BLOCKS};
+		enum AccelEnum {ACCEL_NONE, ACCEL_TEMP, ACCEL_PATCHES, ACCEL_BLOCKS, ACCEL_SPARSE};
 
 		WftOptions(ProgramGlobals::DirectionEnum dir1,
 		           PsimagLite::String options,
@@ -126,6 +127,11 @@ public:
 				accelMustBeNone(1);
 				accel = ACCEL_BLOCKS;
 			}
+
+			if (options.find("wftSparseTwoSite")!=PsimagLite::String::npos) {
+				accelMustBeNone(1);
+				accel = ACCEL_SPARSE;
+			}
 		}
 
 		ProgramGlobals::DirectionEnum dir;
@@ -155,12 +161,29 @@ public:
 	typedef typename DmrgWaveStructType::BasisWithOperatorsType BasisWithOperatorsType;
 	typedef typename BasisWithOperatorsType::BasisType BasisType;
 	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef typename PsimagLite::Vector<VectorWithOffsetType>::Type
+	VectorVectorWithOffsetType;
 
 	virtual void transformVector(VectorWithOffsetType& psiDest,
 	                             const VectorWithOffsetType& psiSrc,
 	                             const LeftRightSuperType& lrs,
 	                             const VectorSizeType& nk) const = 0;
 
+	// Transforms psiSrc[i] into psiDest[i] for all i;
+	// entries with an empty source or destination are skipped.
+	// Implementations may override this to share work among vectors
+	virtual void transformVectors(VectorVectorWithOffsetType& psiDest,
+	                              const VectorVectorWithOffsetType& psiSrc,
+	                              const LeftRightSuperType& lrs,
+	                              const VectorSizeType& nk) const
+	{
+		assert(psiDest.size() == psiSrc.size());
+		for (SizeType i = 0; i < psiSrc.size(); ++i) {
+			if (psiDest[i].size() == 0 || psiSrc[i].size() == 0) continue;
+			transformVector(psiDest[i], psiSrc[i], lrs, nk);
+		}
+	}
+
 	virtual ~WaveFunctionTransfBase() {}
 
 protected:
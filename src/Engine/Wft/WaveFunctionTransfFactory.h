@@ -89,6 +89,8 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "IoSimple.h"
 #include "Random48.h"
 #include "BaseStack.h"
+#include "RecoveryJournal.h"
+#include <unistd.h>
 
 namespace Dmrg {
 template<typename LeftRightSuperType,typename VectorWithOffsetType_>
@@ -110,6 +112,8 @@ public:
 	typedef typename BasisType::FactorsType FactorsType;
 	typedef DmrgWaveStruct<LeftRightSuperType> DmrgWaveStructType;
 	typedef VectorWithOffsetType_ VectorWithOffsetType;
+	typedef typename PsimagLite::Vector<VectorWithOffsetType>::Type
+	VectorVectorWithOffsetType;
 	typedef WaveFunctionTransfBase<DmrgWaveStructType,VectorWithOffsetType>
 	WaveFunctionTransfBaseType;
 	typedef WaveFunctionTransfLocal<DmrgWaveStructType,VectorWithOffsetType>
@@ -118,6 +122,7 @@ public:
 	WaveFunctionTransfSu2Type;
 	typedef typename WaveFunctionTransfBaseType::WftOptions WftOptionsType;
 	typedef BaseStack<BlockDiagonalMatrixType> WftStackType;
+	typedef RecoveryJournal<BlockDiagonalMatrixType> RecoveryJournalType;
 
 	template<typename SomeParametersType>
 	WaveFunctionTransfFactory(SomeParametersType& params)
@@ -131,15 +136,31 @@ public:
 	      filenameIn_(params.checkpoint.filename),
 	      filenameOut_(params.filename),
 	      WFT_STRING(ProgramGlobals::WFT_STRING),
-	      wsStack_(params.options.find("wftStacksInDisk")!=PsimagLite::String::npos),
-	      weStack_(params.options.find("wftStacksInDisk")!=PsimagLite::String::npos),
+	      wsStack_(params.options.find("wftStacksInDisk")!=PsimagLite::String::npos,
+	               params.options.find("binaryStacks")!=PsimagLite::String::npos,
+	               params.options.find("compressedStacks")!=PsimagLite::String::npos),
+	      weStack_(params.options.find("wftStacksInDisk")!=PsimagLite::String::npos,
+	               params.options.find("binaryStacks")!=PsimagLite::String::npos,
+	               params.options.find("compressedStacks")!=PsimagLite::String::npos),
 	      wftImpl_(0),
 	      rng_(3433117),
 	      noLoad_(false),
-	      save_(params.options.find("noSaveWft") == PsimagLite::String::npos)
+	      save_(params.options.find("noSaveWft") == PsimagLite::String::npos),
+	      wsJournal_(0),
+	      weJournal_(0),
+	      recoveryNoDelete_(params.options.find("recoveryNoDelete") != PsimagLite::String::npos)
 	{
+		wsStack_.setAsync(params.diskStackPrefetch, params.diskStackWriteBudget*1024*1024);
+		weStack_.setAsync(params.diskStackPrefetch, params.diskStackWriteBudget*1024*1024);
+
 		if (!isEnabled_) return;
 
+		if (save_ && params.recoverySave != "0" &&
+		        params.options.find("incrementalRecovery") != PsimagLite::String::npos)
+			createJournals(params.filename,
+			               params.options.find("compressedStacks") != PsimagLite::String::npos,
+			               params.diskStackWriteBudget*1024*1024);
+
 		bool b = (params.options.find("checkpoint")!=PsimagLite::String::npos ||
 		        params.options.find("restart")!=PsimagLite::String::npos);
 
@@ -169,6 +190,7 @@ public:
 		if (!isEnabled_) return;
 		save(filenameOut_);
 		delete wftImpl_;
+		deleteJournals();
 	}
 
 	void setStage(ProgramGlobals::DirectionEnum stage)
@@ -209,24 +231,7 @@ public:
 	                      const LeftRightSuperType& lrs,
 	                      const VectorSizeType& nk) const
 	{
-		bool allow=false;
-		switch (wftOptions_.dir) {
-		case ProgramGlobals::INFINITE:
-			allow=false;
-			break;
-		case ProgramGlobals::EXPAND_SYSTEM:
-			allow=true;
-
-		case ProgramGlobals::EXPAND_ENVIRON:
-			allow=true;
-		}
-
-		// FIXME: Must check the below change when using SU(2)!!
-		//if (m<0) allow = false; // isEnabled_=false;
-
-		if (noLoad_) allow = false;
-
-		if (isEnabled_ && allow) {
+		if (transformAllowed()) {
 #ifndef NDEBUG
 			RealType eps = 1e-12;
 			RealType x = norm(src);
@@ -240,6 +245,29 @@ public:
 		}
 	}
 
+	// Like setInitialVector, but for all dest[i] and src[i] at once,
+	// so that the implementation can share work among vectors.
+	// Entries with an empty dest[i] are skipped
+	void setInitialVectors(VectorVectorWithOffsetType& dest,
+	                       const VectorVectorWithOffsetType& src,
+	                       const LeftRightSuperType& lrs,
+	                       const VectorSizeType& nk) const
+	{
+		assert(dest.size() == src.size());
+		if (!transformAllowed()) {
+			for (SizeType i = 0; i < dest.size(); ++i)
+				if (dest[i].size() > 0) createRandomVector(dest[i]);
+			return;
+		}
+
+		wftImpl_->transformVectors(dest, src, lrs, nk);
+
+		for (SizeType i = 0; i < dest.size(); ++i) {
+			if (dest[i].size() == 0 || src[i].size() == 0) continue;
+			checkNorms(dest[i], src[i]);
+		}
+	}
+
 	void triggerOff(const LeftRightSuperType& lrs)
 	{
 		bool allow=false;
@@ -305,10 +333,10 @@ public:
 		switch (wftOptions_.dir) {
 		case ProgramGlobals::INFINITE:
 			if (direction == ProgramGlobals::EXPAND_SYSTEM) {
-				wsStack_.push(transform);
+				pushTransform(wsStack_, wsJournal_, transform);
 				dmrgWaveStruct_.ws=transform;
 			} else {
-				weStack_.push(transform);
+				pushTransform(weStack_, weJournal_, transform);
 				dmrgWaveStruct_.we=transform;
 			}
 			break;
@@ -317,14 +345,14 @@ public:
 				throw std::logic_error("EXPAND_ENVIRON but option==0\n");
 			dmrgWaveStruct_.we=transform;
 			dmrgWaveStruct_.ws=transform;
-			weStack_.push(transform);
+			pushTransform(weStack_, weJournal_, transform);
 			break;
 		case ProgramGlobals::EXPAND_SYSTEM:
 			if (direction != ProgramGlobals::EXPAND_SYSTEM)
 				throw std::logic_error("EXPAND_SYSTEM but option==1\n");
 			dmrgWaveStruct_.ws=transform;
 			dmrgWaveStruct_.we=transform;
-			wsStack_.push(transform);
+			pushTransform(wsStack_, wsJournal_, transform);
 			break;
 		}
 
@@ -359,11 +387,21 @@ public:
 
 	bool isEnabled() const { return isEnabled_; }
 
+	// Adds the compression statistics of the WFT stacks since the last call
+	void takeStackStats(DiskStackCompression::Stats& stats) const
+	{
+		wsStack_.takeStats(stats);
+		weStack_.takeStats(stats);
+	}
+
 	const WftOptionsType options() const { return wftOptions_; }
 
 	void appendFileList(VectorStringType& files, PsimagLite::String rootName) const
 	{
 		files.push_back(utils::pathPrepend(WFT_STRING,rootName));
+		if (!wsJournal_) return;
+		files.push_back(utils::pathPrepend(WFT_STRING + "WsIndex", rootName));
+		files.push_back(utils::pathPrepend(WFT_STRING + "WeIndex", rootName));
 	}
 
 	void save(PsimagLite::String fileOut) const
@@ -372,6 +410,39 @@ public:
 
 		typename IoType::Out io(utils::pathPrepend(WFT_STRING, fileOut));
 		if (!save_) return;
+		saveHeader(io);
+		wsStack_.save(io, "wsStack\n");
+		weStack_.save(io, "weStack\n");
+	}
+
+	// Like save, but with incrementalRecovery the stacks are index files
+	// of their journals, see RecoveryJournal.h, written before this returns
+	void saveForRecovery(PsimagLite::String rootName) const
+	{
+		if (!wsJournal_) {
+			save(rootName);
+			return;
+		}
+
+		if (!isEnabled_) return;
+
+		PsimagLite::String wsIndex = utils::pathPrepend(WFT_STRING + "WsIndex", rootName);
+		PsimagLite::String weIndex = utils::pathPrepend(WFT_STRING + "WeIndex", rootName);
+		wsJournal_->saveIndex(wsIndex);
+		weJournal_->saveIndex(weIndex);
+		wsJournal_->flush();
+		weJournal_->flush();
+
+		typename IoType::Out io(utils::pathPrepend(WFT_STRING, rootName));
+		saveHeader(io);
+		io.printline("wsStackIndex=" + wsIndex);
+		io.printline("weStackIndex=" + weIndex);
+	}
+
+private:
+
+	void saveHeader(typename IoType::Out& io) const
+	{
 		PsimagLite::String s="isEnabled="+ttos(isEnabled_);
 		io.printline(s);
 		s="stage="+ttos(wftOptions_.dir);
@@ -381,12 +452,8 @@ public:
 		io.printline("dmrgWaveStruct");
 
 		dmrgWaveStruct_.save(io);
-		wsStack_.save(io, "wsStack\n");
-		weStack_.save(io, "weStack\n");
 	}
 
-private:
-
 	void load()
 	{
 		if (!isEnabled_)
@@ -399,8 +466,87 @@ private:
 		wftOptions_.firstCall = false;
 		io.advance("dmrgWaveStruct");
 		dmrgWaveStruct_.load(io);
-		wsStack_.load(io,"wsStack");
-		weStack_.load(io,"weStack");
+
+		// saveForRecovery writes wsStackIndex= where save writes wsStack
+		PsimagLite::String temp;
+		while (!io.eof()) {
+			io>>temp;
+			if (temp.substr(0, 7) == "wsStack") break;
+		}
+
+		PsimagLite::String label = "wsStackIndex=";
+		if (temp.substr(0, label.size()) != label) {
+			io.move(-static_cast<int>(temp.size()));
+			wsStack_.load(io,"wsStack");
+			weStack_.load(io,"weStack");
+			pushAll(wsJournal_, wsStack_);
+			pushAll(weJournal_, weStack_);
+			return;
+		}
+
+		PsimagLite::String wsIndex = temp.substr(label.size(), temp.size());
+		PsimagLite::String weIndex;
+		io.readline(weIndex,"weStackIndex=");
+		RecoveryJournalType::load(wsStack_, wsIndex, wsJournal_, false);
+		RecoveryJournalType::load(weStack_, weIndex, weJournal_, false);
+	}
+
+	void createJournals(const PsimagLite::String& filename, bool compressed, SizeType budget)
+	{
+		PsimagLite::String root = utils::pathPrepend("RecoveryJournal", filename);
+		wsJournal_ = new RecoveryJournalType(utils::pathPrepend(WFT_STRING + "Ws", root),
+		                                     compressed);
+		weJournal_ = new RecoveryJournalType(utils::pathPrepend(WFT_STRING + "We", root),
+		                                     compressed);
+		wsJournal_->startThread(budget);
+		weJournal_->startThread(budget);
+	}
+
+	void deleteJournals()
+	{
+		if (!wsJournal_) return;
+
+		VectorStringType files;
+		wsJournal_->appendFiles(files);
+		weJournal_->appendFiles(files);
+		delete wsJournal_;
+		wsJournal_ = 0;
+		delete weJournal_;
+		weJournal_ = 0;
+
+		if (recoveryNoDelete_) return;
+
+		for (SizeType i = 0; i < files.size(); ++i)
+			unlink(files[i].c_str());
+	}
+
+	static void pushTransform(WftStackType& stack,
+	                          RecoveryJournalType* journal,
+	                          const BlockDiagonalMatrixType& transform)
+	{
+		stack.push(transform);
+		if (journal) journal->push(transform);
+	}
+
+	static void popTransform(WftStackType& stack, RecoveryJournalType* journal)
+	{
+		stack.pop();
+		if (journal) journal->pop();
+	}
+
+	// the journal needs the entries of a stack loaded by load()
+	static void pushAll(RecoveryJournalType* journal, const WftStackType& stack)
+	{
+		if (!journal) return;
+		WftStackType copy(stack);
+		typename PsimagLite::Vector<BlockDiagonalMatrixType>::Type topToBottom;
+		while (copy.size() > 0) {
+			topToBottom.push_back(copy.top());
+			copy.pop();
+		}
+
+		for (SizeType i = topToBottom.size(); i > 0; --i)
+			journal->push(topToBottom[i - 1]);
 	}
 
 	void myRandomT(std::complex<RealType> &value) const
@@ -418,7 +564,7 @@ private:
 		if (wftOptions_.dir == ProgramGlobals::EXPAND_ENVIRON) {
 			if (wsStack_.size()>=1) {
 				dmrgWaveStruct_.ws=wsStack_.top();
-				wsStack_.pop();
+				popTransform(wsStack_, wsJournal_);
 				if (wftOptions_.twoSiteDmrg && wsStack_.size()>0)
 					dmrgWaveStruct_.ws=wsStack_.top();
 			} else {
@@ -429,7 +575,7 @@ private:
 		if (wftOptions_.dir == ProgramGlobals::EXPAND_SYSTEM) {
 			if (weStack_.size()>=1) {
 				dmrgWaveStruct_.we=weStack_.top();
-				weStack_.pop();
+				popTransform(weStack_, weJournal_);
 				if (wftOptions_.twoSiteDmrg && weStack_.size()>0)
 					dmrgWaveStruct_.we=weStack_.top();
 			} else {
@@ -455,7 +601,12 @@ private:
 	                  const VectorSizeType& nk) const
 	{
 		wftImpl_->transformVector(psiDest, psiSrc, lrs, nk);
+		checkNorms(psiDest, psiSrc);
+	}
 
+	void checkNorms(const VectorWithOffsetType& psiDest,
+	                const VectorWithOffsetType& psiSrc) const
+	{
 		RealType norm1 = norm(psiSrc);
 		RealType norm2 = norm(psiDest);
 		PsimagLite::OstringStream msg;
@@ -470,6 +621,28 @@ private:
 		progress_.printline(msg,std::cout);
 	}
 
+	bool transformAllowed() const
+	{
+		bool allow=false;
+		switch (wftOptions_.dir) {
+		case ProgramGlobals::INFINITE:
+			allow=false;
+			break;
+		case ProgramGlobals::EXPAND_SYSTEM:
+			allow=true;
+
+		case ProgramGlobals::EXPAND_ENVIRON:
+			allow=true;
+		}
+
+		// FIXME: Must check the below change when using SU(2)!!
+		//if (m<0) allow = false; // isEnabled_=false;
+
+		if (noLoad_) allow = false;
+
+		return (isEnabled_ && allow);
+	}
+
 	void afterWft(const LeftRightSuperType& lrs)
 	{
 		dmrgWaveStruct_.lrs = lrs;
@@ -538,6 +711,9 @@ private:
 	bool noLoad_;
 	bool save_;
 	VectorSizeType sitesSeen_;
+	RecoveryJournalType* wsJournal_;
+	RecoveryJournalType* weJournal_;
+	bool recoveryNoDelete_;
 }; // class WaveFunctionTransformation
 } // namespace Dmrg
 
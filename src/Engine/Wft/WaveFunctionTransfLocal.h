@@ -92,6 +92,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "WftAccelBlocks.h"
 #include "WftAccelWithTemp.h"
 #include "WftSparseTwoSite.h"
+#include "WftSectorGemm.h"
 
 namespace Dmrg {
 
@@ -103,6 +104,7 @@ class WaveFunctionTransfLocal : public
 	typedef WaveFunctionTransfBase<DmrgWaveStructType,VectorWithOffsetType> BaseType;
 	typedef typename BaseType::VectorSizeType VectorSizeType;
 	typedef typename BaseType::PackIndicesType PackIndicesType;
+	typedef typename BaseType::VectorVectorWithOffsetType VectorVectorWithOffsetType;
 
 public:
 
@@ -124,6 +126,7 @@ public:
 	typedef WftAccelBlocks<BaseType> WftAccelBlocksType;
 	typedef WftAccelWithTemp<BaseType, MatrixOrIdentityType> WftAccelWithTempType;
 	typedef WftSparseTwoSite<BaseType, MatrixOrIdentityType> WftSparseTwoSiteType;
+	typedef WftSectorGemm<BaseType> WftSectorGemmType;
 
 	WaveFunctionTransfLocal(const DmrgWaveStructType& dmrgWaveStruct,
 	                        const WftOptions& wftOptions)
@@ -170,8 +173,115 @@ public:
 		err("WFT Local: Stage is not EXPAND_ENVIRON or EXPAND_SYSTEM\n");
 	}
 
+	virtual void transformVectors(VectorVectorWithOffsetType& psiDest,
+	                              const VectorVectorWithOffsetType& psiSrc,
+	                              const LeftRightSuperType& lrs,
+	                              const VectorSizeType& nk) const
+	{
+		if (canTransformInBlocks(lrs)) {
+			PsimagLite::OstringStream msg;
+			msg<<"Transforming "<<psiSrc.size()<<" vectors in blocks";
+			progress_.printline(msg,std::cout);
+
+			if (wftOptions_.dir == ProgramGlobals::EXPAND_ENVIRON)
+				return wftAccelBlocks_.environFromInfinite(psiDest, psiSrc, lrs, nk);
+
+			return wftAccelBlocks_.systemFromInfinite(psiDest, psiSrc, lrs, nk);
+		}
+
+		if (transformVectorsSectorGemm(psiDest, psiSrc, lrs, nk)) return;
+
+		BaseType::transformVectors(psiDest, psiSrc, lrs, nk);
+	}
+
 private:
 
+	// True if transformVector would use transformVector1FromInfinite
+	// or transformVector2FromInfinite
+	bool isFromInfinite() const
+	{
+		if (wftOptions_.firstCall) return true;
+		if (wftOptions_.counter == 0) return false;
+		return (wftOptions_.twoSiteDmrg && wftOptions_.accel != WftOptions::ACCEL_PATCHES);
+	}
+
+	// True if transformVector would only use WftAccelBlocks,
+	// so that all vectors can be done together
+	bool canTransformInBlocks(const LeftRightSuperType& lrs) const
+	{
+		if (!wftOptions_.twoSiteDmrg) return false;
+		if (wftOptions_.accel != WftOptions::ACCEL_BLOCKS) return false;
+		if (!isFromInfinite()) return false;
+
+		if (wftOptions_.dir == ProgramGlobals::EXPAND_ENVIRON)
+			return (lrs.left().block().size() > 1);
+
+		if (wftOptions_.dir == ProgramGlobals::EXPAND_SYSTEM)
+			return (lrs.right().block().size() > 1);
+
+		return false;
+	}
+
+	// All vectors with one WftSectorGemm, so that the blocks of ws and we
+	// are made dense once; false, with nothing done, if transformVector
+	// would not use WftSectorGemm
+	bool transformVectorsSectorGemm(VectorVectorWithOffsetType& psiDest,
+	                                const VectorVectorWithOffsetType& psiSrc,
+	                                const LeftRightSuperType& lrs,
+	                                const VectorSizeType& nk) const
+	{
+		if (!isFromInfinite()) return false;
+
+		bool isEnviron = (wftOptions_.dir == ProgramGlobals::EXPAND_ENVIRON);
+		if (!isEnviron && wftOptions_.dir != ProgramGlobals::EXPAND_SYSTEM)
+			return false;
+
+		SizeType blockSize = (isEnviron) ? lrs.left().block().size()
+		                                 : lrs.right().block().size();
+		if (!useSectorGemm(blockSize)) return false;
+
+		WftSectorGemmType sectorGemm(dmrgWaveStruct_,
+		                             lrs,
+		                             nk,
+		                             (isEnviron) ? ProgramGlobals::ENVIRON
+		                                         : ProgramGlobals::SYSTEM);
+		if (!sectorGemm.isValid()) return false;
+
+		assert(psiDest.size() == psiSrc.size());
+		for (SizeType i = 0; i < psiSrc.size(); ++i) {
+			if (psiDest[i].size() == 0 || psiSrc[i].size() == 0) continue;
+			if (isEnviron)
+				sectorGemmEnviron(psiDest[i], psiSrc[i], sectorGemm);
+			else
+				sectorGemmSystem(psiDest[i], psiSrc[i], sectorGemm);
+		}
+
+		return true;
+	}
+
+	void sectorGemmEnviron(VectorWithOffsetType& psiDest,
+	                       const VectorWithOffsetType& psiSrc,
+	                       WftSectorGemmType& sectorGemm) const
+	{
+		for (SizeType ii=0;ii<psiSrc.sectors();ii++) {
+			SizeType iOld = psiSrc.sector(ii);
+			SizeType iNew = findIold(psiDest, psiSrc.qn(ii));
+			sectorGemm.transform(psiSrc, iOld);
+			sectorGemm.copyOut(psiDest, iNew);
+		}
+	}
+
+	void sectorGemmSystem(VectorWithOffsetType& psiDest,
+	                      const VectorWithOffsetType& psiSrc,
+	                      WftSectorGemmType& sectorGemm) const
+	{
+		for (SizeType srcI = 0; srcI < psiSrc.sectors(); ++srcI) {
+			sectorGemm.transform(psiSrc, psiSrc.sector(srcI));
+			for (SizeType ii=0;ii<psiDest.sectors();ii++)
+				sectorGemm.copyOut(psiDest, psiDest.sector(ii));
+		}
+	}
+
 	void transformVector1(VectorWithOffsetType& psiDest,
 	                      const VectorWithOffsetType& psiSrc,
 	                      const LeftRightSuperType& lrs,
@@ -239,6 +349,12 @@ private:
 	                                  const LeftRightSuperType& lrs,
 	                                  const VectorSizeType& nk) const
 	{
+		if (useSectorGemm(lrs.left().block().size())) {
+			WftSectorGemmType sectorGemm(dmrgWaveStruct_, lrs, nk, ProgramGlobals::ENVIRON);
+			if (sectorGemm.isValid())
+				return sectorGemmEnviron(psiDest, psiSrc, sectorGemm);
+		}
+
 		for (SizeType ii=0;ii<psiSrc.sectors();ii++) {
 			SizeType iOld = psiSrc.sector(ii);
 			SizeType qn = psiSrc.qn(ii);
@@ -314,7 +430,14 @@ private:
 		msg<<" Destination sectors "<<psiDest.sectors();
 		msg<<" Source sectors "<<psiSrc.sectors();
 		progress_.printline(msg,std::cout);
-		assert(dmrgWaveStruct_.lrs.super().permutationInverse().size()==psiSrc.size());
+		assert(dmrgWaveStruct_.lrs.super().size()==psiSrc.size());
+
+		if (useSectorGemm(lrs.right().block().size())) {
+			WftSectorGemmType sectorGemm(dmrgWaveStruct_, lrs, nk, ProgramGlobals::SYSTEM);
+			if (sectorGemm.isValid())
+				return sectorGemmSystem(psiDest, psiSrc, sectorGemm);
+		}
+
 		bool inBlocks = (lrs.right().block().size() > 1 &&
 		                 wftOptions_.accel == WftOptions::ACCEL_BLOCKS);
 		SparseMatrixType we;
@@ -396,13 +519,13 @@ private:
 	                    const MatrixOrIdentityType& wsRef) const
 	{
 		SizeType volumeOfNk = DmrgWaveStructType::volumeOf(nk);
-		SizeType nip = lrs.super().permutationInverse().size()/
+		SizeType nip = lrs.super().size()/
 		        lrs.right().permutationInverse().size();
 		PsimagLite::OstringStream msg;
 		msg<<" We're bouncing on the right, so buckle up!";
 		progress_.printline(msg,std::cout);
 
-		assert(dmrgWaveStruct_.lrs.super().permutationInverse().size()==psiSrc.size());
+		assert(dmrgWaveStruct_.lrs.super().size()==psiSrc.size());
 
 		SizeType start = psiDest.offset(i0);
 		SizeType total = psiDest.effectiveSize(i0);
@@ -457,7 +580,7 @@ private:
 		msg<<" We're bouncing on the left, so buckle up!";
 		progress_.printline(msg,std::cout);
 
-		assert(dmrgWaveStruct_.lrs.super().permutationInverse().size()==psiSrc.size());
+		assert(dmrgWaveStruct_.lrs.super().size()==psiSrc.size());
 
 		SizeType start = psiDest.offset(i0);
 		SizeType total = psiDest.effectiveSize(i0);
@@ -484,6 +607,16 @@ private:
 		}
 	}
 
+	// Sector-blocked GEMMs replace WftSparseTwoSite in the two-site path,
+	// unless another accel was requested or wftSparseTwoSite is set
+	bool useSectorGemm(SizeType blockSize) const
+	{
+		if (!wftOptions_.twoSiteDmrg) return false;
+		if (wftOptions_.accel == WftOptions::ACCEL_TEMP) return false;
+		if (wftOptions_.accel == WftOptions::ACCEL_SPARSE) return false;
+		return (wftOptions_.accel != WftOptions::ACCEL_BLOCKS || blockSize < 2);
+	}
+
 	SizeType findIold(const VectorWithOffsetType& psiSrc,
 	                  SizeType qn) const
 	{
@@ -242,7 +242,7 @@ private:
 	                                  const SparseMatrixType& weT) const
 	{
 		SizeType volumeOfNk = ParallelWftType::volumeOf(nk);
-		SizeType nip = lrs.super().permutationInverse().size()/
+		SizeType nip = lrs.super().size()/
 		        lrs.right().permutationInverse().size();
 
 		assert(lrs.left().permutationInverse().size()==volumeOfNk ||
@@ -329,7 +329,7 @@ private:
 		msg<<" Source sectors "<<psiSrc.sectors();
 		progress_.printline(msg,std::cout);
 		const LeftRightSuperType& lrsOld = dmrgWaveStruct_.lrs;
-		assert(lrsOld.super().permutationInverse().size() == psiSrc.size());
+		assert(lrsOld.super().size() == psiSrc.size());
 
 		SparseMatrixType we;
 		dmrgWaveStruct_.we.toSparse(we);
@@ -471,10 +471,10 @@ private:
 	                            const SparseMatrixType& ws) const
 	{
 		SizeType volumeOfNk = ParallelWftType::volumeOf(nk);
-		SizeType nip = lrs.super().permutationInverse().size()/
+		SizeType nip = lrs.super().size()/
 		        lrs.right().permutationInverse().size();
 
-		assert(dmrgWaveStruct_.lrs.super().permutationInverse().size()==psiSrc.size());
+		assert(dmrgWaveStruct_.lrs.super().size()==psiSrc.size());
 
 		SizeType start = psiDest.offset(i0);
 		SizeType total = psiDest.effectiveSize(i0);
@@ -568,7 +568,7 @@ private:
 		SizeType nip = lrs.left().permutationInverse().size()/volumeOfNk;
 		SizeType nalpha = lrs.left().permutationInverse().size();
 
-		assert(dmrgWaveStruct_.lrs.super().permutationInverse().size()==psiSrc.size());
+		assert(dmrgWaveStruct_.lrs.super().size()==psiSrc.size());
 
 		const FactorsType& factorsS = lrs.left().getFactors();
 		const FactorsType& factorsSE = lrs.super().getFactors();
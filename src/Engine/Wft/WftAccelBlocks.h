@@ -3,6 +3,7 @@
 #include "Matrix.h"
 #include "BLAS.h"
 #include "ProgramGlobals.h"
+#include <algorithm>
 
 namespace Dmrg {
 
@@ -13,6 +14,8 @@ class WftAccelBlocks {
 	typedef typename WaveFunctionTransfBaseType::WftOptions WftOptionsType;
 	typedef typename WaveFunctionTransfBaseType::VectorWithOffsetType VectorWithOffsetType;
 	typedef typename WaveFunctionTransfBaseType::VectorSizeType VectorSizeType;
+	typedef typename WaveFunctionTransfBaseType::VectorVectorWithOffsetType
+	VectorVectorWithOffsetType;
 	typedef typename DmrgWaveStructType::LeftRightSuperType LeftRightSuperType;
 	typedef typename VectorWithOffsetType::VectorType VectorType;
 	typedef typename VectorType::value_type ComplexOrRealType;
@@ -22,6 +25,8 @@ class WftAccelBlocks {
 	typedef typename PsimagLite::Vector<MatrixType>::Type VectorMatrixType;
 	typedef typename WaveFunctionTransfBaseType::PackIndicesType PackIndicesType;
 
+	// Each psi_[kp] holds the vectors to transform stacked as column blocks,
+	// so that the product with ws is a single GEMM for all of them
 	class ParallelWftInBlocks {
 
 	public:
@@ -31,13 +36,15 @@ class WftAccelBlocks {
 		                    const MatrixType& ws,
 		                    const MatrixType& we,
 		                    SizeType volumeOfNk,
-		                    SizeType sysOrEnv)
+		                    SizeType sysOrEnv,
+		                    SizeType vectors = 1)
 		    : result_(result),
 		      psi_(psi),
 		      ws_(ws),
 		      we_(we),
 		      volumeOfNk_(volumeOfNk),
-		      sysOrEnv_(sysOrEnv)
+		      sysOrEnv_(sysOrEnv),
+		      vectors_(vectors)
 		{}
 
 		SizeType tasks() const { return volumeOfNk_; }
@@ -58,30 +65,32 @@ class WftAccelBlocks {
 			SizeType i2psize = ws_.cols();
 			SizeType jp2size = we_.rows();
 			SizeType jpsize = we_.cols();
-			MatrixType tmp(i2psize, jpsize);
+			MatrixType tmp(i2psize, jpsize*vectors_);
 
-			result_[kp].resize(ipsize, jpsize);
+			result_[kp].resize(ipsize, jpsize*vectors_);
 			result_[kp].setTo(0.0);
 			tmp.setTo(0.0);
 
-			psimag::BLAS::GEMM('N',
-			                   'N',
-			                   i2psize,
-			                   jpsize,
-			                   jp2size,
-			                   1.0,
-			                   &((psi_[kp])(0,0)),
-			                   i2psize,
-			                   &(we_(0,0)),
-			                   jp2size,
-			                   0.0,
-			                   &(tmp(0,0)),
-			                   i2psize);
+			for (SizeType v = 0; v < vectors_; ++v) {
+				psimag::BLAS::GEMM('N',
+				                   'N',
+				                   i2psize,
+				                   jpsize,
+				                   jp2size,
+				                   1.0,
+				                   &((psi_[kp])(0,v*jp2size)),
+				                   i2psize,
+				                   &(we_(0,0)),
+				                   jp2size,
+				                   0.0,
+				                   &(tmp(0,v*jpsize)),
+				                   i2psize);
+			}
 
 			psimag::BLAS::GEMM('N',
 			                   'N',
 			                   ipsize,
-			                   jpsize,
+			                   jpsize*vectors_,
 			                   i2psize,
 			                   1.0,
 			                   &(ws_(0,0)),
@@ -99,30 +108,32 @@ class WftAccelBlocks {
 			SizeType isSize = ws_.cols();
 			SizeType jenSize = we_.rows();
 			SizeType jprSize = we_.cols();
-			MatrixType tmp(ipSize, jenSize);
+			MatrixType tmp(ipSize, jenSize*vectors_);
 
-			result_[kp].resize(isSize, jenSize);
+			result_[kp].resize(isSize, jenSize*vectors_);
 			result_[kp].setTo(0.0);
 			tmp.setTo(0.0);
 
-			psimag::BLAS::GEMM('N',
-			                   'C',
-			                   ipSize,
-			                   jenSize,
-			                   jprSize,
-			                   1.0,
-			                   &((psi_[kp])(0,0)),
-			                   ipSize,
-			                   &(we_(0,0)),
-			                   jenSize,
-			                   0.0,
-			                   &(tmp(0,0)),
-			                   ipSize);
+			for (SizeType v = 0; v < vectors_; ++v) {
+				psimag::BLAS::GEMM('N',
+				                   'C',
+				                   ipSize,
+				                   jenSize,
+				                   jprSize,
+				                   1.0,
+				                   &((psi_[kp])(0,v*jprSize)),
+				                   ipSize,
+				                   &(we_(0,0)),
+				                   jenSize,
+				                   0.0,
+				                   &(tmp(0,v*jenSize)),
+				                   ipSize);
+			}
 
 			psimag::BLAS::GEMM('C',
 			                   'N',
 			                   isSize,
-			                   jenSize,
+			                   jenSize*vectors_,
 			                   ipSize,
 			                   1.0,
 			                   &(ws_(0,0)),
@@ -140,6 +151,7 @@ class WftAccelBlocks {
 		const MatrixType& we_;
 		SizeType volumeOfNk_;
 		SizeType sysOrEnv_;
+		SizeType vectors_;
 	};
 
 public:
@@ -231,12 +243,191 @@ public:
 		systemCopyOut(psiDest, i0, result, lrs, volumeOfNk);
 	}
 
+
+	// Transforms all non-empty psiDest[i] from psiSrc[i] at once:
+	// vectors sharing a source sector are stacked as column blocks
+	void environFromInfinite(VectorVectorWithOffsetType& psiDest,
+	                         const VectorVectorWithOffsetType& psiSrc,
+	                         const LeftRightSuperType& lrs,
+	                         const VectorSizeType& nk) const
+	{
+		if (lrs.left().block().size() < 2)
+			err("Bounce!?\n");
+
+		SizeType volumeOfNk = DmrgWaveStructType::volumeOf(nk);
+		MatrixType ws;
+		dmrgWaveStruct_.ws.toDense(ws);
+
+		MatrixType we;
+		dmrgWaveStruct_.we.toDense(we);
+
+		SizeType i2psize = ws.cols();
+		SizeType jp2size = we.rows();
+		SizeType jpsize = we.cols();
+
+		VectorSizeType qns;
+		findSourceQns(qns, psiDest, psiSrc);
+
+		for (SizeType iq = 0; iq < qns.size(); ++iq) {
+			VectorSizeType which;
+			VectorSizeType srcSectors;
+			findVectorsWithQn(which, srcSectors, psiDest, psiSrc, qns[iq]);
+			SizeType vectors = which.size();
+
+			VectorMatrixType psi(volumeOfNk);
+			for (SizeType kp = 0; kp < volumeOfNk; ++kp) {
+				psi[kp].resize(i2psize, jp2size*vectors);
+				psi[kp].setTo(0.0);
+			}
+
+			for (SizeType c = 0; c < vectors; ++c)
+				environPreparePsi(psi,
+				                  psiSrc[which[c]],
+				                  srcSectors[c],
+				                  volumeOfNk,
+				                  c*jp2size);
+
+			VectorMatrixType result(volumeOfNk);
+
+			SizeType threads = std::min(volumeOfNk, PsimagLite::Concurrency::npthreads);
+			typedef PsimagLite::Parallelizer<ParallelWftInBlocks> ParallelizerType;
+			ParallelizerType threadedWft(threads, PsimagLite::MPI::COMM_WORLD);
+
+			ParallelWftInBlocks helperWft(result,
+			                              psi,
+			                              ws,
+			                              we,
+			                              volumeOfNk,
+			                              ProgramGlobals::ENVIRON,
+			                              vectors);
+
+			threadedWft.loopCreate(helperWft);
+
+			for (SizeType c = 0; c < vectors; ++c) {
+				VectorWithOffsetType& dest = psiDest[which[c]];
+				SizeType i0 = findSector(dest, qns[iq]);
+				environCopyOut(dest, i0, result, lrs, volumeOfNk, c*jpsize);
+			}
+		}
+	}
+
+	// Same as above, but each source sector contributes to all
+	// destination sectors, as in the single vector version
+	void systemFromInfinite(VectorVectorWithOffsetType& psiDest,
+	                        const VectorVectorWithOffsetType& psiSrc,
+	                        const LeftRightSuperType& lrs,
+	                        const VectorSizeType& nk) const
+	{
+		if (lrs.right().block().size() < 2)
+			err("Bounce!?\n");
+
+		SizeType volumeOfNk = DmrgWaveStructType::volumeOf(nk);
+		MatrixType ws;
+		dmrgWaveStruct_.ws.toDense(ws);
+
+		MatrixType we;
+		dmrgWaveStruct_.we.toDense(we);
+
+		SizeType ipSize = ws.rows();
+		SizeType jprSize = we.cols();
+		SizeType jenSize = we.rows();
+
+		VectorSizeType qns;
+		findSourceQns(qns, psiDest, psiSrc);
+
+		for (SizeType iq = 0; iq < qns.size(); ++iq) {
+			VectorSizeType which;
+			VectorSizeType srcSectors;
+			findVectorsWithQn(which, srcSectors, psiDest, psiSrc, qns[iq]);
+			SizeType vectors = which.size();
+
+			VectorMatrixType psi(volumeOfNk);
+			for (SizeType kp = 0; kp < volumeOfNk; ++kp) {
+				psi[kp].resize(ipSize, jprSize*vectors);
+				psi[kp].setTo(0.0);
+			}
+
+			for (SizeType c = 0; c < vectors; ++c)
+				systemPreparePsi(psi,
+				                 psiSrc[which[c]],
+				                 srcSectors[c],
+				                 volumeOfNk,
+				                 c*jprSize);
+
+			VectorMatrixType result(volumeOfNk);
+
+			SizeType threads = std::min(volumeOfNk, PsimagLite::Concurrency::npthreads);
+			typedef PsimagLite::Parallelizer<ParallelWftInBlocks> ParallelizerType;
+			ParallelizerType threadedWft(threads, PsimagLite::MPI::COMM_WORLD);
+
+			ParallelWftInBlocks helperWft(result,
+			                              psi,
+			                              ws,
+			                              we,
+			                              volumeOfNk,
+			                              ProgramGlobals::SYSTEM,
+			                              vectors);
+
+			threadedWft.loopCreate(helperWft);
+
+			for (SizeType c = 0; c < vectors; ++c) {
+				VectorWithOffsetType& dest = psiDest[which[c]];
+				for (SizeType ii = 0; ii < dest.sectors(); ++ii)
+					systemCopyOut(dest, dest.sector(ii), result, lrs, volumeOfNk, c*jenSize);
+			}
+		}
+	}
+
 private:
 
+	void findSourceQns(VectorSizeType& qns,
+	                   const VectorVectorWithOffsetType& psiDest,
+	                   const VectorVectorWithOffsetType& psiSrc) const
+	{
+		assert(psiDest.size() == psiSrc.size());
+		for (SizeType i = 0; i < psiSrc.size(); ++i) {
+			if (psiDest[i].size() == 0 || psiSrc[i].size() == 0) continue;
+			for (SizeType ii = 0; ii < psiSrc[i].sectors(); ++ii) {
+				SizeType qn = psiSrc[i].qn(ii);
+				if (std::find(qns.begin(), qns.end(), qn) == qns.end())
+					qns.push_back(qn);
+			}
+		}
+	}
+
+	void findVectorsWithQn(VectorSizeType& which,
+	                       VectorSizeType& srcSectors,
+	                       const VectorVectorWithOffsetType& psiDest,
+	                       const VectorVectorWithOffsetType& psiSrc,
+	                       SizeType qn) const
+	{
+		for (SizeType i = 0; i < psiSrc.size(); ++i) {
+			if (psiDest[i].size() == 0 || psiSrc[i].size() == 0) continue;
+			for (SizeType ii = 0; ii < psiSrc[i].sectors(); ++ii) {
+				if (psiSrc[i].qn(ii) != qn) continue;
+				which.push_back(i);
+				srcSectors.push_back(psiSrc[i].sector(ii));
+				break;
+			}
+		}
+	}
+
+	SizeType findSector(const VectorWithOffsetType& psi, SizeType qn) const
+	{
+		SizeType sectors = psi.sectors();
+		for (SizeType i = 0; i < sectors; ++i)
+			if (psi.qn(i) == qn)
+				return psi.sector(i);
+
+		err("WftAccelBlocks::findSector(): Cannot find sector in new vector\n");
+		throw PsimagLite::RuntimeError("UNREACHABLE\n");
+	}
+
 	void environPreparePsi(VectorMatrixType& psi,
 	                       const VectorWithOffsetType& psiSrc,
 	                       SizeType i0src,
-	                       SizeType volumeOfNk) const
+	                       SizeType volumeOfNk,
+	                       SizeType colOffset = 0) const
 	{
 		SizeType total = psiSrc.effectiveSize(i0src);
 		SizeType offset = psiSrc.offset(i0src);
@@ -250,7 +441,7 @@ private:
 			SizeType ip2 = 0;
 			SizeType kp = 0;
 			packLeft.unpack(ip2, kp, dmrgWaveStruct_.lrs.left().permutation(alpha));
-			psi[kp](ip2, jp2) += psiSrc.fastAccess(i0src, x);
+			psi[kp](ip2, jp2 + colOffset) += psiSrc.fastAccess(i0src, x);
 		}
 	}
 
@@ -258,9 +449,10 @@ private:
 	                    SizeType i0,
 	                    const VectorMatrixType& result,
 	                    const LeftRightSuperType& lrs,
-	                    SizeType volumeOfNk) const
+	                    SizeType volumeOfNk,
+	                    SizeType colOffset = 0) const
 	{
-		SizeType nip = lrs.super().permutationInverse().size()/
+		SizeType nip = lrs.super().size()/
 		        lrs.right().permutationInverse().size();
 		PackIndicesType pack1(nip);
 		PackIndicesType pack2(volumeOfNk);
@@ -274,14 +466,15 @@ private:
 			SizeType kp = 0;
 			SizeType jp = 0;
 			pack2.unpack(kp, jp, lrs.right().permutation(beta));
-			psiDest.fastAccess(i0, x) += result[kp](ip, jp);
+			psiDest.fastAccess(i0, x) += result[kp](ip, jp + colOffset);
 		}
 	}
 
 	void systemPreparePsi(VectorMatrixType& psi,
 	                      const VectorWithOffsetType& psiSrc,
 	                      SizeType i0src,
-	                      SizeType volumeOfNk) const
+	                      SizeType volumeOfNk,
+	                      SizeType colOffset = 0) const
 	{
 		SizeType total = psiSrc.effectiveSize(i0src);
 		SizeType offset = psiSrc.offset(i0src);
@@ -295,7 +488,7 @@ private:
 			SizeType jpl = 0;
 			SizeType jpr = 0;
 			packRight.unpack(jpl, jpr, dmrgWaveStruct_.lrs.right().permutation(jp));
-			psi[jpl](ip, jpr) = psiSrc.fastAccess(i0src, y);
+			psi[jpl](ip, jpr + colOffset) = psiSrc.fastAccess(i0src, y);
 		}
 	}
 
@@ -303,7 +496,8 @@ private:
 	                   SizeType i0,
 	                   const VectorMatrixType& result,
 	                   const LeftRightSuperType& lrs,
-	                   SizeType volumeOfNk) const
+	                   SizeType volumeOfNk,
+	                   SizeType colOffset = 0) const
 	{
 		SizeType nip = lrs.left().permutationInverse().size()/volumeOfNk;
 		SizeType nalpha = lrs.left().permutationInverse().size();
@@ -319,7 +513,7 @@ private:
 			SizeType is = 0;
 			SizeType jpl = 0;
 			pack2.unpack(is, jpl, lrs.left().permutation(isn));
-			psiDest.fastAccess(i0, x) += result[jpl](is, jen);
+			psiDest.fastAccess(i0, x) += result[jpl](is, jen + colOffset);
 		}
 	}
 
@@ -78,7 +78,7 @@ public:
 	                         const VectorSizeType& nk) const
 	{
 		SizeType volumeOfNk = DmrgWaveStructType::volumeOf(nk);
-		SizeType nip = lrs.super().permutationInverse().size()/
+		SizeType nip = lrs.super().size()/
 		        lrs.right().permutationInverse().size();
 
 		SizeType nip2 = dmrgWaveStruct_.lrs.left().size()/volumeOfNk;
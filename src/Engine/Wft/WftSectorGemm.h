@@ -0,0 +1,371 @@
+#ifndef WFTSECTORGEMM_H
+#define WFTSECTORGEMM_H
+#include "Matrix.h"
+#include "BLAS.h"
+#include "ProgramGlobals.h"
+#include "Concurrency.h"
+#include "Parallelizer.h"
+
+namespace Dmrg {
+
+/* Two-site WFT as dense products per pair of symmetry sectors
+
+   For each index k of the site being moved, the source vector is
+   reshaped into a matrix Src_k, and the destination is
+   Dest_k = L * Src_k * R, where
+   ENVIRON: L = ws,   R = conj(we), k = kp
+   SYSTEM:  L = ws^H, R = we^T,     k = jpl
+   L or R are the identity when the corresponding block is not larger
+   than one site, as in WftSparseTwoSite.
+
+   L and R are block diagonal, one block per symmetry sector, so only
+   the (k, left block, right block) triples present in the source sector
+   are computed; each one is two GEMMs, and the triples are done in parallel.
+*/
+template<typename WaveFunctionTransfBaseType>
+class WftSectorGemm {
+
+	typedef typename WaveFunctionTransfBaseType::DmrgWaveStructType DmrgWaveStructType;
+	typedef typename WaveFunctionTransfBaseType::VectorWithOffsetType VectorWithOffsetType;
+	typedef typename WaveFunctionTransfBaseType::VectorSizeType VectorSizeType;
+	typedef typename DmrgWaveStructType::LeftRightSuperType LeftRightSuperType;
+	typedef typename DmrgWaveStructType::BasisWithOperatorsType BasisWithOperatorsType;
+	typedef typename DmrgWaveStructType::BlockDiagonalMatrixType BlockDiagonalMatrixType;
+	typedef typename VectorWithOffsetType::VectorType VectorType;
+	typedef typename VectorType::value_type ComplexOrRealType;
+	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
+	typedef typename PsimagLite::Vector<MatrixType>::Type VectorMatrixType;
+	typedef typename WaveFunctionTransfBaseType::PackIndicesType PackIndicesType;
+	typedef PsimagLite::Vector<int>::Type VectorIntType;
+
+	// One dense block of L or R, at (row, col) of the full matrix
+	struct DenseBlock {
+
+		DenseBlock() : row(0), col(0) {}
+
+		SizeType row;
+		SizeType col;
+		MatrixType m;
+	};
+
+	typedef typename PsimagLite::Vector<DenseBlock>::Type VectorDenseBlockType;
+
+	struct Task {
+
+		Task(SizeType k_, SizeType a_, SizeType b_) : k(k_), a(a_), b(b_) {}
+
+		SizeType k;
+		SizeType a;
+		SizeType b;
+	};
+
+	typedef typename PsimagLite::Vector<Task>::Type VectorTaskType;
+
+	class ParallelSectorGemm {
+
+	public:
+
+		ParallelSectorGemm(VectorMatrixType& result,
+		                   const VectorMatrixType& psi,
+		                   const VectorTaskType& tasks,
+		                   const VectorDenseBlockType& left,
+		                   const VectorDenseBlockType& right)
+		    : result_(result),
+		      psi_(psi),
+		      tasks_(tasks),
+		      left_(left),
+		      right_(right)
+		{}
+
+		SizeType tasks() const { return tasks_.size(); }
+
+		void doTask(SizeType t, SizeType)
+		{
+			const MatrixType& l = left_[tasks_[t].a].m;
+			const MatrixType& r = right_[tasks_[t].b].m;
+			const MatrixType& psi = psi_[t];
+			assert(l.cols() == psi.rows() && psi.cols() == r.rows());
+
+			MatrixType tmp(l.rows(), psi.cols());
+			psimag::BLAS::GEMM('N',
+			                   'N',
+			                   l.rows(),
+			                   psi.cols(),
+			                   l.cols(),
+			                   1.0,
+			                   &(l(0,0)),
+			                   l.rows(),
+			                   &(psi(0,0)),
+			                   psi.rows(),
+			                   0.0,
+			                   &(tmp(0,0)),
+			                   l.rows());
+
+			result_[t].resize(l.rows(), r.cols());
+			psimag::BLAS::GEMM('N',
+			                   'N',
+			                   l.rows(),
+			                   r.cols(),
+			                   r.rows(),
+			                   1.0,
+			                   &(tmp(0,0)),
+			                   l.rows(),
+			                   &(r(0,0)),
+			                   r.rows(),
+			                   0.0,
+			                   &((result_[t])(0,0)),
+			                   l.rows());
+		}
+
+	private:
+
+		VectorMatrixType& result_;
+		const VectorMatrixType& psi_;
+		const VectorTaskType& tasks_;
+		const VectorDenseBlockType& left_;
+		const VectorDenseBlockType& right_;
+	};
+
+public:
+
+	WftSectorGemm(const DmrgWaveStructType& dmrgWaveStruct,
+	              const LeftRightSuperType& lrs,
+	              const VectorSizeType& nk,
+	              SizeType sysOrEnv)
+	    : dmrgWaveStruct_(dmrgWaveStruct),
+	      lrs_(lrs),
+	      volumeOfNk_(DmrgWaveStructType::volumeOf(nk)),
+	      sysOrEnv_(sysOrEnv)
+	{
+		assert(sysOrEnv == ProgramGlobals::SYSTEM || sysOrEnv == ProgramGlobals::ENVIRON);
+
+		const BasisWithOperatorsType& oldLeft = dmrgWaveStruct_.lrs.left();
+		const BasisWithOperatorsType& oldRight = dmrgWaveStruct_.lrs.right();
+
+		if (sysOrEnv == ProgramGlobals::ENVIRON) {
+			srcRows_ = oldLeft.size()/volumeOfNk_;
+			srcCols_ = oldRight.size();
+			destRows_ = lrs.left().size();
+			destCols_ = lrs.right().size()/volumeOfNk_;
+			if (srcRows_ > volumeOfNk_)
+				setBlocks(left_, dmrgWaveStruct_.ws, 'N');
+			else
+				setIdentity(left_, std::min(std::min(srcRows_, destRows_),
+				                            dmrgWaveStruct_.ws.cols()));
+
+			setBlocks(right_, dmrgWaveStruct_.we, 'C');
+		} else {
+			srcRows_ = oldLeft.size();
+			srcCols_ = oldRight.size()/volumeOfNk_;
+			destRows_ = lrs.left().size()/volumeOfNk_;
+			destCols_ = lrs.right().size();
+			setBlocks(left_, dmrgWaveStruct_.ws, 'H');
+			if (srcCols_ > volumeOfNk_)
+				setBlocks(right_, dmrgWaveStruct_.we, 'T');
+			else
+				setIdentity(right_, std::min(std::min(srcCols_, destCols_),
+				                             dmrgWaveStruct_.we.cols()));
+		}
+
+		valid_ = setMaps();
+	}
+
+	// False if the transforms don't match the bases;
+	// the caller must then use WftSparseTwoSite instead
+	bool isValid() const { return valid_; }
+
+	void transform(const VectorWithOffsetType& psiSrc, SizeType iOld)
+	{
+		assert(valid_);
+		tasks_.clear();
+		psi_.clear();
+		result_.clear();
+		taskOf_.assign(volumeOfNk_*left_.size()*right_.size(), -1);
+
+		preparePsi(psiSrc, iOld);
+
+		if (tasks_.size() == 0) return;
+
+		result_.resize(tasks_.size());
+		SizeType threads = std::min(tasks_.size(), PsimagLite::Concurrency::npthreads);
+		typedef PsimagLite::Parallelizer<ParallelSectorGemm> ParallelizerType;
+		ParallelizerType threadedWft(threads, PsimagLite::MPI::COMM_WORLD);
+
+		ParallelSectorGemm helperWft(result_, psi_, tasks_, left_, right_);
+
+		threadedWft.loopCreate(helperWft);
+	}
+
+	// Adds the last transformed vector to sector i0 of psiDest
+	void copyOut(VectorWithOffsetType& psiDest, SizeType i0) const
+	{
+		if (tasks_.size() == 0) return;
+
+		SizeType total = psiDest.effectiveSize(i0);
+		SizeType start = psiDest.offset(i0);
+		bool isSystem = (sysOrEnv_ == ProgramGlobals::SYSTEM);
+		SizeType nalpha = lrs_.left().permutationInverse().size();
+		PackIndicesType pack1(isSystem ? nalpha : lrs_.left().size());
+		PackIndicesType pack2(isSystem ? nalpha/volumeOfNk_ : volumeOfNk_);
+
+		for (SizeType x = 0; x < total; ++x) {
+			SizeType i = 0;
+			SizeType j = 0;
+			SizeType k = 0;
+			if (isSystem) {
+				SizeType isn = 0;
+				pack1.unpack(isn, j, lrs_.super().permutation(x + start));
+				pack2.unpack(i, k, lrs_.left().permutation(isn));
+			} else {
+				SizeType beta = 0;
+				pack1.unpack(i, beta, lrs_.super().permutation(x + start));
+				pack2.unpack(k, j, lrs_.right().permutation(beta));
+			}
+
+			int a = leftOfRow_[i];
+			int b = rightOfCol_[j];
+			if (a < 0 || b < 0) continue;
+			int t = taskOf_[k + (a + b*left_.size())*volumeOfNk_];
+			if (t < 0) continue;
+			psiDest.fastAccess(i0, x) += result_[t](i - left_[a].row, j - right_[b].col);
+		}
+	}
+
+private:
+
+	void preparePsi(const VectorWithOffsetType& psiSrc, SizeType iOld)
+	{
+		SizeType total = psiSrc.effectiveSize(iOld);
+		SizeType offset = psiSrc.offset(iOld);
+		bool isSystem = (sysOrEnv_ == ProgramGlobals::SYSTEM);
+		SizeType oldLeftSize = dmrgWaveStruct_.lrs.left().size();
+		PackIndicesType packSuper(oldLeftSize);
+		PackIndicesType pack2(isSystem ? volumeOfNk_ : oldLeftSize/volumeOfNk_);
+
+		for (SizeType y = 0; y < total; ++y) {
+			const ComplexOrRealType& value = psiSrc.fastAccess(iOld, y);
+			SizeType i = 0;
+			SizeType j = 0;
+			SizeType k = 0;
+			SizeType tmp = 0;
+			if (isSystem) {
+				packSuper.unpack(i, tmp, dmrgWaveStruct_.lrs.super().permutation(y + offset));
+				pack2.unpack(k, j, dmrgWaveStruct_.lrs.right().permutation(tmp));
+			} else {
+				packSuper.unpack(tmp, j, dmrgWaveStruct_.lrs.super().permutation(y + offset));
+				pack2.unpack(i, k, dmrgWaveStruct_.lrs.left().permutation(tmp));
+			}
+
+			int a = leftOfCol_[i];
+			int b = rightOfRow_[j];
+			if (a < 0 || b < 0) continue;
+			SizeType index = k + (a + b*left_.size())*volumeOfNk_;
+			if (taskOf_[index] < 0) {
+				taskOf_[index] = tasks_.size();
+				tasks_.push_back(Task(k, a, b));
+				MatrixType m(left_[a].m.cols(), right_[b].m.rows());
+				m.setTo(0.0);
+				psi_.push_back(m);
+			}
+
+			psi_[taskOf_[index]](i - left_[a].col, j - right_[b].row) += value;
+		}
+	}
+
+	// what is 'N' (as is), 'C' (conjugate), 'T' (transpose) or
+	// 'H' (conjugate transpose), applied block by block
+	static void setBlocks(VectorDenseBlockType& blocks,
+	                      const BlockDiagonalMatrixType& m,
+	                      char what)
+	{
+		bool transposed = (what == 'T' || what == 'H');
+		bool conjugated = (what == 'C' || what == 'H');
+		for (SizeType ind = 0; ind < m.blocks(); ++ind) {
+			const MatrixType& mblock = m(ind);
+			SizeType rows = mblock.rows();
+			SizeType cols = mblock.cols();
+			if (rows == 0 || cols == 0) continue;
+
+			DenseBlock block;
+			block.row = (transposed) ? m.offsetsCols(ind) : m.offsetsRows(ind);
+			block.col = (transposed) ? m.offsetsRows(ind) : m.offsetsCols(ind);
+			block.m.resize((transposed) ? cols : rows, (transposed) ? rows : cols);
+			for (SizeType i = 0; i < rows; ++i) {
+				for (SizeType j = 0; j < cols; ++j) {
+					ComplexOrRealType val = (conjugated) ? PsimagLite::conj(mblock(i, j))
+					                                     : mblock(i, j);
+					if (transposed)
+						block.m(j, i) = val;
+					else
+						block.m(i, j) = val;
+				}
+			}
+
+			blocks.push_back(block);
+		}
+	}
+
+	static void setIdentity(VectorDenseBlockType& blocks, SizeType n)
+	{
+		if (n == 0) return;
+		DenseBlock block;
+		block.m.resize(n, n);
+		block.m.setTo(0.0);
+		for (SizeType i = 0; i < n; ++i)
+			block.m(i, i) = 1.0;
+
+		blocks.push_back(block);
+	}
+
+	// Index of the block of each row and column of L and R, -1 if none
+	bool setMaps()
+	{
+		leftOfRow_.assign(destRows_, -1);
+		leftOfCol_.assign(srcRows_, -1);
+		for (SizeType a = 0; a < left_.size(); ++a) {
+			const DenseBlock& block = left_[a];
+			if (block.row + block.m.rows() > destRows_) return false;
+			if (block.col + block.m.cols() > srcRows_) return false;
+			for (SizeType i = 0; i < block.m.rows(); ++i)
+				leftOfRow_[block.row + i] = a;
+			for (SizeType i = 0; i < block.m.cols(); ++i)
+				leftOfCol_[block.col + i] = a;
+		}
+
+		rightOfRow_.assign(srcCols_, -1);
+		rightOfCol_.assign(destCols_, -1);
+		for (SizeType b = 0; b < right_.size(); ++b) {
+			const DenseBlock& block = right_[b];
+			if (block.row + block.m.rows() > srcCols_) return false;
+			if (block.col + block.m.cols() > destCols_) return false;
+			for (SizeType i = 0; i < block.m.rows(); ++i)
+				rightOfRow_[block.row + i] = b;
+			for (SizeType i = 0; i < block.m.cols(); ++i)
+				rightOfCol_[block.col + i] = b;
+		}
+
+		return true;
+	}
+
+	const DmrgWaveStructType& dmrgWaveStruct_;
+	const LeftRightSuperType& lrs_;
+	SizeType volumeOfNk_;
+	SizeType sysOrEnv_;
+	SizeType srcRows_;
+	SizeType srcCols_;
+	SizeType destRows_;
+	SizeType destCols_;
+	bool valid_;
+	VectorDenseBlockType left_;
+	VectorDenseBlockType right_;
+	VectorIntType leftOfRow_;
+	VectorIntType leftOfCol_;
+	VectorIntType rightOfRow_;
+	VectorIntType rightOfCol_;
+	VectorIntType taskOf_;
+	VectorTaskType tasks_;
+	VectorMatrixType psi_;
+	VectorMatrixType result_;
+};
+}
+#endif // WFTSECTORGEMM_H
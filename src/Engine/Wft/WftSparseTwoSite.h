@@ -46,7 +46,7 @@ public:
 	      we_(we),
 	      volumeOfNk_(DmrgWaveStructType::volumeOf(nk)),
 	      pack1_((sysOrEnv == ProgramGlobals::SYSTEM) ? lrs.left().permutationInverse().size() :
-	                                                    lrs.super().permutationInverse().size()/
+	                                                    lrs.super().size()/
 	                                                    lrs.right().permutationInverse().size()),
 	      pack2_((sysOrEnv == ProgramGlobals::SYSTEM) ?  lrs.left().permutationInverse().size()/
 	                                                     volumeOfNk_ : volumeOfNk_),
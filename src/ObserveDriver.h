@@ -29,6 +29,7 @@
 #include "ModelSelector.h"
 #include "ArchiveFiles.h"
 #include "CvectorSize.h"
+#include "ObserveDataFile.h"
 
 namespace Dmrg {
 
@@ -54,7 +55,8 @@ bool observeOneFullSweep(IoInputType& io,
                          const ModelType& model,
                          const PsimagLite::String& list,
                          bool hasTimeEvolution,
-                         SizeType orbitals);
+                         SizeType orbitals,
+                         ObserveDataFile::In* dataFile);
 }
 
 #endif // OBSERVEDRIVER_H
@@ -10,7 +10,8 @@ bool observeOneFullSweep(IoInputType& io,
                          const ModelType& model,
                          const PsimagLite::String& list,
                          bool hasTimeEvolution,
-                         SizeType orbitals)
+                         SizeType orbitals,
+                         ObserveDataFile::In* dataFile)
 {
 	typedef typename ModelType::GeometryType GeometryType;
 	typedef Observer<VectorWithOffsetType,ModelType,IoInputType> ObserverType;
@@ -73,7 +74,10 @@ bool observeOneFullSweep(IoInputType& io,
 	                                  model,
 	                                  nf,
 	                                  trail,
-	                                  verbose);
+	                                  verbose,
+	                                  dataFile);
+
+	observerLib.prepareTwoPoint(vecOptions,rows,cols,orbitals);
 
 	for (SizeType i = 0; i < vecOptions.size(); ++i) {
 		PsimagLite::String item = vecOptions[i];
@@ -33,17 +33,20 @@ template bool observeOneFullSweep<VectorWithOffset2Type,ModelBase5Type>(IoInputT
 const ModelBase5Type& model,
 const PsimagLite::String& list,
 bool hasTimeEvolution,
-SizeType orbitals);
+SizeType orbitals,
+ObserveDataFile::In* dataFile);
 
 template bool observeOneFullSweep<VectorWithOffset4Type,ModelBase5Type>(IoInputType& io,
 const ModelBase5Type& model,
 const PsimagLite::String& list,
 bool hasTimeEvolution,
-SizeType orbitals);
+SizeType orbitals,
+ObserveDataFile::In* dataFile);
 
 template bool observeOneFullSweep<VectorWithOffset4Type,ModelBase6Type>(IoInputType& io,
 const ModelBase6Type& model,
 const PsimagLite::String& list,
 bool hasTimeEvolution,
-SizeType orbitals);
+SizeType orbitals,
+ObserveDataFile::In* dataFile);
 }
@@ -99,5 +99,8 @@ const PsimagLite::String ProgramGlobals::license=
 PsimagLite::String ProgramGlobals::WFT_STRING = "Wft";
 PsimagLite::String ProgramGlobals::SYSTEM_STACK_STRING = "SystemStack";
 PsimagLite::String ProgramGlobals::ENVIRON_STACK_STRING = "EnvironStack";
+PsimagLite::String ProgramGlobals::OBSERVE_DATA_STRING = "ObserveData";
+PsimagLite::String ProgramGlobals::IN_SITU_STRING = "InSitu";
+PsimagLite::String ProgramGlobals::STRUCTURE_FACTOR_STRING = "StructureFactor";
 } // namespace Dmrg
 
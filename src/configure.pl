@@ -86,6 +86,13 @@ sub createMakefile
 	my %args;
 	$args{"CPPFLAGS"} = $lto;
 	$args{"LDFLAGS"} = $lto;
+	if (hasZlib()) {
+		# compressedStacks then uses zlib
+		$args{"CPPFLAGS"} .= " -DUSE_ZLIB";
+		$args{"LDFLAGS"} .= " -lz";
+		print STDERR "$0: zlib found, compiling with USE_ZLIB\n";
+	}
+
 	Make::createConfigMake($flavor, \%args);
 
 	my $fh;
@@ -118,6 +125,20 @@ EOF
 	print STDERR "$0: File Makefile has been written\n";
 }
 
+sub hasZlib
+{
+	return 0 if (defined($ENV{"DMRGPP_NO_ZLIB"}));
+	my $cxx = (defined($ENV{"CXX"})) ? $ENV{"CXX"} : "g++";
+	my $test = "zlibTest$$";
+	my $fh;
+	open($fh, ">", "$test.cpp") or return 0;
+	print $fh "#include <zlib.h>\nint main() { return (zlibVersion() == 0); }\n";
+	close($fh);
+	my $ret = system("$cxx $test.cpp -o $test -lz > /dev/null 2>&1");
+	unlink("$test.cpp", $test);
+	return ($ret == 0);
+}
+
 sub procFlavor
 {
 	my ($flavor) = @_;
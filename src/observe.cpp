@@ -1,4 +1,5 @@
 #include "ObserveDriver.h"
+#include <cstdio>
 
 using namespace Dmrg;
 
@@ -31,16 +32,52 @@ void mainLoop(GeometryType& geometry,
 	bool hasTimeEvolution = (targetting != "GroundStateTargetting" &&
 	        targetting != "CorrectionTargetting");
 
+	ObserveDataFile::In* dataFile = 0;
+	if (params.options.find("binaryObserveData") != PsimagLite::String::npos) {
+		typedef typename ModelHelperType::LeftRightSuperType LeftRightSuperType;
+		typedef DmrgSerializer<LeftRightSuperType,VectorWithOffsetType> DmrgSerializerType;
+
+		PsimagLite::String file = utils::pathPrepend(ProgramGlobals::OBSERVE_DATA_STRING,
+		                                             datafile);
+		// every rank opens the file, but only the root converts it
+		bool convert = PsimagLite::Concurrency::root();
+		if (convert && !ObserveDataFile::isUpToDate(file, datafile)) {
+			// renamed only when complete, so that a failed conversion is
+			// not reused by later runs
+			PsimagLite::String tmpFile = file + ".tmp";
+			SizeType n = 0;
+			{
+				IoInputType textIo(datafile);
+				ObserveDataFile::Out out(tmpFile);
+				n = ObserveDataFile::convert<DmrgSerializerType>(textIo,
+				                                                 out,
+				                                                 geometry.numberOfSites());
+			}
+
+			if (rename(tmpFile.c_str(), file.c_str()) != 0)
+				err("observe: cannot rename " + tmpFile + " to " + file + "\n");
+
+			std::cerr<<"observe: converted "<<n<<" records of "<<datafile;
+			std::cerr<<" into "<<file<<"\n";
+		}
+
+		PsimagLite::MPI::barrier(PsimagLite::MPI::COMM_WORLD);
+
+		dataFile = new ObserveDataFile::In(file);
+	}
+
 	while (moreData) {
 		try {
 			moreData = !observeOneFullSweep<VectorWithOffsetType,ModelBaseType>
-			        (dataIo,model,list,hasTimeEvolution,orbitals);
+			        (dataIo,model,list,hasTimeEvolution,orbitals,dataFile);
 		} catch (std::exception& e) {
 			std::cerr<<"CAUGHT: "<<e.what();
 			std::cerr<<"There's no more data\n";
 			break;
 		}
 	}
+
+	delete dataFile;
 }
 
 template<typename GeometryType,